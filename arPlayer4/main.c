@@ -34,6 +34,7 @@
 #include <jack/ringbuffer.h>
 #include <pthread.h>
 #include <arpa/inet.h>
+#include "../common/ctlqueue.h"
 
 // cType (control packet) real-time flagged packets are handled directly
 // in the jack process function.  Others are queued for handing in a 
@@ -68,19 +69,7 @@ typedef union {
 	int8_t			cVal[4];
 } valuetype;
 
-typedef struct __attribute__((packed)){
-						/* Structure of contol packet: used to control/communicate with recorders and players
-						 * NOTE: packets passed as midi data via jackaudio midi API, even though the data format
-						 * is not midi.  Jack is fine with this, but don't try to connect the arserver control midi
-						 * ports to other applications that are expecting actual midi data. */
-	uint8_t			sysExFlag;
-	uint8_t			topBits;
-	uint8_t			type;
-	uint32_t			peer;			// network byte order - player input number [0,N] or recorder UID.
-	uint16_t			dataSize;	// network byte order - size, in bytes, of the data, if any.
-	int8_t			data[1];		// network byte order or text.  Text need NOT to be null terminated
-										// due to the size (length) specified above.
-}controlPacket;
+/* controlPacket and its codec: see ../common/ctlcodec.h */
 
 /* Structure to contain all our information, so we can pass it around */
 typedef struct _CustomData {
@@ -96,8 +85,10 @@ typedef struct _CustomData {
 	jack_port_t **audioOut_jPorts;	// pointer to chCount array of jack ports
 	jack_port_t *midiIn_jPort;		// midi in control 
 	jack_port_t *midiOut_jPort;	// midi out status/time
+	ctlShm *shm;					// shared memory control channel, in place of the midi ports, if arServer passed one
 	jack_ringbuffer_t *ringbuffer;
 	jack_ringbuffer_t *ctlqueue;
+	ctlQueueStats ctlStats;		// ctlqueue depth and high water, written by jack_process
 	jack_default_audio_sample_t **jbufs; // pointer to chCount array of jack ports data buffers
 	gboolean endFlag;
 	gboolean playing;			/* Are we in the PLAYING state? */
@@ -154,114 +145,60 @@ char *str_NthField(const char *string, const char *token, unsigned int field){
 	return result;
 }
 
-uint16_t controlDataSizeFromRaw(uint16_t byteCount){
-	// calculated a new byte size required to hold the data and additional bytes 
-	// for required encoding to pass as midi data where MSbit is always zero.
-	if(byteCount)
-		byteCount += ((byteCount - 1) / 7) + 1;
-	return byteCount;
+void jack_shutdown_callback(void *arg){
+	CustomData *data = (CustomData *)arg;
+	/* Jack server went away... shutdown. */
+	data->client = NULL;
+	data->terminate = TRUE;
 }
 
-char *encodeControlData(char *data, uint16_t *size, char *extraPtr){
-	// size on entry is size of data in bytes.  On return, the size of additional bytes encoded.
-	// Result is additional data bytes needed to 7 bit rncode 8 bit data. if result is not null, the memory must be freed.
-	// If extraPtr is not NULL on entry, no axtra bytes are allocated or returned, and the extar data is writen to this pointer.
-	if(!size || (*size == 0))
-		return NULL;
-	uint16_t newSize = controlDataSizeFromRaw(*size) - *size + 1; // extra byte is for the 0xF7 MIDI SysEx end flag
-	char *newData = NULL;
-	if(!extraPtr)
-		extraPtr = newData = (char *)calloc(1, newSize);
-	char *extra = extraPtr;
-	uint16_t rem = *size;
-	uint16_t bit = 0;
-	char *byte = data;
-	*extra = 0;
-	while(rem){
-		if(bit >= 7){
-			bit = 0;
-			extra++;
-			*extra = 0;
-		}
-		if(*byte & 0x80){
-			*byte = *byte & 0x7F; 	// clear top bit
-			*extra = *extra | (1 << bit);	// set corrisponding bit in current extra byte
-		}
-		bit++;
-		byte++;
-		rem--;
-	}
-	extra++;
-	*extra = 0xF7;
-	*size = newSize;
-	return newData;
+static inline unsigned char controlForUs(CustomData *data, controlPacket *header){
+	return ((header->type & cPeer_MASK) == cPeer_player) && (header->peer == htonl(data->ctlID));
 }
 
-void decodeControlData(char *data, uint16_t origSize){
-	// *data must point to origSize bytes plus extra bytes at the end needed for endoding. See controlDataSizeFromRaw()
-	uint16_t rem = origSize;
-	uint16_t bit = 0;
-	char *byte = data;
-	char *extra = data + origSize; // top bit clusters added at end of raw array
-	while(rem){
-		if(*extra & (1 << bit))
-			*byte = *byte | 0x80; 	// set top bit
-		bit++;
-		byte++;
-		rem--;
-		if(bit >= 7){
-			bit = 0;
-			extra++;
+/* handle a control packet from arServer, received time frames into this 
+ * process cycle, by midi or shared memory.  The packet is decoded, with 
+ * network byte order values.  Returns TRUE if the change request thread 
+ * needs waking. */
+static char controlRequest(CustomData *data, controlPacket *packet, jack_nframes_t time){
+	char change_flag = FALSE;
+	
+	if(controlForUs(data, packet)){
+		char type = packet->type & cType_MASK;
+		size_t cnt = ntohs(packet->dataSize);
+		if(type == cType_posack){
+			/* handle realtime pos change ack packet */
+			data->posUpdate = FALSE;
 		}
-	}
-}
-
-unsigned char decodeControlPacket(controlPacket *packet, char headerOnly){
-	if(packet->sysExFlag == 0xF0){
-		// must start with MIDI SysEx flag
-		char *byte = (char *)(&packet->type);
-		char topBits = packet->topBits;
-		for(char b=0; b < 7; b++){
-			if(topBits & (1 << b))
-				*byte = *byte | 0x80; 	// set top bit
-			byte++;
+		if(type == cType_start){
+			/* handle realtime control play packet */
+			data->playReq = TRUE;
+			change_flag = TRUE;
 		}
-		if(!headerOnly && packet->dataSize)
-			decodeControlData(packet->data, ntohs(packet->dataSize));
-		return 1;
-	}
-	return 0; // bad packet format
-}
-
-char *encodeControlPacket(controlPacket *header, char *data, uint16_t *size, char *extraPtr){
-	// size on entry is size of data in bytes.  On return, the size of additionall bytes returned.
-	// Result is additional bytes needed to 7 bit rncode 8 bit data. if result is not null, the memory must be freed.
-	// if extraPtr is not NULL, extra data will be stored in this location, and result will be NULL (No new memory 
-	// allocated needing to be freed)  NOTE: extraPtr must point to enouch memory to store the extra data.
-	char *result = NULL;
-	int8_t *byte = header->data;
-	header->topBits = 0;
-	header->sysExFlag = 0xF0;	// MIDI SysEx start flag
-	if(size && *size)
-		result = encodeControlData(data, size, extraPtr);
-	else
-		*header->data = 0xF7;	// MIDI SysEx end flag
-	byte = (char *)(&header->type);
-	for(char b=0; b < 7; b++){
-		if(*byte & 0x80){
-			*byte = *byte & 0x7F; 	// clear top bit
-			header->topBits = header->topBits | (1 << b);	// set corrisponding bit in corrisponding topBits byte
+		if(type == cType_stop){
+			/* handle realtime control pause packet */
+			data->pauseReq = TRUE;
+			change_flag = TRUE;
+			data->endFlag = FALSE;
+		}
+		if((type == cType_pos) && (cnt == sizeof(valuetype))){
+			/* handle realtime control pos change packet */
+			double syncTime;
+			valuetype val;
+			memcpy(&val, packet->data, sizeof(valuetype));
+			val.iVal = ntohl(val.iVal);
+			syncTime = val.fVal;
+			syncTime = syncTime - (double)(time + 1) / (double)data->sampleRate;
+			/* syncTime is requested time in seconds adjusted for arrival time offset */
+			if(!data->posReq){
+				data->reqPos = syncTime;
+				data->posReq = TRUE;
+				change_flag = TRUE;
+				data->endFlag = FALSE;
+			}
 		}
-		byte++;
 	}
-	return result;
-}
-
-void jack_shutdown_callback(void *arg){
-	CustomData *data = (CustomData *)arg;
-	/* Jack server went away... shutdown. */
-	data->client = NULL;
-	data->terminate = TRUE;
+	return change_flag;
 }
 
 int jack_process(jack_nframes_t nframes, void *arg){
@@ -279,59 +216,66 @@ int jack_process(jack_nframes_t nframes, void *arg){
 	void* midi_buffer;
 	
 	/* handle received control packets */
-	midi_buffer = jack_port_get_buffer(data->midiIn_jPort, nframes);
-	event_count = jack_midi_get_event_count(midi_buffer);
 	char change_flag = FALSE;
-	for(i=0; i<event_count; i++){
-		jack_midi_event_get(&in_event, midi_buffer, i);
-		packet = (controlPacket *)in_event.buffer;
+	if(data->shm){
+		union{
+			controlPacket packet;
+			char buf[64];
+		} small;
+		ctlRing *ring = &data->shm->toPeer;
+		for(i=0; (i<ctl_drain_events) && (cnt = ctlshm_next(ring)); i++){
+			// all we take is small: anything else isn't for us
+			if(cnt <= sizeof(small)){
+				ctlshm_copy(ring, 0, &small, cnt);
+				if(controlRequest(data, &small.packet, 0))
+					change_flag = TRUE;
+			}
+			ctlshm_skip(ring, cnt);
+		}
+	}else{
+		midi_buffer = jack_port_get_buffer(data->midiIn_jPort, nframes);
+		event_count = jack_midi_get_event_count(midi_buffer);
+		for(i=0; i<event_count; i++){
+			jack_midi_event_get(&in_event, midi_buffer, i);
+			packet = (controlPacket *)in_event.buffer;
 //fprintf(stderr, "MidiIn=%lu\n", in_event.size);
-		if(in_event.size >= sizeof(controlPacket)){
-			header = *packet; // copy header portion, for header decoding
-			if(decodeControlPacket(&header, 1)){
-				uint32_t peer = htonl(data->ctlID);
-				if(((header.type & cPeer_MASK) == cPeer_player) && (header.peer == peer)){
-					char type = header.type & cType_MASK;
+			if(in_event.size >= sizeof(controlPacket)){
+				header = *packet; // copy header portion, for header decoding
+				if(decodeControlPacket(&header, 1) && controlForUs(data, &header)){
+					/* decode the whole packet in place only if it's ours and it has data */
 					cnt = ntohs(header.dataSize);
-					if(type == cType_posack){
-						/* handle realtime pos change ack packet */
-						data->posUpdate = FALSE;
-					}
-					if(type == cType_start){
-						/* handle realtime control play packet */
-						data->playReq = TRUE;
-						change_flag = TRUE;
-					}
-					if(type == cType_stop){
-						/* handle realtime control pause packet */
-						data->pauseReq = TRUE;
-						change_flag = TRUE;
-						data->endFlag = FALSE;
-					}
-					if((type == cType_pos) && (cnt == sizeof(valuetype))){
-						/* handle realtime control pos change packet */
+					if(!cnt)
+						packet = &header;
+					else if(in_event.size >= controlPacketSize(cnt))
 						decodeControlPacket(packet, 0);
-						double syncTime;
-						valuetype *val;
-						val = (valuetype *)packet->data;
-						val->iVal = ntohl(val->iVal);
-						syncTime = val->fVal;
-						syncTime = syncTime - (double)(in_event.time + 1) / (double)data->sampleRate;
-						/* syncTime is requested time in seconds adjusted for arrival time offset */
-						if(!data->posReq){
-							data->reqPos = syncTime;
-							data->posReq = TRUE;
-							change_flag = TRUE;
-							data->endFlag = FALSE;
-						}
-					}
+					else
+						packet = NULL;
+					if(packet && controlRequest(data, packet, in_event.time))
+						change_flag = TRUE;
 				}
 			}
 		}
 	}
 	
 	/* send any required control messages, if control port is connected */
-	if(data->connected > 1){
+	if((data->connected > 1) && data->shm){
+		ctlRing *ring = &data->shm->toServer;
+		if(data->endFlag){
+			/* send end of media message, until arServer sends a pause/stop back */
+			ctlshm_write(ring, cType_end | cPeer_player, data->ctlID, NULL, 0);
+		}
+		if(data->posUpdate){
+			if(data->seek_enabled){
+				/* send pos control for current position (at start of this process cycle) time */
+				valuetype val;
+				val.fVal = data->curPos;
+				val.iVal = htonl(val.iVal);
+				ctlshm_write(ring, cType_pos | cPeer_player, data->ctlID, &val, sizeof(valuetype));
+			}else
+				data->posUpdate = FALSE;
+		}
+		ctlqueue_drainShm(data->ctlqueue, ring, 0, 0, &data->ctlStats);
+	}else if(data->connected > 1){
 		midi_buffer = jack_port_get_buffer(data->midiOut_jPort, nframes);
 		jack_midi_clear_buffer(midi_buffer);
 		if(data->endFlag){
@@ -340,7 +284,7 @@ int jack_process(jack_nframes_t nframes, void *arg){
 				packet->type = cType_end | cPeer_player;
 				packet->peer = htonl(data->ctlID);
 				packet->dataSize = 0;
-				encodeControlPacket(packet, NULL, NULL, NULL); // size = 0, no additional bytes returned.
+				encodeControlPacket(packet, 0);
 				/* NOTE: we keep sending this message until we receive a 
 				 * pause/stop back from arServer, then we clear the endFlag */
 			}
@@ -349,34 +293,22 @@ int jack_process(jack_nframes_t nframes, void *arg){
 			if(data->seek_enabled){
 				/* send pos control for current position (at start of this process cycle) time */
 				valuetype *val;
-				uint16_t dataSize = controlDataSizeFromRaw(sizeof(valuetype));
-				if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, sizeof(controlPacket) + dataSize)){
+				if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, controlPacketSize(sizeof(valuetype)))){
 					packet->type = cType_pos | cPeer_player;
 					packet->peer = htonl(data->ctlID);
 					packet->dataSize = htons(sizeof(valuetype));
 					val = (valuetype *)packet->data;
 					val->fVal = data->curPos;
 					val->iVal = htonl(val->iVal);
-					dataSize = sizeof(valuetype);
-					encodeControlPacket(packet, (char*)val, &dataSize, (char*)val+dataSize); // extraPtr is set for inline use: no additional bytes returned.
+					encodeControlPacket(packet, sizeof(valuetype));
 				}
 			}else
 				data->posUpdate = FALSE;
 		}
 		
-		// Check control queue for non-realtime queued packets
-		// to be sent, upto one per process cycle
-		cnt = jack_ringbuffer_peek(data->ctlqueue, (char*)&header, sizeof(controlPacket));
-		if(cnt == sizeof(controlPacket)){
-			if(decodeControlPacket(&header, 1)){
-				cnt = sizeof(controlPacket) + controlDataSizeFromRaw(ntohs(header.dataSize));
-				if(jack_ringbuffer_read_space(data->ctlqueue) >= cnt){
-					if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, cnt)){
-						jack_ringbuffer_read(data->ctlqueue, (char*)packet, cnt);
-					}
-				}
-			}
-		}
+		// Send non-realtime queued packets from the control queue, 
+		// as many as the per cycle budget allows
+		ctlqueue_drain(data->ctlqueue, midi_buffer, 0, 0, 0, &data->ctlStats);
 	}
 	
 	sampsRead = 0;
@@ -585,7 +517,10 @@ void handle_message(CustomData *data, GstMessage *msg) {
 					unsigned char ctl_con = 0; 
 					char pname[256];
 					snprintf(pname, sizeof pname, "%s:ctlIn", data->argv[3]);
-					if(!jack_connect(data->client, jack_port_name(data->midiOut_jPort), pname)){
+					if(data->shm){
+						/* control goes by the shared memory channel arServer passed us: no midi to connect */
+						ctl_con = 1;
+					}else if(!jack_connect(data->client, jack_port_name(data->midiOut_jPort), pname)){
 						/* connect JACK midi in port */
 						snprintf(pname, sizeof pname, "%s:ctlOut", data->argv[3]);
 						if(!jack_connect(data->client, pname, jack_port_name(data->midiIn_jPort))){
@@ -641,24 +576,24 @@ void handle_message(CustomData *data, GstMessage *msg) {
 					data->lastTags = jstr;
 					if(data->playing) {
 						// only pass track tags that come in while we are playing
+						char buf[ctl_max_packet];
 						size_t len;
+						uint16_t size;
 						len = strlen(jstr);
-						uint16_t encSize = controlDataSizeFromRaw(len);
-						if((encSize <= (2048 - sizeof(controlPacket))) && (jack_ringbuffer_write_space(data->ctlqueue) >= (encSize + sizeof(controlPacket)))){
-							// enque packet in midi/control queue ring buffer
-							encSize = len;
+						if(data->shm){
+							// raw packet, header then text, for the shared memory channel: no size limit but the queue's
 							controlPacket header;
-							header.type = cPeer_player | cType_tags;
-							header.peer = htonl(data->ctlID);
-							header.dataSize = htons(len);
-							int8_t *extra = encodeControlPacket(&header, jstr, &encSize, NULL);
-							if(extra){
-								// don't send SysEx byte at header end.  This will be included in extra data
-								jack_ringbuffer_write(data->ctlqueue, (char*)&header, sizeof(controlPacket)-1); 
+							if((len <= 0xFFFF) && (jack_ringbuffer_write_space(data->ctlqueue) >= rawPacketSize(len))){
+								rawPacketHeader(&header, cPeer_player | cType_tags, data->ctlID, len);
+								jack_ringbuffer_write(data->ctlqueue, (char *)&header, offsetof(controlPacket, data));
 								jack_ringbuffer_write(data->ctlqueue, jstr, len);
-								jack_ringbuffer_write(data->ctlqueue, extra, encSize);
-								free(extra);
 							}
+						}else if(controlPacketSize(len) <= sizeof(buf)){
+							// encode a copy: lastTags must stay plain text for the compare above
+							size = makeControlPacket((controlPacket *)buf, cPeer_player | cType_tags, data->ctlID, jstr, len);
+							// enque packet in midi/control queue ring buffer
+							if(jack_ringbuffer_write_space(data->ctlqueue) >= size)
+								jack_ringbuffer_write(data->ctlqueue, buf, size);
 						}
 					}
 				}
@@ -724,6 +659,7 @@ void mainloop(char *argv[], char isPipeline){
 	mlock(&data, sizeof(CustomData));
 	data.argv = argv;
 	data.lastTags = NULL;
+	memset(&data.ctlStats, 0, sizeof(ctlQueueStats));
 	data.playing = FALSE;
 	data.terminate = FALSE;
 	data.seek_enabled = FALSE;
@@ -733,6 +669,7 @@ void mainloop(char *argv[], char isPipeline){
 	data.audioOut_jPorts = NULL;
 	data.midiIn_jPort = NULL;
 	data.midiOut_jPort = NULL;
+	data.shm = NULL;
 	data.ringbuffer = NULL;
 	data.ctlqueue = NULL;
 	data.jbufs = NULL;
@@ -826,12 +763,17 @@ void mainloop(char *argv[], char isPipeline){
 	}
 	mlock(data.audioOut_jPorts, data.chCount * sizeof(jack_port_t *));
 	mlock(data.jbufs, data.chCount * sizeof(jack_default_audio_sample_t *));
-	/* register midi in and out ports for attached player control */
-	data.midiOut_jPort = jack_port_register(data.client, "ctlOut", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
-	data.midiIn_jPort = jack_port_register(data.client, "ctlIn", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
-	if(!data.midiOut_jPort || !data.midiIn_jPort){
-		g_printerr("\nERROR: JACK midi ports allocation failed.\n");
-		goto finish;
+	/* attach to the shared memory control channel arServer passed us, if any, 
+	 * otherwise register midi in and out ports for attached player control */
+	if(data.shm = ctlshm_attach())
+		g_print("Control by shared memory channel.\n");
+	else{
+		data.midiOut_jPort = jack_port_register(data.client, "ctlOut", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+		data.midiIn_jPort = jack_port_register(data.client, "ctlIn", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+		if(!data.midiOut_jPort || !data.midiIn_jPort){
+			g_printerr("\nERROR: JACK midi ports allocation failed.\n");
+			goto finish;
+		}
 	}
 	
 	/* Configure appsink to match JACK pad properties */
@@ -925,6 +867,8 @@ finish:
 	data.terminate = TRUE;	// just incase we got here with it false.
 	if(data.lastTags)
 		free(data.lastTags);
+	g_print("\nControl queue: high water %u bytes, %u packets sent, %u cycles deferred\n", 
+			data.ctlStats.high, data.ctlStats.sent, data.ctlStats.deferred);
 	if(data.client){
 		jack_deactivate(data.client);
 		jack_client_close(data.client);
@@ -952,6 +896,7 @@ finish:
 		munlock(data.jbufs, data.chCount * sizeof(jack_default_audio_sample_t *));
 		free(data.jbufs);
 	}
+	ctlshm_free(data.shm);
 
 	pthread_mutex_destroy(&data.changedMutex);
 	pthread_cond_destroy(&data.changedSemaphore);
@@ -36,6 +36,7 @@
 #include <jack/ringbuffer.h>
 #include <pthread.h>
 #include <arpa/inet.h>
+#include "../common/ctlqueue.h"
 #include <signal.h>
 #include <unistd.h>
 
@@ -90,19 +91,7 @@ typedef union {
 	int8_t			cVal[4];
 } valuetype;
 
-typedef struct __attribute__((packed)){	
-						/* Structure of contol packet: used to control/communicate with recorders and players
-						 * NOTE: packets passed as midi data via jackaudio midi API, even though the data format
-						 * is not midi.  Jack is fine with this, but don't try to connect the arserver control midi
-						 * ports to other applications that are expecting actual midi data. */
-	uint8_t			sysExFlag;
-	uint8_t			topBits;
-	uint8_t			type;
-	uint32_t			peer;		// network byte order - player input number [0,N] or recorder UID.
-	uint16_t			dataSize;	// network byte order - size, in bytes, of the data, if any.
-	int8_t			data[1];	// network byte order or text.  Text need NOT to be null terminated
-									// due to the size (length) specified above.
-}controlPacket;
+/* controlPacket and its codec: see ../common/ctlcodec.h */
 
 typedef struct __attribute__((packed)){		/* data structures for each channel inside of vuInstance */
 	// values are saclar magnitude
@@ -170,6 +159,7 @@ typedef struct _CustomData {
 	jack_port_t *midiOut_jPort;	// midi out status/time
 	jack_ringbuffer_t *ringbuffer;
 	jack_ringbuffer_t *ctlsendqueue;
+	ctlQueueStats ctlStats;		// ctlsendqueue depth and high water, written by jack_process
 	jack_ringbuffer_t *ctlrecvqueue;
 	jack_default_audio_sample_t **jbufs; // pointer to chCount array of jack ports data buffers
 	gboolean settingsChanged;
@@ -471,109 +461,6 @@ void AddFPLEntryFromProgramLogStruct(FILE *fpl, double Offset, ProgramLogRecord
 	free(line);
 }
 
-uint16_t controlDataSizeFromRaw(uint16_t byteCount){
-	// calculated a new byte size required to hold the data and additional bytes 
-	// for required encoding to pass as midi data where MSbit is always zero.
-	if(byteCount)
-		byteCount += ((byteCount - 1) / 7) + 1;
-	return byteCount;
-}
-
-char *encodeControlData(char *data, uint16_t *size, char *extraPtr){
-	// size on entry is size of data in bytes.  On return, the size of additional bytes encoded.
-	// Result is additional data bytes needed to 7 bit rncode 8 bit data. if result is not null, the memory must be freed.
-	// If extraPtr is not NULL on entry, no axtra bytes are allocated or returned, and the extar data is writen to this pointer.
-	if(!size || (*size == 0))
-		return NULL;
-	uint16_t newSize = controlDataSizeFromRaw(*size) - *size + 1; // extra byte is for the 0xF7 MIDI SysEx end flag
-	char *newData = NULL;
-	if(!extraPtr)
-		extraPtr = newData = (char *)calloc(1, newSize);
-	char *extra = extraPtr;
-	uint16_t rem = *size;
-	uint16_t bit = 0;
-	char *byte = data;
-	*extra = 0;
-	while(rem){
-		if(bit >= 7){
-			bit = 0;
-			extra++;
-			*extra = 0;
-		}
-		if(*byte & 0x80){
-			*byte = *byte & 0x7F; 	// clear top bit
-			*extra = *extra | (1 << bit);	// set corrisponding bit in current extra byte
-		}
-		bit++;
-		byte++;
-		rem--;
-	}
-	extra++;
-	*extra = 0xF7;
-	*size = newSize;
-	return newData;
-}
-
-void decodeControlData(char *data, uint16_t origSize){
-	// *data must point to origSize bytes plus extra bytes at the end needed for endoding. See controlDataSizeFromRaw()
-	uint16_t rem = origSize;
-	uint16_t bit = 0;
-	char *byte = data;
-	char *extra = data + origSize; // top bit clusters added at end of raw array
-	while(rem){
-		if(*extra & (1 << bit))
-			*byte = *byte | 0x80; 	// set top bit
-		bit++;
-		byte++;
-		rem--;
-		if(bit >= 7){
-			bit = 0;
-			extra++;
-		}
-	}
-}
-
-unsigned char decodeControlPacket(controlPacket *packet, char headerOnly){
-	if(packet->sysExFlag == 0xF0){
-		// must start with MIDI SysEx flag
-		char *byte = (char *)(&packet->type);
-		char topBits = packet->topBits;
-		for(char b=0; b < 7; b++){
-			if(topBits & (1 << b))
-				*byte = *byte | 0x80; 	// set top bit
-			byte++;
-		}
-		if(!headerOnly && packet->dataSize)
-			decodeControlData(packet->data, ntohs(packet->dataSize));
-		return 1;
-	}
-	return 0; // bad packet format
-}
-
-char *encodeControlPacket(controlPacket *header, char *data, uint16_t *size, char *extraPtr){
-	// size on entry is size of data in bytes.  On return, the size of additional bytes returned.
-	// Result is additional bytes needed to 7 bit rncode 8 bit data. if result is not null, the memory must be freed.
-	// if extraPtr is not NULL, extra data will be stored in this location, and result will be NULL (No new memory 
-	// allocated needing to be freed)  NOTE: extraPtr must point to enouch memory to store the extra data.
-	char *result = NULL;
-	int8_t *byte = header->data;
-	header->topBits = 0;
-	header->sysExFlag = 0xF0;	// MIDI SysEx start flag: 0xF0
-	if(size && *size)
-		result = encodeControlData(data, size, extraPtr);
-	else
-		*header->data = 0xF7;	// MIDI SysEx end flag
-	byte = (char *)(&header->type);
-	for(char b=0; b < 7; b++){
-		if(*byte & 0x80){
-			*byte = *byte & 0x7F; 	// clear top bit
-			header->topBits = header->topBits | (1 << b);	// set corrisponding bit in corrisponding topBits byte
-		}
-		byte++;
-	}
-	return result;
-}
-
 void checkPortReconnect(CustomData *data, jack_port_id_t port_id){
 	jack_port_t **port;
 	jack_port_t *cport;
@@ -682,7 +569,7 @@ static int jack_process(jack_nframes_t nframes, void *arg){
 	jack_default_audio_sample_t *dest, *src;
 	jack_ringbuffer_data_t rbData[2];
 	jack_ringbuffer_data_t *rbdPtr;
-	size_t sampCnt, sampWrite, cnt;
+	size_t sampCnt, sampWrite, cnt, room;
 	jack_midi_event_t in_event;
 	jack_nframes_t event_count;
 	controlPacket *packet;
@@ -699,23 +586,21 @@ static int jack_process(jack_nframes_t nframes, void *arg){
 			packet->type = cType_end | cPeer_recorder;
 			packet->peer = htonl(data->UID);
 			packet->dataSize = 0;
-			encodeControlPacket(packet, NULL, NULL, NULL); // size = 0, no additional bytes returned.
+			encodeControlPacket(packet, 0);
 		}
 		data->eos = FALSE;
 	}
 	
-	// Check send queue for non-realtime queued packets
-	// to be sent, upto one per proc cycle: settings, VU, etc.
-	cnt = jack_ringbuffer_peek(data->ctlsendqueue, (char*)&header, sizeof(controlPacket));
-	if(cnt == sizeof(controlPacket)){
-		if(decodeControlPacket(&header, 1)){
-			cnt = sizeof(controlPacket) + controlDataSizeFromRaw(ntohs(header.dataSize));
-			if(jack_ringbuffer_read_space(data->ctlsendqueue) >= cnt){
-				if(packet = (controlPacket *)jack_midi_event_reserve(midi_bufferOut, 0, cnt)){
-					jack_ringbuffer_read(data->ctlsendqueue, (char*)packet, cnt);
-				}
-			}
-		}
+	// Send non-realtime queued packets from the send queue: settings, 
+	// etc.  As many as the per cycle budget allows, leaving room in the 
+	// port buffer for the VU packet at the end of the cycle.
+	room = jack_midi_max_event_size(midi_bufferOut);
+	cnt = controlPacketSize(data->chCount * sizeof(vuNData));
+	if(room > cnt){
+		room = room - cnt;
+		if(room > ctl_drain_bytes)
+			room = ctl_drain_bytes;
+		ctlqueue_drain(data->ctlsendqueue, midi_bufferOut, 0, room, 0, &data->ctlStats);
 	}
 	
 	/* handle received packets */
@@ -881,8 +766,7 @@ static int jack_process(jack_nframes_t nframes, void *arg){
 	if(data->vuSampleRem <= 0){
 		data->vuSampleRem = data->vuSampleRem + data->vuPeriod;
 		uint16_t dataSize = data->chCount * sizeof(vuNData);
-		cnt = controlDataSizeFromRaw(dataSize);
-		if(packet = (controlPacket *)jack_midi_event_reserve(midi_bufferOut, origFrames-1, cnt+sizeof(controlPacket))){
+		if(packet = (controlPacket *)jack_midi_event_reserve(midi_bufferOut, origFrames-1, controlPacketSize(dataSize))){
 			vuNData *values;
 			packet->type = cType_vu | cPeer_recorder;	
 			packet->peer = htonl(data->UID);
@@ -894,7 +778,7 @@ static int jack_process(jack_nframes_t nframes, void *arg){
 				values->peak = ftovu(vu->peak);
 				values++;
 			}
-			encodeControlPacket(packet, packet->data, &dataSize, (packet->data)+dataSize); // extraPtr is set for inline use: no additional bytes returned.
+			encodeControlPacket(packet, dataSize);
 		}
 	}
 	
@@ -1036,6 +920,7 @@ void* handleCtlQueues(void *refCon){
 	controlPacket *packet;
 	cJSON *obj, *ar, *item;
 	controlPacket header;
+	char buf[ctl_max_packet];
 	ProgramLogRecord logRec;
 
 
@@ -1046,22 +931,11 @@ void* handleCtlQueues(void *refCon){
 		if(data->settingsChanged){
 			jstr = settingsToControlPacketData(data);
 			len = strlen(jstr);
-			uint16_t encSize = controlDataSizeFromRaw(len);
-			if((encSize <= (2048 - sizeof(controlPacket))) && (jack_ringbuffer_write_space(data->ctlsendqueue) >= (encSize + sizeof(controlPacket)))){
+			if(controlPacketSize(len) <= sizeof(buf)){
 				// enque packet in midi/control queue ring buffer
-				controlPacket header;
-				header.type = cPeer_recorder | cType_anc;
-				header.peer = htonl(data->UID);
-				header.dataSize = htons(len);
-				encSize = len;
-				int8_t *extra = encodeControlPacket(&header, jstr, &encSize, NULL);
-				if(extra){
-					// don't send SysEx byte at header end.  This will be included in extra data
-					jack_ringbuffer_write(data->ctlsendqueue, (char*)&header, sizeof(controlPacket)-1); 
-					jack_ringbuffer_write(data->ctlsendqueue, jstr, len);
-					jack_ringbuffer_write(data->ctlsendqueue, extra, encSize);
-					free(extra);
-				}
+				cnt = makeControlPacket((controlPacket *)buf, cPeer_recorder | cType_anc, data->UID, jstr, len);
+				if(jack_ringbuffer_write_space(data->ctlsendqueue) >= cnt)
+					jack_ringbuffer_write(data->ctlsendqueue, buf, cnt);
 			}
 			free(jstr);
 			data->settingsChanged = FALSE;
@@ -1072,7 +946,7 @@ void* handleCtlQueues(void *refCon){
 		if(len == sizeof(controlPacket)){
 			if(decodeControlPacket(&header, 1)){
 				len = ntohs(header.dataSize);
-				uint16_t encSize = controlDataSizeFromRaw(len) + sizeof(controlPacket);
+				uint16_t encSize = controlPacketSize(len);
 				if(jack_ringbuffer_read_space(data->ctlrecvqueue) >= encSize){
 					if(packet = (controlPacket *)calloc(1, encSize)){
 						jack_ringbuffer_read(data->ctlrecvqueue, (char*)packet, encSize);
@@ -1271,6 +1145,7 @@ void mainloop(int next_arg, char *argv[], int apl_arg, unsigned char persist, lo
 	data.midiOut_jPort = NULL;
 	data.ringbuffer = NULL;
 	data.ctlsendqueue = NULL;
+	memset(&data.ctlStats, 0, sizeof(ctlQueueStats));
 	data.ctlrecvqueue = NULL;
 	data.jbufs = NULL;
 	data.flushAudio = FALSE;
@@ -1526,6 +1401,8 @@ finish:
 		pthread_cond_destroy(&data.ctlSemaphore);
 		pthread_mutex_destroy(&data.ctlMutex);
 	}
+	g_print("\nControl queue: high water %u bytes, %u packets sent, %u cycles deferred\n", 
+			data.ctlStats.high, data.ctlStats.sent, data.ctlStats.deferred);
 	if(data.client){
 		jack_deactivate(data.client);
 		jack_client_close(data.client);
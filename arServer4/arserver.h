@@ -156,9 +156,8 @@ typedef struct __attribute__((packed)){		/* data structures for each channel ins
 	uint8_t	avr;		// value is 255 times the sqrt of scalar magnitude (VU metere like scaling)
 } vuNData; 
 
-typedef struct {		/* entry in notify queue */
-	void *next;			// next record in list, or NULL for end
-	int32_t				spare;
+typedef struct {		/* slot in the notify ring: notifySlotData bytes of container data follow */
+	uint32_t			seq;		// atomic: ring position the slot is ready for, see notifyMakeEntry()
 	notifyConatiner		container;
 } notifyEntry;
 
@@ -475,9 +475,7 @@ serverLogMakeEntry(debugtxt); */
 void UnloadItem(int pos, queueRecord *qrec){    
 	// assumes queueLock is alread write locked!
 	
-	uint32_t c, cmax;
 	inChannel *instance;
-	jack_port_t **port;
 	
 	if(!qrec){
 		// use index to find record
@@ -499,14 +497,7 @@ void UnloadItem(int pos, queueRecord *qrec){
 		retainListRecord((LinkedListEntry *)qrec);
 		qrec->status = 0;
 		qrec->player = 0;
-		port = instance->in_jPorts;
-		cmax = mixEngine->chanCount;
-		pthread_mutex_lock(&mixEngine->jackMutex);
-		for(c=0; c<cmax; c++){
-			jack_port_disconnect(mixEngine->client, *port);
-			port++;
-		}
-		pthread_mutex_unlock(&mixEngine->jackMutex);
+		unloadInChan(mixEngine, instance - mixEngine->ins);
 	}
 }
 
@@ -556,12 +547,14 @@ void MoveItem(int sourcePos, int destPos, unsigned char clearTimes){
 			instance = &mixEngine->ins[rec->player-1];
 			instance->segNext = 0;	// setting these are atomic/thread safe
 			instance->posSeg = 0.0;	// setting these are atomic/thread safe
+			scheduleInChanEvents(mixEngine, instance, event_segue);
 		}
 		rec = (queueRecord *)toRec;
 		if(checkPnumber(rec->player-1)){
 			instance = &mixEngine->ins[rec->player-1];
 			instance->segNext = 0;
 			instance->posSeg = 0.0;
+			scheduleInChanEvents(mixEngine, instance, event_segue);
 		}
 		if(destPos >= mixEngine->inCount){
 			// unload from player if loaded
@@ -653,6 +646,7 @@ void setSegTimes(inChannel *thisp, inChannel *nextp, int nextNum){
 	thisp->segNext = nextNum+1;
 	thisp->posSeg = (float)segoutT;
 	thisp->fadePos = GetMetaFloat(thisp->UID, "FadeOut", NULL);
+	scheduleInChanEvents(mixEngine, thisp, event_segue | event_fade | event_fadeTime);
 }
 
 void NextListItem(uint32_t lastStat, queueRecord *curQueRec, int *firstp, float *sbtime, float remtime, unsigned char *isPlaying){
@@ -841,6 +835,7 @@ void NextListItem(uint32_t lastStat, queueRecord *curQueRec, int *firstp, float
 								// unhook any segue times that have been set if the list is not running
 								// or will not be running after a stop
 								thisIn->segNext = 0;
+								scheduleInChanEvents(mixEngine, thisIn, event_segue);
 							}
 						}
 					}
@@ -865,6 +860,7 @@ void NextListItem(uint32_t lastStat, queueRecord *curQueRec, int *firstp, float
 					// further clean up will occur if next next time this function
 					// is called though this point in the queue list
 					thisIn->segNext = 0;
+					scheduleInChanEvents(mixEngine, thisIn, event_segue);
 				}
 			}
 		}
@@ -910,6 +906,7 @@ void watchdogReset(void){
 						if(instance->managed && (instance->status & status_playing) && ((instance->status & status_cueing) == 0)){
 							// currently playing and not in cue... fade it!
 							instance->fadePos = instance->pos;
+							scheduleInChanEvents(mixEngine, instance, event_fade);
 						}
 					}	
 				}else{
@@ -1325,8 +1322,7 @@ void QueManagerTask(unsigned char *stop){
 					npwait--;
 				// nothing is playing!  after waiting one itteration of this loop, Get going...
 				if(!npwait && checkPnumber(firstp)){
-					instance = &mixEngine->ins[firstp];
-					instance->requested = instance->requested | change_play;
+					sendMixCommand(mixEngine, cmd_inPlay, firstp, 0, 0.0);
 					serverLogMakeEntry("[automation] -Nothing playing: Starting first loaded player.");
 					
 				}
@@ -1382,8 +1378,7 @@ void QueManagerTask(unsigned char *stop){
 					// it's possible that firstp may have changed by another thread.
 					// if so, we will start the wrong player.  Oh well.  No crash.
 					if(checkPnumber(firstp)){
-						instance = &mixEngine->ins[firstp];
-						instance->requested = instance->requested | change_play;
+						sendMixCommand(mixEngine, cmd_inPlay, firstp, 0, 0.0);
 					}
 				}*/
 			}
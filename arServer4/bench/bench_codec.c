@@ -0,0 +1,229 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+/* bench_codec: round trip check and timing of the shared control packet 
+ * codec in ../common/ctlcodec.c.  Random packets are encoded, compared 
+ * byte for byte with the original bit at a time encoding, checked for 
+ * stray top bits, and decoded back.  Then packets of a given size are 
+ * encoded and decoded in a loop, reporting the time taken per packet 
+ * for both. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "../../common/ctlcodec.h"
+
+#define tagType		0x20	// cPeer_recorder | cType_tags
+
+static double nsNow(void){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1.0e9 + (double)now.tv_nsec;
+}
+
+/* the original codec, one bit at a time, in place, with the extra bytes 
+ * after the data */
+static void refEncode(controlPacket *packet, uint16_t size){
+	uint8_t *byte, *extra;
+	uint16_t rem, bit;
+	unsigned int b;
+	
+	byte = (uint8_t *)packet->data;
+	extra = byte + size;
+	if(size){
+		*extra = 0;
+		bit = 0;
+		for(rem=size; rem; rem--){
+			if(bit >= 7){
+				bit = 0;
+				extra++;
+				*extra = 0;
+			}
+			if(*byte & 0x80){
+				*byte = *byte & 0x7F;
+				*extra = *extra | (1 << bit);
+			}
+			bit++;
+			byte++;
+		}
+		extra++;
+	}
+	*extra = 0xF7;
+	packet->topBits = 0;
+	packet->sysExFlag = 0xF0;
+	byte = &packet->type;
+	for(b=0; b<7; b++){
+		if(*byte & 0x80){
+			*byte = *byte & 0x7F;
+			packet->topBits = packet->topBits | (1 << b);
+		}
+		byte++;
+	}
+}
+
+static void refDecode(controlPacket *packet){
+	uint8_t *byte, *extra;
+	uint16_t rem, bit;
+	unsigned int b;
+	
+	byte = &packet->type;
+	for(b=0; b<7; b++){
+		if(packet->topBits & (1 << b))
+			*byte = *byte | 0x80;
+		byte++;
+	}
+	rem = ntohs(packet->dataSize);
+	byte = (uint8_t *)packet->data;
+	extra = byte + rem;
+	bit = 0;
+	while(rem){
+		if(*extra & (1 << bit))
+			*byte = *byte | 0x80;
+		bit++;
+		byte++;
+		rem--;
+		if(bit >= 7){
+			bit = 0;
+			extra++;
+		}
+	}
+}
+
+static void usage(void){
+	fprintf(stdout, "Usage: bench_codec [options]\n");
+	fprintf(stdout, "\t-r [random round trip packets to check] (default 100000)\n");
+	fprintf(stdout, "\t-s [data bytes per timed packet] (default 600)\n");
+	fprintf(stdout, "\t-c [packets to time] (default 1000000)\n");
+}
+
+int main(int argc, char *argv[]){
+	unsigned char buf[ctl_max_packet], ref[ctl_max_packet], raw[ctl_max_packet];
+	controlPacket *packet;
+	unsigned int trips, count, timedSize, i, s, bad;
+	uint16_t size, total;
+	uint32_t peer;
+	uint8_t type;
+	double start, newTime, refTime;
+	int opt;
+	
+	trips = 100000;
+	timedSize = 600;
+	count = 1000000;
+	while((opt = getopt(argc, argv, "r:s:c:h")) != -1){
+		switch(opt){
+			case 'r':
+				trips = atoi(optarg);
+				break;
+			case 's':
+				timedSize = atoi(optarg);
+				break;
+			case 'c':
+				count = atoi(optarg);
+				break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+	if(!count){
+		usage();
+		return 1;
+	}
+	if((timedSize > ctl_max_packet) || (controlPacketSize(timedSize) > ctl_max_packet)){
+		fprintf(stderr, "packets of %u bytes are too big to send\n", timedSize);
+		return 1;
+	}
+	
+	/* random round trips: sizes weighted toward the small end, where the 
+	 * partial group at the end of the data is a larger share */
+	srandom(1);
+	bad = 0;
+	for(i=0; i<trips; i++){
+		size = random() % 64;
+		if(i & 1)
+			size = random() % (ctl_max_packet - sizeof(controlPacket) - 300);
+		type = random();
+		peer = random();
+		for(s=0; s<size; s++)
+			raw[s] = random();
+		total = makeControlPacket((controlPacket *)buf, type, peer, raw, size);
+		packet = (controlPacket *)ref;
+		packet->type = type;
+		packet->peer = htonl(peer);
+		packet->dataSize = htons(size);
+		memcpy(packet->data, raw, size);
+		refEncode(packet, size);
+		if((total != controlPacketSize(size)) || memcmp(buf, ref, total)){
+			fprintf(stderr, "encoding mismatch: %u data bytes\n", size);
+			bad++;
+			continue;
+		}
+		/* only the start and end flags may have their top bits set */
+		for(s=1; s<(total - 1); s++){
+			if(buf[s] & 0x80)
+				break;
+		}
+		if((s < (total - 1)) || (buf[total - 1] != 0xF7)){
+			fprintf(stderr, "bad encoding: %u data bytes\n", size);
+			bad++;
+			continue;
+		}
+		packet = (controlPacket *)buf;
+		if(!decodeControlPacket(packet, 1) || (packet->type != type) || (ntohl(packet->peer) != peer) 
+								|| (ntohs(packet->dataSize) != size)){
+			fprintf(stderr, "header round trip failed: %u data bytes\n", size);
+			bad++;
+			continue;
+		}
+		if(!decodeControlPacket(packet, 0) || memcmp(packet->data, raw, size)){
+			fprintf(stderr, "data round trip failed: %u data bytes\n", size);
+			bad++;
+		}
+	}
+	fprintf(stdout, "round trips: %u, failures: %u\n", trips, bad);
+	
+	/* timing: text with some multi-byte characters, as tag packets carry */
+	size = timedSize;
+	for(s=0; s<sizeof(raw); s++)
+		raw[s] = (s % 23) ? ('a' + (s % 26)) : 0xC3;
+	packet = (controlPacket *)buf;
+	start = nsNow();
+	for(i=0; i<count; i++){
+		makeControlPacket(packet, tagType, i, raw, size);
+		decodeControlPacket(packet, 0);
+	}
+	newTime = (nsNow() - start) / count;
+	start = nsNow();
+	for(i=0; i<count; i++){
+		packet->type = tagType;
+		packet->peer = htonl(i);
+		packet->dataSize = htons(size);
+		memcpy(packet->data, raw, size);
+		refEncode(packet, size);
+		refDecode(packet);
+	}
+	refTime = (nsNow() - start) / count;
+	fprintf(stdout, "%u data bytes, %u packets\n", size, count);
+	fprintf(stdout, "ns/packet, encode and decode: word at a time %.1f, bit at a time %.1f\n", newTime, refTime);
+	return bad ? 1 : 0;
+}
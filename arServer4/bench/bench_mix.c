@@ -0,0 +1,310 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+/* bench_mix: offline render harness for the arServer4 mix engine.
+ * Links mix_engine.c and mixbuffers.c against the stub JACK layer in
+ * jack_stub.c, and calls the engine process callback in a loop over
+ * synthetic input buffers, reporting the time taken per cycle.
+ * No jackd server is needed. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+
+#include "../mix_engine.h"
+#include "../arserver.h"
+#include "../mixworkers.h"
+#include "../mixstats.h"
+#include "jack_stub.h"
+
+/* arServer globals and functions used by the mix engine, which would
+ * otherwise drag in the rest of the server: the control packet codec is 
+ * the shared one */
+mixEngineRecPtr mixEngine;
+
+void serverLogMakeEntry(char *message){
+}
+
+static double nsNow(void){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1.0e9 + (double)now.tv_nsec;
+}
+
+static int cmpDouble(const void *a, const void *b){
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+
+	if(da < db)
+		return -1;
+	if(da > db)
+		return 1;
+	return 0;
+}
+
+#define toneTableSize	65536	// must be a power of 2
+
+static jack_default_audio_sample_t toneTable[toneTableSize];
+
+static void fillInputs(unsigned int active, unsigned int width, unsigned int frames, unsigned int cycle){
+	/* each input channel gets its own moving window into the tone table */
+	unsigned int i, c, s, idx;
+	jack_default_audio_sample_t *buf;
+	jack_port_t **port;
+	inChannel *inchrec;
+
+	inchrec = mixEngine->ins;
+	for(i=0; i<active; i++){
+		port = inchrec->in_jPorts;
+		for(c=0; c<width; c++){
+			buf = jack_port_get_buffer(*port, frames);
+			idx = (cycle * frames) + ((i * width + c) * 997);
+			for(s=0; s<frames; s++)
+				buf[s] = toneTable[(idx + s) & (toneTableSize - 1)];
+			port++;
+		}
+		inchrec++;
+	}
+}
+
+static void usage(void){
+	fprintf(stdout, "Usage: bench_mix [options]\n");
+	fprintf(stdout, "\t-i [mixer input count] (default 10)\n");
+	fprintf(stdout, "\t-a [active (playing) input count] (default all inputs)\n");
+	fprintf(stdout, "\t-b [mix bus count] (default 4)\n");
+	fprintf(stdout, "\t-o [output group count] (default 6)\n");
+	fprintf(stdout, "\t-w [channel width] (default 2)\n");
+	fprintf(stdout, "\t-n [frames per cycle] (default 256)\n");
+	fprintf(stdout, "\t-r [sample rate] (default 48000)\n");
+	fprintf(stdout, "\t-c [cycles to time] (default 10000)\n");
+	fprintf(stdout, "\t-m [active inputs with a connected mix-minus feed] (default 0)\n");
+	fprintf(stdout, "\t-d [output group delay, seconds] (default 0.0)\n");
+	fprintf(stdout, "\t-k [mix kernel set: scalar, sse2, avx2, avx512] (default best supported)\n");
+	fprintf(stdout, "\t-t [mix worker thread count] (default 0)\n");
+	fprintf(stdout, "\t-g back large mix buffers with huge pages\n");
+}
+
+int main(int argc, char *argv[]){
+	unsigned int inputs, active, busses, outputs, width, frames, rate, cycles, mmCount, threads;
+	unsigned int i, c, s, b, warm;
+	float delay;
+	const char *kernels;
+	const char *err;
+	int opt;
+	double start, total, *times, period, checksum;
+	inChannel *inchrec;
+	outChannel *outchrec;
+	jack_default_audio_sample_t *buf;
+	jack_port_t **port;
+
+	inputs = 10;
+	active = (unsigned)-1;
+	busses = 4;
+	outputs = 6;
+	width = 2;
+	frames = 256;
+	rate = 48000;
+	cycles = 10000;
+	mmCount = 0;
+	delay = 0.0;
+	kernels = NULL;
+	threads = 0;
+
+	while((opt = getopt(argc, argv, "i:a:b:o:w:n:r:c:m:d:k:t:gh")) != -1){
+		switch(opt){
+			case 'i':
+				inputs = atoi(optarg);
+				break;
+			case 'a':
+				active = atoi(optarg);
+				break;
+			case 'b':
+				busses = atoi(optarg);
+				break;
+			case 'o':
+				outputs = atoi(optarg);
+				break;
+			case 'w':
+				width = atoi(optarg);
+				break;
+			case 'n':
+				frames = atoi(optarg);
+				break;
+			case 'r':
+				rate = atoi(optarg);
+				break;
+			case 'c':
+				cycles = atoi(optarg);
+				break;
+			case 'm':
+				mmCount = atoi(optarg);
+				break;
+			case 'd':
+				delay = atof(optarg);
+				break;
+			case 'k':
+				kernels = optarg;
+				break;
+			case 't':
+				threads = atoi(optarg);
+				break;
+			case 'g':
+				mixbuffer_hugePages = 1;
+				break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+	if(active > inputs)
+		active = inputs;
+	if(mmCount > active)
+		mmCount = active;
+	if(!inputs || !busses || !width || !frames || !rate || !cycles){
+		usage();
+		return 1;
+	}
+
+	jackstub_init(rate, frames);
+	if(err = initMixer(&mixEngine, width, inputs, outputs, busses, NULL, "bench_mix", 0)){
+		fprintf(stderr, "initMixer failed: %s\n", err);
+		return 1;
+	}
+	/* initMixer picks the best kernels; override if asked */
+	if(kernels)
+		mixkernels_init(kernels);
+	if(threads && (err = mixworkers_init(mixEngine, threads, frames))){
+		fprintf(stderr, "mixworkers_init failed: %s\n", err);
+		return 1;
+	}
+
+	/* synthetic inputs: a pair of detuned tones, with each input channel
+	 * reading from a different place in the table, playing into the
+	 * monitor and main buses plus one other bus, round robin */
+	for(s=0; s<toneTableSize; s++)
+		toneTable[s] = 0.25 * sinf(s * 0.0131) + 0.1 * sinf(s * 0.1937);
+	inchrec = mixEngine->ins;
+	for(i=0; i<active; i++){
+		b = i % busses;
+		if(b == 1)
+			b = 0;	// stay out of cue: cue disables all other buses
+		/* buses past 23 are only in the wide route set */
+		inchrec->busses = 0x5;
+		if(b < 24)
+			inchrec->busses = inchrec->busses | (1 << b);
+		busset_add(&inchrec->routes, b);
+		inchrec->portConnected = 1;
+		inchrec->sourceType = sourceTypeCanRepos;
+		inchrec->status = status_standby | status_playing;
+		if(i < mmCount){
+			inchrec->feedBus = 3;	// main bus + 1
+			port = inchrec->mm_jPorts;
+			for(c=0; c<width; c++)
+				jackstub_set_connected(*port++, 1);
+			inchrec->mmConnected = 1;	// as jackChangeWatcher would set it
+		}
+		inchrec++;
+	}
+	outchrec = mixEngine->outs;
+	for(i=0; i<outputs; i++){
+		outchrec->bus = i % busses;
+		setOutputDelay(mixEngine, i, delay);	// taken by render on the first cycle
+		port = outchrec->jPorts;
+		for(c=0; c<width; c++)
+			jackstub_set_connected(*port++, 1);
+		outchrec->isConnected = 1;
+		outchrec++;
+	}
+
+	if((times = calloc(cycles, sizeof(double))) == NULL){
+		fprintf(stderr, "failed to allocate timing array\n");
+		return 1;
+	}
+
+	/* warm up caches and branch predictors */
+	warm = cycles / 10;
+	for(i=0; i<warm; i++){
+		fillInputs(active, width, frames, i);
+		jackstub_cycle(frames);
+	}
+
+	/* stage timing of the timed cycles only */
+	mixstats_reset(mixEngine->stats);
+	total = 0.0;
+	for(i=0; i<cycles; i++){
+		/* new input samples each cycle, outside of the timed section */
+		fillInputs(active, width, frames, warm + i);
+		start = nsNow();
+		jackstub_cycle(frames);
+		times[i] = nsNow() - start;
+		total += times[i];
+	}
+
+	/* sum of magnitudes of everything the last cycle produced: the same
+	 * settings should always give the same result, give or take rounding */
+	checksum = 0.0;
+	port = mixEngine->mixbuses->busout_jPorts;
+	for(i=0; i<busses * width; i++){
+		buf = jack_port_get_buffer(*port++, frames);
+		for(s=0; s<frames; s++)
+			checksum += fabs(buf[s]);
+	}
+	outchrec = mixEngine->outs;
+	for(i=0; i<outputs; i++){
+		port = outchrec->jPorts;
+		for(c=0; c<width; c++){
+			buf = jack_port_get_buffer(*port++, frames);
+			for(s=0; s<frames; s++)
+				checksum += fabs(buf[s]);
+		}
+		outchrec++;
+	}
+	inchrec = mixEngine->ins;
+	for(i=0; i<inputs; i++){
+		port = inchrec->mm_jPorts;
+		for(c=0; c<width; c++){
+			buf = jack_port_get_buffer(*port++, frames);
+			for(s=0; s<frames; s++)
+				checksum += fabs(buf[s]);
+		}
+		inchrec++;
+	}
+
+	qsort(times, cycles, sizeof(double), cmpDouble);
+	period = 1.0e9 * frames / rate;
+	fprintf(stdout, "inputs %u (%u active, %u mix-minus), buses %u, outputs %u, width %u\n",
+						inputs, active, mmCount, busses, outputs, width);
+	fprintf(stdout, "frames %u @ %u Hz, %u cycles, %s mix kernels, %u worker threads\n", frames, rate, cycles, mixKernels.name, threads);
+	fprintf(stdout, "ns/cycle: mean %.0f, min %.0f, p50 %.0f, p99 %.0f, max %.0f\n", total / cycles,
+						times[0], times[cycles / 2], times[(cycles * 99) / 100], times[cycles - 1]);
+	fprintf(stdout, "cycles/sec: %.0f\n", 1.0e9 * cycles / total);
+	fprintf(stdout, "real-time load: %.2f%% of a %.0f ns period\n", 100.0 * (total / cycles) / period, period);
+	fprintf(stdout, "stage us: p50, p99, max\n");
+	for(s=0; s<stageCount; s++)
+		fprintf(stdout, "\t%-10s %8.2f %8.2f %8.2f\n", mixstats_stageName[s], mixstats_percentile(mixEngine->stats, s, 0.5),
+							mixstats_percentile(mixEngine->stats, s, 0.99), mixstats_max(mixEngine->stats, s));
+	fprintf(stdout, "output checksum: %.6g\n", checksum);
+
+	free(times);
+	shutdownMixer(mixEngine);
+	return 0;
+}
@@ -0,0 +1,399 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include <jack/ringbuffer.h>
+
+#include "jack_stub.h"
+
+#define stubMidiEvents	256
+#define stubMidiBytes	(64 * 1024)
+
+typedef struct{
+	jack_nframes_t count;
+	size_t used;
+	jack_midi_event_t events[stubMidiEvents];
+	jack_midi_data_t data[stubMidiBytes];
+} stubMidiBuffer;
+
+struct _jack_port{
+	char name[96];
+	unsigned long flags;
+	unsigned char isMidi;
+	int connected;
+	void *buf;
+};
+
+struct _jack_client{
+	char name[64];
+	JackProcessCallback process;
+	void *processArg;
+	JackXRunCallback xrun;
+	void *xrunArg;
+	JackBufferSizeCallback bufsize;
+	void *bufsizeArg;
+};
+
+static struct _jack_client stubClient;
+static jack_nframes_t stubRate = 48000;
+static jack_nframes_t stubMaxFrames = 4096;
+static jack_nframes_t stubPeriod = 4096;
+
+void jackstub_init(jack_nframes_t sampleRate, jack_nframes_t maxFrames){
+	stubRate = sampleRate;
+	stubMaxFrames = maxFrames;
+	stubPeriod = maxFrames;
+}
+
+int jackstub_set_buffer_size(jack_nframes_t nframes){
+	if(nframes > stubMaxFrames)
+		return -1;
+	stubPeriod = nframes;
+	if(stubClient.bufsize)
+		return stubClient.bufsize(nframes, stubClient.bufsizeArg);
+	return 0;
+}
+
+int jackstub_cycle(jack_nframes_t nframes){
+	if(stubClient.process)
+		return stubClient.process(nframes, stubClient.processArg);
+	return -1;
+}
+
+void jackstub_set_connected(jack_port_t *port, int count){
+	if(port)
+		port->connected = count;
+}
+
+unsigned int jackstub_midi_out_count(jack_port_t *port){
+	if(port && port->isMidi)
+		return ((stubMidiBuffer *)port->buf)->count;
+	return 0;
+}
+
+/* client */
+
+jack_client_t *jack_client_open(const char *client_name, jack_options_t options, jack_status_t *status, ...){
+	memset(&stubClient, 0, sizeof(stubClient));
+	snprintf(stubClient.name, sizeof stubClient.name, "%s", client_name);
+	if(status)
+		*status = 0;
+	return &stubClient;
+}
+
+int jack_client_close(jack_client_t *client){
+	return 0;
+}
+
+char *jack_get_client_name(jack_client_t *client){
+	return client->name;
+}
+
+int jack_activate(jack_client_t *client){
+	return 0;
+}
+
+int jack_deactivate(jack_client_t *client){
+	return 0;
+}
+
+void jack_on_shutdown(jack_client_t *client, JackShutdownCallback function, void *arg){
+}
+
+int jack_set_process_callback(jack_client_t *client, JackProcessCallback process_callback, void *arg){
+	client->process = process_callback;
+	client->processArg = arg;
+	return 0;
+}
+
+int jack_set_xrun_callback(jack_client_t *client, JackXRunCallback xrun_callback, void *arg){
+	client->xrun = xrun_callback;
+	client->xrunArg = arg;
+	return 0;
+}
+
+int jack_set_buffer_size_callback(jack_client_t *client, JackBufferSizeCallback bufsize_callback, void *arg){
+	client->bufsize = bufsize_callback;
+	client->bufsizeArg = arg;
+	return 0;
+}
+
+int jack_set_port_registration_callback(jack_client_t *client, JackPortRegistrationCallback registration_callback, void *arg){
+	return 0;
+}
+
+int jack_set_port_connect_callback(jack_client_t *client, JackPortConnectCallback connect_callback, void *arg){
+	return 0;
+}
+
+int jack_set_port_rename_callback(jack_client_t *client, JackPortRenameCallback rename_callback, void *arg){
+	return 0;
+}
+
+jack_nframes_t jack_get_sample_rate(jack_client_t *client){
+	return stubRate;
+}
+
+jack_nframes_t jack_get_buffer_size(jack_client_t *client){
+	return stubPeriod;
+}
+
+float jack_cpu_load(jack_client_t *client){
+	return 0.0;
+}
+
+jack_time_t jack_get_time(void){
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (jack_time_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void jack_free(void* ptr){
+	free(ptr);
+}
+
+/* threads: plain pthreads, no real-time scheduling in the bench */
+
+int jack_client_create_thread(jack_client_t* client, jack_native_thread_t *thread, int priority, 
+						int realtime, void *(*start_routine)(void*), void *arg){
+	return pthread_create(thread, NULL, start_routine, arg);
+}
+
+int jack_client_real_time_priority(jack_client_t *client){
+	return 0;
+}
+
+int jack_is_realtime(jack_client_t *client){
+	return 0;
+}
+
+int jack_client_stop_thread(jack_client_t* client, jack_native_thread_t thread){
+	return pthread_join(thread, NULL);
+}
+
+/* ports */
+
+jack_port_t *jack_port_register(jack_client_t *client, const char *port_name, const char *port_type, unsigned long flags, unsigned long buffer_size){
+	jack_port_t *port;
+
+	if((port = calloc(1, sizeof(jack_port_t))) == NULL)
+		return NULL;
+	snprintf(port->name, sizeof port->name, "%s:%s", client->name, port_name);
+	port->flags = flags;
+	if(!strcmp(port_type, JACK_DEFAULT_MIDI_TYPE)){
+		port->isMidi = 1;
+		port->buf = calloc(1, sizeof(stubMidiBuffer));
+	}else
+		port->buf = calloc(stubMaxFrames, sizeof(jack_default_audio_sample_t));
+	if(port->buf == NULL){
+		free(port);
+		return NULL;
+	}
+	return port;
+}
+
+int jack_port_unregister(jack_client_t *client, jack_port_t *port){
+	if(port){
+		free(port->buf);
+		free(port);
+	}
+	return 0;
+}
+
+void *jack_port_get_buffer(jack_port_t *port, jack_nframes_t nframes){
+	return port->buf;
+}
+
+const char *jack_port_name(const jack_port_t *port){
+	return port->name;
+}
+
+int jack_port_flags(const jack_port_t *port){
+	return port->flags;
+}
+
+int jack_port_connected(const jack_port_t *port){
+	return port->connected;
+}
+
+int jack_port_connected_to(const jack_port_t *port, const char *port_name){
+	return 0;
+}
+
+const char **jack_port_get_connections(const jack_port_t *port){
+	return NULL;
+}
+
+int jack_connect(jack_client_t *client, const char *source_port, const char *destination_port){
+	return 0;
+}
+
+int jack_disconnect(jack_client_t *client, const char *source_port, const char *destination_port){
+	return 0;
+}
+
+int jack_port_disconnect(jack_client_t *client, jack_port_t *port){
+	port->connected = 0;
+	return 0;
+}
+
+/* midi */
+
+uint32_t jack_midi_get_event_count(void* port_buffer){
+	return ((stubMidiBuffer *)port_buffer)->count;
+}
+
+int jack_midi_event_get(jack_midi_event_t *event, void *port_buffer, uint32_t event_index){
+	stubMidiBuffer *mb = (stubMidiBuffer *)port_buffer;
+
+	if(event_index >= mb->count)
+		return -1;
+	*event = mb->events[event_index];
+	return 0;
+}
+
+void jack_midi_clear_buffer(void *port_buffer){
+	stubMidiBuffer *mb = (stubMidiBuffer *)port_buffer;
+
+	mb->count = 0;
+	mb->used = 0;
+}
+
+size_t jack_midi_max_event_size(void* port_buffer){
+	stubMidiBuffer *mb = (stubMidiBuffer *)port_buffer;
+
+	return stubMidiBytes - mb->used;
+}
+
+jack_midi_data_t* jack_midi_event_reserve(void *port_buffer, jack_nframes_t time, size_t data_size){
+	stubMidiBuffer *mb = (stubMidiBuffer *)port_buffer;
+	jack_midi_event_t *ev;
+
+	if((mb->count >= stubMidiEvents) || ((mb->used + data_size) > stubMidiBytes))
+		return NULL;
+	ev = &mb->events[mb->count];
+	ev->time = time;
+	ev->size = data_size;
+	ev->buffer = &mb->data[mb->used];
+	mb->used += data_size;
+	mb->count++;
+	return ev->buffer;
+}
+
+int jack_midi_event_write(void *port_buffer, jack_nframes_t time, const jack_midi_data_t *data, size_t data_size){
+	jack_midi_data_t *dest;
+
+	if((dest = jack_midi_event_reserve(port_buffer, time, data_size)) == NULL)
+		return -1;
+	memcpy(dest, data, data_size);
+	return 0;
+}
+
+uint32_t jack_midi_get_lost_event_count(void *port_buffer){
+	return 0;
+}
+
+/* ring buffer: same single reader, single writer semantics as libjack */
+
+jack_ringbuffer_t *jack_ringbuffer_create(size_t sz){
+	jack_ringbuffer_t *rb;
+	unsigned int bits;
+
+	if((rb = calloc(1, sizeof(jack_ringbuffer_t))) == NULL)
+		return NULL;
+	for(bits = 1; ((size_t)1 << bits) < sz; bits++);
+	rb->size = (size_t)1 << bits;
+	rb->size_mask = rb->size - 1;
+	if((rb->buf = malloc(rb->size)) == NULL){
+		free(rb);
+		return NULL;
+	}
+	return rb;
+}
+
+void jack_ringbuffer_free(jack_ringbuffer_t *rb){
+	if(rb){
+		free(rb->buf);
+		free(rb);
+	}
+}
+
+size_t jack_ringbuffer_read_space(const jack_ringbuffer_t *rb){
+	return (rb->write_ptr - rb->read_ptr) & rb->size_mask;
+}
+
+size_t jack_ringbuffer_write_space(const jack_ringbuffer_t *rb){
+	return (rb->read_ptr - rb->write_ptr - 1) & rb->size_mask;
+}
+
+size_t jack_ringbuffer_peek(jack_ringbuffer_t *rb, char *dest, size_t cnt){
+	size_t avail, i, idx;
+
+	avail = jack_ringbuffer_read_space(rb);
+	if(cnt > avail)
+		cnt = avail;
+	idx = rb->read_ptr;
+	for(i=0; i<cnt; i++)
+		dest[i] = rb->buf[(idx + i) & rb->size_mask];
+	return cnt;
+}
+
+void jack_ringbuffer_read_advance(jack_ringbuffer_t *rb, size_t cnt){
+	rb->read_ptr = (rb->read_ptr + cnt) & rb->size_mask;
+}
+
+size_t jack_ringbuffer_read(jack_ringbuffer_t *rb, char *dest, size_t cnt){
+	cnt = jack_ringbuffer_peek(rb, dest, cnt);
+	jack_ringbuffer_read_advance(rb, cnt);
+	return cnt;
+}
+
+size_t jack_ringbuffer_write(jack_ringbuffer_t *rb, const char *src, size_t cnt){
+	size_t avail, i, idx;
+
+	avail = jack_ringbuffer_write_space(rb);
+	if(cnt > avail)
+		cnt = avail;
+	idx = rb->write_ptr;
+	for(i=0; i<cnt; i++)
+		rb->buf[(idx + i) & rb->size_mask] = src[i];
+	rb->write_ptr = (rb->write_ptr + cnt) & rb->size_mask;
+	return cnt;
+}
+
+void jack_ringbuffer_write_advance(jack_ringbuffer_t *rb, size_t cnt){
+	rb->write_ptr = (rb->write_ptr + cnt) & rb->size_mask;
+}
+
+int jack_ringbuffer_mlock(jack_ringbuffer_t *rb){
+	return 0;
+}
+
+void jack_ringbuffer_reset(jack_ringbuffer_t *rb){
+	rb->read_ptr = 0;
+	rb->write_ptr = 0;
+}
@@ -0,0 +1,53 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _JACKSTUB_H
+#define _JACKSTUB_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <jack/jack.h>
+
+/* Stand-in for the parts of libjack used by the mix engine, so the engine
+ * can be driven without a jackd server.  Port buffers are plain heap
+ * memory, MIDI ports hold no events unless a packet is placed there by the
+ * caller, and connections are just a count set by the caller. */
+
+void jackstub_init(jack_nframes_t sampleRate, jack_nframes_t maxFrames);
+
+/* call the process callback the engine registered with the stub client */
+int jackstub_cycle(jack_nframes_t nframes);
+
+/* change the period reported by jack_get_buffer_size(), up to maxFrames, 
+ * calling the buffer size callback as jackd would */
+int jackstub_set_buffer_size(jack_nframes_t nframes);
+
+/* set the connection count reported by jack_port_connected() */
+void jackstub_set_connected(jack_port_t *port, int count);
+
+/* number of MIDI events written to a (output) port buffer this cycle */
+unsigned int jackstub_midi_out_count(jack_port_t *port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
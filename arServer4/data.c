@@ -518,20 +518,9 @@ unsigned char releaseQueueRecord(queueRecord *root, queueRecord *rec, unsigned c
 			releaseMetaRecord(rec->UID);
 		}
 		
-		if(instance && instance->managed){
-			uint32_t c, cmax;
-			jack_port_t **port;
+		if(instance && instance->managed)
 			// this will trigger the standard player unload
-			// after jack port disconnection
-			port = instance->in_jPorts;
-			cmax = mixEngine->chanCount;
-			pthread_mutex_lock(&mixEngine->jackMutex);
-			for(c=0; c<cmax; c++){
-				jack_port_disconnect(mixEngine->client, *port);
-				port++;
-			}
-			pthread_mutex_unlock(&mixEngine->jackMutex);
-		}
+			unloadInChan(mixEngine, instance - mixEngine->ins);
 		
 		free(rec);
 		return 1;
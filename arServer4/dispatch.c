@@ -30,17 +30,31 @@
 #include <ctype.h>
 #include <pthread.h>
 #include <signal.h>
+#include <stddef.h>
+#include <sys/eventfd.h>
 
-#define queueMax 100
+#define logQueueMax		100		/* most entries waiting on the server and program log queues */
+#define notifySlots		256		/* notify ring capacity: a power of two */
+#define notifyMinData	1024	/* notify slot data bytes, at least: more if a mixer VU notice needs it */
+#define notifyLogSecs	10		/* least time between notify drop log entries */
 
 time_t logChangeTime;
 uint32_t log_busses;
 
-pthread_mutex_t notifyQueueLock;
-pthread_mutex_t notifyMutex;
-pthread_cond_t notifySemaphore;
+/* notify queue: a bounded multi-producer, single consumer ring of fixed 
+ * size slots, allocated once, so notifyMakeEntry() neither allocates nor 
+ * locks.  Producers claim a slot by advancing notifyEnqPos, fill it and 
+ * publish it by setting its seq; notifyWatcher drains every published slot 
+ * in a batch and hands each back a lap on. */
+unsigned char *notifyRing = NULL;
+size_t notifySlotBytes;
+size_t notifySlotData;
+uint32_t notifyEnqPos;		// atomic: next ring position for a producer to claim
+uint32_t notifyDeqPos;		// next ring position for notifyWatcher to send
+uint32_t notifyWaiting;		// atomic: set while notifyWatcher sleeps on notifyFD
+int notifyFD = -1;
 pthread_t notifyThread;
-notifyEntry *notifyQueue;
+notifyQueueStats notifyStats;
 
 pthread_mutex_t srvLogQueueLock;
 pthread_mutex_t srvLogMutex;
@@ -87,7 +101,7 @@ void *sipSessionWatcher(void *refCon);
 unsigned char initDispatcherThreads(void){
 	unsigned char vuRecCnt;
 	unsigned char vuChanCnt;
-	unsigned int bytes;
+	unsigned int bytes, i;
 
 	dispRun = 1;
 	
@@ -96,12 +110,6 @@ unsigned char initDispatcherThreads(void){
 	pthread_mutex_init(&lastsegMutex, NULL);
 	pthread_cond_init(&lastsegSemaphore, NULL);
 	
-	notifyQueue = NULL;
-	pthread_mutex_init(&notifyQueueLock, NULL);
-	pthread_mutex_init(&notifyMutex, NULL);
-	pthread_cond_init(&notifySemaphore, NULL);
-	pthread_create(&notifyThread, NULL, &notifyWatcher, NULL);	
-
 	svrLogFileName = NULL;
 	str_setstr(&svrLogFileName, "");
 	svrLogQueue = NULL;
@@ -134,6 +142,23 @@ unsigned char initDispatcherThreads(void){
 		vuRecord = (vuNContainer *)calloc(1, bytes);
 	else
 		vuRecord = NULL;
+	
+	/* notify ring, with slots big enough for the VU notice */
+	notifySlotData = notifyMinData;
+	if(vuRecord && (bytes > notifySlotData))
+		notifySlotData = bytes;
+	notifySlotBytes = (offsetof(notifyEntry, container.data) + notifySlotData + 7) & ~(size_t)7;
+	notifyEnqPos = 0;
+	notifyDeqPos = 0;
+	notifyWaiting = 0;
+	memset(&notifyStats, 0, sizeof(notifyStats));
+	notifyFD = eventfd(0, EFD_CLOEXEC);
+	if(notifyRing = (unsigned char *)calloc(notifySlots, notifySlotBytes)){
+		for(i=0; i<notifySlots; i++)
+			((notifyEntry *)(notifyRing + (i * notifySlotBytes)))->seq = i;
+	}
+	pthread_create(&notifyThread, NULL, &notifyWatcher, NULL);	
+	
 	pthread_create(&vuUpdateThread, NULL, &metersUpdateThread, NULL);	
 	
 	pthread_create(&jackWatchThread, NULL, &jackChangeWatcher, NULL);	
@@ -143,11 +168,11 @@ unsigned char initDispatcherThreads(void){
 void shutdownDispatcherThreads(void){
 	dispRun = 0;
 	/* wake Threads so they notice run state change end */
-	pthread_cond_broadcast(&mixEngine->changedSemaphore); 
-	pthread_cond_broadcast(&mixEngine->ctlInQueueSemaphore);
+	signalEventFD(mixEngine->changeFD); 
+	signalEventFD(mixEngine->ctlInQueueFD);
 	
 	pthread_cond_broadcast(&srvLogSemaphore); 
-	pthread_cond_broadcast(&notifySemaphore); 
+	signalEventFD(notifyFD); 
 	pthread_cond_broadcast(&pgmLogSemaphore); 
 	pthread_cond_broadcast(&lastsegSemaphore); 
 	pthread_cond_broadcast(&mixEngine->cbQueueSemaphore);
@@ -162,8 +187,6 @@ void shutdownDispatcherThreads(void){
 	serverLogCloseFile();
 	pthread_mutex_destroy(&srvLogMutex);
 	pthread_cond_destroy(&srvLogSemaphore);
-	pthread_mutex_destroy(&notifyMutex);
-	pthread_cond_destroy(&notifySemaphore);
 	pthread_mutex_destroy(&pgmLogMutex);
 	pthread_cond_destroy(&pgmLogSemaphore);
 	pthread_mutex_destroy(&lastsegMutex);
@@ -174,7 +197,15 @@ void shutdownDispatcherThreads(void){
 	if(vuRecord)
 		free(vuRecord);
 	pthread_join(jackWatchThread, NULL);
-
+	/* notify ring last: the threads above make notices until they end */
+	if(notifyRing){
+		free(notifyRing);
+		notifyRing = NULL;
+	}
+	if(notifyFD >= 0){
+		close(notifyFD);
+		notifyFD = -1;
+	}
 }
 
 void *sipSessionWatcher(void *refCon){
@@ -408,10 +439,33 @@ void *jackChangeWatcher(void *refCon){
 							isConnected = 1;
 						pptr++;
 					}
-					// update connected status
-					inrec->isConnected = isConnected;
+					// update port connected status: render counts a cart as connected itself
+					inrec->portConnected = isConnected;
+
+					// and for the mix-minus feed outputs, so render can skip them
+					pptr = inrec->mm_jPorts;
+					isConnected = 0;
+					for(c=0; c<cmax; c++){
+						if(jack_port_connected(*pptr))
+							isConnected = 1;
+						pptr++;
+					}
+					inrec->mmConnected = isConnected;
 					inrec++;
 				}
+				// and output groups, so render can skip those with no connections
+				orec = mixEngine->outs;
+				for(i=0; i<mixEngine->outCount; i++){
+					pptr = orec->jPorts;
+					isConnected = 0;
+					for(c=0; c<cmax; c++){
+						if(jack_port_connected(*pptr))
+							isConnected = 1;
+						pptr++;
+					}
+					orec->isConnected = isConnected;
+					orec++;
+				}
 			}else if(port = jack_port_by_id(mixEngine->client, *IDptr)){
 				pthread_mutex_lock(&mixEngine->jackMutex);
 				if(jack_port_flags(port) & JackPortIsOutput)
@@ -520,22 +574,110 @@ void *jackChangeWatcher(void *refCon){
 	return NULL;
 }
 
+static void notifyWideBus(unsigned int index, busSet *routes){
+	/* a server with more than 24 buses follows nType_bus with the 
+	 * full bus set, 32 buses at a time */
+	notifyData data;
+	unsigned int w, count;
+	
+	if(mixEngine->busCount <= 24)
+		return;
+	count = (mixEngine->busCount + 31) / 32;
+	data.senderID = 0;
+	for(w=0; w<count; w++){
+		data.reference = htonl((w << 24) | (index & 0x00ffffff));
+		data.value.iVal = htonl(busset_word(routes, w));
+		notifyMakeEntry(nType_wbus, &data, sizeof(data));
+	}
+}
+
+static void inputHousekeeping(inChannel *instance, uint32_t curStatus){
+	/* we need to check for failed player loads here */
+	if((curStatus & status_loading) && instance->attached){
+		if(kill(instance->attached, 0) < 0){
+			/* the PID no loger is running... change status
+			 * to remove, and the next render cycle will 
+			 * set handle it. */
+			instance->status = status_remove; 
+			instance->attached = 0;	// to prevent doing this again.
+			char *urlstr = NULL;
+			char *logstr = NULL;
+			if(instance->UID){
+				urlstr = GetMetaData(instance->UID, "URL", 0);
+				releaseQueueEntry(instance->UID);
+			}
+			str_setstr(&logstr, "[media] -:player load failed; ");
+			if(urlstr){
+				str_appendstr(&logstr, urlstr);
+				free(urlstr);
+			}
+			serverLogMakeEntry(logstr);
+			free(logstr);
+		}
+	}
+	/* we need to check for left-over UIDs from unload player here
+	 * since releasing the UID may block */
+	if((curStatus == status_empty) && instance->UID){
+		releaseMetaRecord(instance->UID);
+		instance->UID = 0;
+	}
+	/* Likewise, if a player staus is not remove or loading, but 
+	 * it's UID is zero, then an external connection was made, 
+	 * and we should creat a UID for it here. */
+	if((curStatus & ~(status_remove | status_loading)) && !instance->UID){
+		const char** conList;
+		char *url, *name;
+		unsigned int c;
+		url = NULL;
+		name = NULL;
+		str_setstr(&url, "");
+		for(c=0; c<mixEngine->chanCount; c++){
+			pthread_mutex_lock(&mixEngine->jackMutex);
+			conList = jack_port_get_connections(instance->in_jPorts[c]);
+			pthread_mutex_unlock(&mixEngine->jackMutex);
+			if(conList){	
+				if(conList[0]){
+					// first port connection name only
+					if(strlen(url))
+						str_appendstr(&url, "&");
+					if(!name){
+						if(name = str_NthField(conList[0], ":", 0))
+							name = strdup(name);
+					}
+					str_appendstr(&url, conList[0]);
+				}
+				jack_free(conList);
+			}
+		}
+		str_insertstr(&url, "jack:///", 0);
+		instance->UID = createMetaRecord(url, NULL, 0);
+		SetMetaData(instance->UID, "Type", "jack");
+		if(name){
+			SetMetaData(instance->UID, "Name", name);
+			free(name);
+		}
+		free(url);
+	}
+}
+
 void *playerChangeWatcher(void *refCon){
 	inChannel *instance;
-	outChannel *outstance;
+	mixChange change;
 	uint32_t changed;
 	uint32_t lastBusses, curBusses, curStatus;
 	uint32_t state;
 	notifyData	data;
 	char *portName, *chanList, *mmList;
 	jack_port_t **port;
-	int i, c, cmax;
+	int i, c, n, cmax;
+	time_t now, lastScan;
 	char *triggerFile, *triggerDir, *type, *name, *end;
 
 	triggerFile = NULL;
 	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 	lastBusses = 0;
+	lastScan = 0;
 	while(dispRun){
 		triggerDir = GetMetaData(0, "file_trigger_dir", 0);
 		if(strlen(triggerDir)){
@@ -545,28 +687,161 @@ void *playerChangeWatcher(void *refCon){
 			}
 		}
 		
-		/* check input players */
-		instance = mixEngine->ins;
-		for(i=0; i<mixEngine->inCount; i++){
-			changed = instance->changed;	// the order of these two lines are important for thread safety
-			curStatus = instance->status;
-			/* check change flags */
-			if(changed){
+		/* handle the changes published by the render thread, in order */
+		while(jack_ringbuffer_read_space(mixEngine->changeQueue) >= sizeof(mixChange)){
+			jack_ringbuffer_read(mixEngine->changeQueue, (char *)&change, sizeof(mixChange));
+			changed = change.changed;
+			if(change.target == changeEngine){
+				/* handle mute group activations */
+				curBusses = change.bus;
+				if(lastBusses != curBusses){
+					if(strlen(triggerDir)){
+						// check cue
+						state = curBusses & (1L << 24);
+						if(state != (lastBusses & (1L << 24))){
+							str_setstr(&triggerFile, triggerDir);	
+							if(state){
+								str_appendstr(&triggerFile, "cue.start");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}else{
+								str_appendstr(&triggerFile, "cue.stop");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}
+							free(triggerFile);
+							triggerFile = NULL;
+						}
+			
+						// check muteA	
+						state = curBusses & (1L << 25);
+						if(state != (lastBusses & (1L << 25))){
+							str_setstr(&triggerFile, triggerDir);	
+							if(state){
+								str_appendstr(&triggerFile, "muteA.start");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}else{
+								str_appendstr(&triggerFile, "muteA.stop");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}
+							free(triggerFile);
+							triggerFile = NULL;
+						}
+			
+						// check muteB
+						state = curBusses & (1L << 26);
+						if(state != (lastBusses & (1L << 26))){
+							str_setstr(&triggerFile, triggerDir);	
+							if(state){
+								str_appendstr(&triggerFile, "muteB.start");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}else{
+								str_appendstr(&triggerFile, "muteB.stop");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}
+							free(triggerFile);
+							triggerFile = NULL;
+						}
+			
+						// check muteC
+						state = curBusses & (1L << 27);
+						if(state != (lastBusses & (1L << 27))){
+							str_setstr(&triggerFile, triggerDir);	
+							if(state){
+								str_appendstr(&triggerFile, "muteC.start");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}else{
+								str_appendstr(&triggerFile, "muteC.stop");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}
+							free(triggerFile);
+							triggerFile = NULL;
+						}
+				
+						// check TalkBack1
+						state = curBusses & (1L << 29);
+						if(state != (lastBusses & (1L << 29))){
+							str_setstr(&triggerFile, triggerDir);	
+							if(state){
+								str_appendstr(&triggerFile, "talkback1.start");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}else{
+								str_appendstr(&triggerFile, "talkback1.stop");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}
+							free(triggerFile);
+							triggerFile = NULL;
+						}
+			
+						// check TalkBack2
+						state = curBusses & (1L << 30);
+						if(state != (lastBusses & (1L << 30))){
+							str_setstr(&triggerFile, triggerDir);	
+							if(state){
+								str_appendstr(&triggerFile, "talkback2.start");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}else{
+								str_appendstr(&triggerFile, "talkback2.stop");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}
+							free(triggerFile);
+							triggerFile = NULL;
+						}
+			
+						// check TalkBack3
+						state = curBusses & (1L << 31);
+						if(state != (lastBusses & (1L << 31))){
+							str_setstr(&triggerFile, triggerDir);	
+							if(state){
+								str_appendstr(&triggerFile, "talkback3.start");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}else{
+								str_appendstr(&triggerFile, "talkback3.stop");
+								createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
+							}
+							free(triggerFile);
+							triggerFile = NULL;
+						}
+					}
+					lastBusses = curBusses;
+				}
+			}else if(change.target & changeOutGroup){
+				i = change.target & ~changeOutGroup;
+				if(i >= mixEngine->outCount)
+					continue;
+				if(changed & change_delay){
+					/* render has swapped delay lines: free the old one */
+					pthread_rwlock_wrlock(&mixEngine->outGrpLock);
+					freeRetiredDelayLines(mixEngine);
+					pthread_rwlock_unlock(&mixEngine->outGrpLock);
+					data.senderID = 0;
+					data.reference = htonl((i & 0x00ffffff) | 0xC0000000);
+					data.value.fVal = change.delay;
+					data.value.iVal = htonl(data.value.iVal);
+					notifyMakeEntry(nType_dly, &data, sizeof(data));
+				}
+				if(changed & change_bus){
+					data.senderID = 0;
+					data.reference = htonl((i & 0x00ffffff) | 0xC0000000);
+					data.value.iVal = htonl(change.bus);
+					notifyMakeEntry(nType_bus, &data, sizeof(data));
+				}
+				if(changed & change_vol){
+					data.senderID = 0;
+					data.reference = htonl((i & 0x00ffffff) | 0xC0000000);
+					data.value.fVal = change.vol;
+					data.value.iVal = htonl(data.value.iVal);
+					notifyMakeEntry(nType_vol, &data, sizeof(data));
+				}
+			}else if(change.target < mixEngine->inCount){
+				i = change.target;
+				instance = &mixEngine->ins[i];
+				curStatus = change.status;
 				if(changed & change_stat){
 					if(curStatus & status_deleteWhenDone){
 						if((curStatus & status_finished) || 
 								((curStatus & status_hasPlayed) && 
 								!(curStatus & status_playing))){
 							instance->persist = 0;
-							jack_port_t **port;
-							port = instance->in_jPorts;
-							cmax = mixEngine->chanCount;
-							pthread_mutex_lock(&mixEngine->jackMutex);
-							for(c=0; c<cmax; c++){
-								jack_port_disconnect(mixEngine->client, *port);
-								port++;
-							}
-							pthread_mutex_unlock(&mixEngine->jackMutex);
+							unloadInChan(mixEngine, i);
 						}
 					}
 					data.senderID = 0;
@@ -577,7 +852,7 @@ void *playerChangeWatcher(void *refCon){
 				if(changed & change_pos){
 					data.senderID = 0;
 					data.reference = htonl(i);
-					data.value.fVal = (float)instance->pos;
+					data.value.fVal = (float)change.pos;
 					data.value.iVal = htonl(data.value.iVal);
 					notifyMakeEntry(nType_pos, &data, sizeof(data));
 					if(instance->aplFile){
@@ -587,31 +862,33 @@ void *playerChangeWatcher(void *refCon){
 						// apl file position back to zero incase the new
 						// play position is a move back in play time.
 						rewind(instance->aplFile);
-						float pos = instance->pos;
+						float pos = change.pos;
 						if(pos <= 0.0)
 							pos = 0.1;	// prevent disallowed apl offset
 						instance->nextAplEvent = associatedPLNext(instance->aplFile, pos);
+						scheduleInChanEvents(mixEngine, instance, event_apl);
 					}
 				}
 				if(changed & change_vol){
 					data.senderID = 0;
 					data.reference = htonl(i);
-					data.value.fVal = instance->vol;
+					data.value.fVal = change.vol;
 					data.value.iVal = htonl(data.value.iVal);
 					notifyMakeEntry(nType_vol, &data, sizeof(data));
 				}
 				if(changed & change_bal){
 					data.senderID = 0;
 					data.reference = htonl(i);
-					data.value.fVal = instance->bal;
+					data.value.fVal = change.bal;
 					data.value.iVal = htonl(data.value.iVal);
 					notifyMakeEntry(nType_bal, &data, sizeof(data));
 				}
 				if(changed & (change_bus | change_mutes)){
 					data.senderID = 0;
 					data.reference = htonl(i);
-					data.value.iVal = htonl(instance->busses);
+					data.value.iVal = htonl(change.bus);
 					notifyMakeEntry(nType_bus, &data, sizeof(data));
+					notifyWideBus(i, &change.routes);
 				}
 				if(changed & change_stop){
 					/* handle stop player */
@@ -633,7 +910,7 @@ void *playerChangeWatcher(void *refCon){
 				if(changed & change_play){
 					/* handle start player */
 					if(instance->UID){
-						if(!(instance->busses & 2L)){
+						if(!(change.bus & 2L)){
 							unsigned char relog = 0;
 							// NOT in cue... proceed with logging the item play
 							if(instance->sourceType != sourceTypeCanRepos){
@@ -654,7 +931,7 @@ void *playerChangeWatcher(void *refCon){
 							// create program log entry
 							if(relog || (curStatus & status_logged) == 0){
 								instance->status = instance->status | status_logged;
-								programLogUIDEntry(instance->UID, 0, (instance->busses & 0xFF));
+								programLogUIDEntry(instance->UID, 0, (change.bus & 0xFF));
 							}
 						}
 						
@@ -681,15 +958,7 @@ void *playerChangeWatcher(void *refCon){
 								// doesn't apprear to be in the queue anymore... unload it.
 								// this can happen if an item is deleted from the list while it is loading.
 								instance->persist = 0;
-								jack_port_t **port;
-								port = instance->in_jPorts;
-								cmax = mixEngine->chanCount;
-								pthread_mutex_lock(&mixEngine->jackMutex);
-								for(c=0; c<cmax; c++){
-									jack_port_disconnect(mixEngine->client, *port);
-									port++;
-								}
-								pthread_mutex_unlock(&mixEngine->jackMutex);
+								unloadInChan(mixEngine, i);
 								// clear loaded flag
 								changed = changed & ~change_loaded;
 							}
@@ -719,16 +988,17 @@ void *playerChangeWatcher(void *refCon){
 						notifyMakeEntry(nType_status, &data, sizeof(data));
 						
 						data.reference = htonl(i);
-						data.value.fVal = instance->vol;
+						data.value.fVal = change.vol;
 						data.value.iVal = htonl(data.value.iVal);
 						notifyMakeEntry(nType_vol, &data, sizeof(data));
 						
-						data.value.fVal = instance->bal;
+						data.value.fVal = change.bal;
 						data.value.iVal = htonl(data.value.iVal);
 						notifyMakeEntry(nType_bal, &data, sizeof(data));
 
-						data.value.iVal = htonl(instance->busses);
+						data.value.iVal = htonl(change.bus);
 						notifyMakeEntry(nType_bus, &data, sizeof(data));
+						notifyWideBus(i, &change.routes);
 		
 						data.value.iVal = htonl(curStatus);
 						notifyMakeEntry(nType_pstat, &data, sizeof(data));
@@ -736,6 +1006,7 @@ void *playerChangeWatcher(void *refCon){
 				}
 				if(changed & change_unloaded){
 					/* handle unloaded player */
+					mixcarts_collect(mixEngine->carts);
 					mmList = NULL;
 					if(instance->UID){
 						// remove from playlist queue if it is in there
@@ -785,15 +1056,15 @@ void *playerChangeWatcher(void *refCon){
 						cmax = mixEngine->chanCount;
 						for(c=0; c<cmax; c++){
 							if(chanList = str_NthField(mmList, "&", c)){
-								i = 0;
-								while(portName = str_NthField(chanList, "+", i)){
+								n = 0;
+								while(portName = str_NthField(chanList, "+", n)){
 									if(strlen(portName)){
 										pthread_mutex_lock(&mixEngine->jackMutex);
 										jack_disconnect(mixEngine->client, jack_port_name(*port), portName);
 										pthread_mutex_unlock(&mixEngine->jackMutex);
 									}
 									free(portName);
-									i++;
+									n++;
 								}
 								free(chanList);
 							}
@@ -815,246 +1086,42 @@ void *playerChangeWatcher(void *refCon){
 				}
 				
 				if((changed & change_aplEvent) && (instance->aplFile)){
-					if(associatedPLLog(instance->aplFile, instance->UID, instance->busses, instance->aplFPmatch)){
+					if(associatedPLLog(instance->aplFile, instance->UID, change.bus, instance->aplFPmatch)){
 						instance->nextAplEvent = associatedPLNext(instance->aplFile, instance->nextAplEvent);
+						scheduleInChanEvents(mixEngine, instance, event_apl);
 					}
 				}
 				
 				if((changed & change_feedbus) && (instance->UID)){
-					type = ustr(instance->feedBus);
+					type = ustr(change.feedBus);
 					SetMetaData(instance->UID, "MixMinusBus", type);
 					free(type);
 				}
 				
 				if((changed & change_feedvol) && (instance->UID)){
-					type = fstr(instance->feedVol, 3);
+					type = fstr(change.feedVol, 3);
 					SetMetaData(instance->UID, "MixMinusVol", type);
 					free(type);
 				}
 				
-				/* all handled: clear flags */
-				instance->changed = 0;
-			}
-			
-			/* we need to check for failed player loads here */
-			if((curStatus & status_loading) && instance->attached){
-				if(kill(instance->attached, 0) < 0){
-					/* the PID no loger is running... change status
-					 * to remove, and the next render cycle will 
-					 * set handle it. */
-					instance->status = status_remove; 
-					instance->attached = 0;	// to prevent doing this again.
-					char *urlstr = NULL;
-					char *logstr = NULL;
-					if(instance->UID){
-						urlstr = GetMetaData(instance->UID, "URL", 0);
-						releaseQueueEntry(instance->UID);
-					}
-					str_setstr(&logstr, "[media] -:player load failed; ");
-					if(urlstr){
-						str_appendstr(&logstr, urlstr);
-						free(urlstr);
-					}
-					serverLogMakeEntry(logstr);
-					free(logstr);
-				}
+				inputHousekeeping(instance, curStatus);
 			}
-			/* we need to check for left-over UIDs from unload player here
-			 * since releasing the UID may block */
-			if((curStatus == status_empty) && instance->UID){
-				releaseMetaRecord(instance->UID);
-				instance->UID = 0;
-			}
-			/* Likewise, if a player staus is not remove or loading, but 
-			 * it's UID is zero, then an external connection was made, 
-			 * and we should creat a UID for it here. */
-			if((curStatus & ~(status_remove | status_loading)) && !instance->UID){
-				const char** conList;
-				char *url, *name;
-				unsigned int c;
-				url = NULL;
-				name = NULL;
-				str_setstr(&url, "");
-				for(c=0; c<mixEngine->chanCount; c++){
-					pthread_mutex_lock(&mixEngine->jackMutex);
-					conList = jack_port_get_connections(instance->in_jPorts[c]);
-					pthread_mutex_unlock(&mixEngine->jackMutex);
-					if(conList){	
-						if(conList[0]){
-							// first port connection name only
-							if(strlen(url))
-								str_appendstr(&url, "&");
-							if(!name){
-								if(name = str_NthField(conList[0], ":", 0))
-									name = strdup(name);
-							}
-							str_appendstr(&url, conList[0]);
-						}
-						jack_free(conList);
-					}
-				}
-				str_insertstr(&url, "jack:///", 0);
-				instance->UID = createMetaRecord(url, NULL, 0);
-				SetMetaData(instance->UID, "Type", "jack");
-				if(name){
-					SetMetaData(instance->UID, "Name", name);
-					free(name);
-				}
-				free(url);
-			}
-			
-			instance++;
 		}
 		
-		/* check output groups */
-		outstance = mixEngine->outs;
-		for(i=0; i<mixEngine->outCount; i++){
-			/* chech change flags */
-			if(changed = outstance->changed){
-				/* note: UID with top byte set to 0xC0 indicates output
-				 * group ID, not a UID.  Lower 24 bits are the output index */
-				if(changed & change_delay){
-					data.senderID = 0;
-					data.reference = htonl((i & 0x00ffffff) | 0xC0000000);
-					data.value.fVal = outstance->delay;
-					data.value.iVal = htonl(data.value.iVal);
-					notifyMakeEntry(nType_dly, &data, sizeof(data));
-				}
-				if(changed & change_bus){
-					data.senderID = 0;
-					data.reference = htonl((i & 0x00ffffff) | 0xC0000000);
-					data.value.iVal = htonl(outstance->bus);
-					notifyMakeEntry(nType_bus, &data, sizeof(data));
-				}
-				if(changed & change_vol){
-					data.senderID = 0;
-					data.reference = htonl((i & 0x00ffffff) | 0xC0000000);
-					data.value.fVal = outstance->vol;
-					data.value.iVal = htonl(data.value.iVal);
-					notifyMakeEntry(nType_vol, &data, sizeof(data));
-				}
-				/* all handled: clear flags */
-				outstance->changed = 0;
+		/* about once a second, check every input for housekeeping that 
+		 * isn't driven by a render change */
+		if((now = time(NULL)) != lastScan){
+			lastScan = now;
+			instance = mixEngine->ins;
+			for(i=0; i<mixEngine->inCount; i++){
+				inputHousekeeping(instance, instance->status);
+				instance++;
 			}
-			outstance++;
 		}
 		
-		/* handle mute group activations */
-		curBusses = mixEngine->activeBus;
-		if(lastBusses != curBusses){
-			if(strlen(triggerDir)){
-				// check cue
-				state = curBusses & (1L << 24);
-				if(state != (lastBusses & (1L << 24))){
-					str_setstr(&triggerFile, triggerDir);	
-					if(state){
-						str_appendstr(&triggerFile, "cue.start");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}else{
-						str_appendstr(&triggerFile, "cue.stop");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}
-					free(triggerFile);
-					triggerFile = NULL;
-				}
-			
-				// check muteA	
-				state = curBusses & (1L << 25);
-				if(state != (lastBusses & (1L << 25))){
-					str_setstr(&triggerFile, triggerDir);	
-					if(state){
-						str_appendstr(&triggerFile, "muteA.start");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}else{
-						str_appendstr(&triggerFile, "muteA.stop");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}
-					free(triggerFile);
-					triggerFile = NULL;
-				}
-			
-				// check muteB
-				state = curBusses & (1L << 26);
-				if(state != (lastBusses & (1L << 26))){
-					str_setstr(&triggerFile, triggerDir);	
-					if(state){
-						str_appendstr(&triggerFile, "muteB.start");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}else{
-						str_appendstr(&triggerFile, "muteB.stop");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}
-					free(triggerFile);
-					triggerFile = NULL;
-				}
-			
-				// check muteC
-				state = curBusses & (1L << 27);
-				if(state != (lastBusses & (1L << 27))){
-					str_setstr(&triggerFile, triggerDir);	
-					if(state){
-						str_appendstr(&triggerFile, "muteC.start");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}else{
-						str_appendstr(&triggerFile, "muteC.stop");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}
-					free(triggerFile);
-					triggerFile = NULL;
-				}
-				
-				// check TalkBack1
-				state = curBusses & (1L << 29);
-				if(state != (lastBusses & (1L << 29))){
-					str_setstr(&triggerFile, triggerDir);	
-					if(state){
-						str_appendstr(&triggerFile, "talkback1.start");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}else{
-						str_appendstr(&triggerFile, "talkback1.stop");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}
-					free(triggerFile);
-					triggerFile = NULL;
-				}
-			
-				// check TalkBack2
-				state = curBusses & (1L << 30);
-				if(state != (lastBusses & (1L << 30))){
-					str_setstr(&triggerFile, triggerDir);	
-					if(state){
-						str_appendstr(&triggerFile, "talkback2.start");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}else{
-						str_appendstr(&triggerFile, "talkback2.stop");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}
-					free(triggerFile);
-					triggerFile = NULL;
-				}
-			
-				// check TalkBack3
-				state = curBusses & (1L << 31);
-				if(state != (lastBusses & (1L << 31))){
-					str_setstr(&triggerFile, triggerDir);	
-					if(state){
-						str_appendstr(&triggerFile, "talkback3.start");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}else{
-						str_appendstr(&triggerFile, "talkback3.stop");
-						createTaskItem(triggerFile, loadConfigFromTask, NULL, 0, 0, 0, 0);
-					}
-					free(triggerFile);
-					triggerFile = NULL;
-				}
-			}
-			lastBusses = curBusses;
-		}
 		
 		free(triggerDir);
-		pthread_mutex_lock(&mixEngine->changedMutex);
-		pthread_cond_wait(&mixEngine->changedSemaphore, &mixEngine->changedMutex);
-		pthread_mutex_unlock(&mixEngine->changedMutex);
+		waitEventFD(mixEngine->changeFD, 1000);
 	}
 	return NULL;
 }
@@ -1139,7 +1206,7 @@ void serverLogMakeEntry(char *message){
 		localtime_r(&now, &instance->when);
 		str_setstr(&instance->message, message);
 		pthread_mutex_lock(&srvLogQueueLock);
-		if(countNodesAfter((LinkedListEntry *)&svrLogQueue) < queueMax){
+		if(countNodesAfter((LinkedListEntry *)&svrLogQueue) < logQueueMax){
 			appendNode((LinkedListEntry *)&svrLogQueue, (LinkedListEntry *)instance);
 			pthread_mutex_unlock(&srvLogQueueLock);
 			pthread_cond_signal(&srvLogSemaphore);
@@ -1172,46 +1239,72 @@ unsigned char serverLogRotateLogFile(void){
 	return result;
 }
 
+static inline notifyEntry *notifySlot(uint32_t pos){
+	return (notifyEntry *)(notifyRing + ((pos & (notifySlots - 1)) * notifySlotBytes));
+}
+
 void notifyMakeEntry(char type, void *data, unsigned short size){
-	unsigned int length;
 	notifyEntry *record;
+	uint32_t pos, seq;
+	int32_t dif;
 
-	// format and fill a notify packet
-	length = size + sizeof(notifyEntry) - 1;
-	if(record = (notifyEntry *)calloc(1, length)){
-		record->container.marker = 0;
-		record->container.type = type;
-		record->container.dataSize = size;
-		memcpy(record->container.data, data, size);
-		pthread_mutex_lock(&notifyQueueLock);
-		if(countNodesAfter((LinkedListEntry *)&notifyQueue) < queueMax){
-			appendNode((LinkedListEntry *)&notifyQueue, (LinkedListEntry *)record);
-			pthread_mutex_unlock(&notifyQueueLock);
-			pthread_cond_broadcast(&notifySemaphore);
-		}else{
-			// no room in the queue... drop record
-			pthread_mutex_unlock(&notifyQueueLock);
-			serverLogMakeEntry("[dispatch] notifyMakeEntry-notifyQueue:Queue full, entry dropped.");
-			free(record);
-		}
+	if(!notifyRing){
+		__atomic_add_fetch(&notifyStats.dropped, 1, __ATOMIC_RELAXED);
+		return;
 	}
+	if(size > notifySlotData){
+		__atomic_add_fetch(&notifyStats.oversize, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	// claim the slot at notifyEnqPos, if notifyWatcher has handed it back
+	pos = __atomic_load_n(&notifyEnqPos, __ATOMIC_RELAXED);
+	while(1){
+		record = notifySlot(pos);
+		seq = __atomic_load_n(&record->seq, __ATOMIC_ACQUIRE);
+		dif = (int32_t)(seq - pos);
+		if(dif == 0){
+			if(__atomic_compare_exchange_n(&notifyEnqPos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}else if(dif < 0){
+			// no room in the queue... drop record, counted: logging each one only adds to the load
+			__atomic_add_fetch(&notifyStats.dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}else
+			// another producer took it first
+			pos = __atomic_load_n(&notifyEnqPos, __ATOMIC_RELAXED);
+	}
+	// format and fill the notify packet in the slot, and publish it
+	record->container.marker = 0;
+	record->container.type = type;
+	record->container.dataSize = size;
+	memcpy(record->container.data, data, size);
+	__atomic_store_n(&record->seq, pos + 1, __ATOMIC_RELEASE);
+	// wake the watcher only if it's asleep, or about to be
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&notifyWaiting, __ATOMIC_RELAXED) && __atomic_exchange_n(&notifyWaiting, 0, __ATOMIC_RELAXED))
+		signalEventFD(notifyFD);
 }
 
 void *notifyWatcher(void *refCon){
 	notifyEntry *record;
-	int i, size;
+	uint32_t depth, dropped, logged;
+	time_t lastLog, now;
+	char buf[256];
+	int size;
 	unsigned char isVU;
 
 	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
-	while(dispRun){
-		pthread_mutex_lock(&notifyQueueLock);
-		while(notifyQueue){
-			record = (notifyEntry *)getNextNode((LinkedListEntry *)&notifyQueue);
-			unlinkNode((LinkedListEntry *)record, (LinkedListEntry *)&notifyQueue, 0);
-			pthread_mutex_unlock(&notifyQueueLock);
-
+	logged = 0;
+	lastLog = 0;
+	while(dispRun && notifyRing){
+		depth = __atomic_load_n(&notifyEnqPos, __ATOMIC_RELAXED) - notifyDeqPos;
+		if(depth > __atomic_load_n(&notifyStats.high, __ATOMIC_RELAXED))
+			__atomic_store_n(&notifyStats.high, depth, __ATOMIC_RELAXED);
+		// send every published notice, in order, handing each slot back a lap on
+		record = notifySlot(notifyDeqPos);
+		while(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) == (notifyDeqPos + 1)){
 			size = record->container.dataSize + 4;
 			record->container.dataSize = htons(record->container.dataSize); // size in network byte order
 			if(record->container.type == nType_vu)
@@ -1219,15 +1312,34 @@ void *notifyWatcher(void *refCon){
 			else
 				isVU = 0;
 			noticeSend((const char *)&record->container, size, isVU);
-			free(record);
-
-			pthread_mutex_lock(&notifyQueueLock);
+			__atomic_store_n(&record->seq, notifyDeqPos + notifySlots, __ATOMIC_RELEASE);
+			notifyDeqPos++;
+			__atomic_add_fetch(&notifyStats.sent, 1, __ATOMIC_RELAXED);
+			record = notifySlot(notifyDeqPos);
+		}
+		
+		// log drops as a count, at most every notifyLogSecs
+		dropped = __atomic_load_n(&notifyStats.dropped, __ATOMIC_RELAXED) + 
+					__atomic_load_n(&notifyStats.oversize, __ATOMIC_RELAXED);
+		if(dropped < logged)
+			// mixstats reset cleared the counts: count from zero again
+			logged = 0;
+		if(dropped != logged){
+			now = time(NULL);
+			if((now - lastLog) >= notifyLogSecs){
+				snprintf(buf, sizeof buf, "[dispatch] notifyWatcher-notifyQueue:%u entries dropped, queue full or entry too large.", dropped - logged);
+				serverLogMakeEntry(buf);
+				logged = dropped;
+				lastLog = now;
+			}
 		}
-		pthread_mutex_unlock(&notifyQueueLock);
 
-		pthread_mutex_lock(&notifyMutex);
-		pthread_cond_wait(&notifySemaphore, &notifyMutex);
-		pthread_mutex_unlock(&notifyMutex);
+		// sleep, unless a notice was published after the check above
+		__atomic_store_n(&notifyWaiting, 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(dispRun && (__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != (notifyDeqPos + 1)))
+			waitEventFD(notifyFD, notifyLogSecs * 1000);
+		__atomic_store_n(&notifyWaiting, 0, __ATOMIC_RELAXED);
 	}
 	return NULL;
 }
@@ -1324,7 +1436,7 @@ void programLogMakeEntry(ProgramLogRecord *entry){
 	time_t now;
 	
 	pthread_mutex_lock(&pgmLogQueueLock);
-	if(countNodesAfter((LinkedListEntry *)&pgmLogQueue) < queueMax){
+	if(countNodesAfter((LinkedListEntry *)&pgmLogQueue) < logQueueMax){
 		// NOTE: non-zero strings will be freed by the queue when done.
 		entry->when = time(NULL);
 		if(entry->UID)
@@ -1544,28 +1656,21 @@ void *programLogWatcher(void* refCon){
 }
 
 unsigned char queueControlOutPacket(mixEngineRecPtr mixRef, char type, uint32_t peer, size_t size, char *data){
+	char buf[ctl_max_packet];
+	uint16_t count;
+	
+	/* encoded into a copy: the caller's data is left as it was */
+	if((size > ctl_max_packet) || (controlPacketSize(size) > ctl_max_packet))
+		return 0;
+	count = makeControlPacket((controlPacket *)buf, type, peer, data, size);
 	pthread_mutex_lock(&mixRef->ctlOutQueueMutex);
-	uint16_t encSize = controlDataSizeFromRaw(size);
-	if((encSize <= (2048 - sizeof(controlPacket))) && (jack_ringbuffer_write_space(mixRef->ctlOutQueue) >= (encSize + sizeof(controlPacket)))){
+	if(jack_ringbuffer_write_space(mixRef->ctlOutQueue) >= count){
 		// enque packet in midi/control queue ring buffer
-		uint16_t dataSize = size;
-		uint16_t extSize = dataSize;
-		controlPacket header;
-		header.type = type;
-		header.peer = htonl(peer);
-		header.dataSize = htons(dataSize);
-		int8_t *extra = encodeControlPacket(&header, data, &extSize, NULL);
-		if(extra){
-			// don't send SysEx byte at header end.  This will be included in extra data
-			jack_ringbuffer_write(mixRef->ctlOutQueue, (char*)&header, sizeof(controlPacket)-1); 
-			jack_ringbuffer_write(mixRef->ctlOutQueue, data, dataSize);
-			jack_ringbuffer_write(mixRef->ctlOutQueue, extra, extSize); // sysex end flag added to end
-			free(extra);
-		}else
-			jack_ringbuffer_write(mixRef->ctlOutQueue, (char*)&header, sizeof(controlPacket));
+		jack_ringbuffer_write(mixRef->ctlOutQueue, buf, count);
 		pthread_mutex_unlock(&mixRef->ctlOutQueueMutex);
 		return 1;
 	}else{
+		mixRef->ctlOutDropped++;
 		pthread_mutex_unlock(&mixRef->ctlOutQueueMutex);
 		return 0;
 	}
@@ -1577,7 +1682,7 @@ void *controlQueueInWatcher(void *refCon){
 	controlPacket *packet;
 	vuNContainer *vuRecord;
 	size_t vuSize;
-	size_t size;
+	size_t size, pktSize;
 	inChannel *inchrec;
 	char *tmp, *sval;
 	time_t now;
@@ -1586,15 +1691,30 @@ void *controlQueueInWatcher(void *refCon){
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 	vuSize = 0;
 	vuRecord = NULL;
+	pktSize = 0;
+	packet = NULL;
 	while(dispRun){
 		while(1){	// loop until we break -> nothing else in queue
 			now = time(NULL);
 			// packet data is not decoded... this is stored in the ring buffer just as a raw MIDI SysEx event
-			size = jack_ringbuffer_peek(mixEngine->ctlInQueue, (char*)&header, sizeof(controlPacket));
-			if((size == sizeof(controlPacket) && decodeControlPacket(&header, 1))){
-				size = controlDataSizeFromRaw(ntohs(header.dataSize)) + sizeof(controlPacket);
+			// or raw, as forwarded from a player's shared memory control channel
+			size = jack_ringbuffer_peek(mixEngine->ctlInQueue, (char*)&header, offsetof(controlPacket, data));
+			if((size == offsetof(controlPacket, data) && ((header.sysExFlag == ctl_raw_flag) || decodeControlPacket(&header, 1)))){
+				size = anyPacketSize(&header);
 				if(jack_ringbuffer_read_space(mixEngine->ctlInQueue) >= size){
-					if(packet = calloc(1, size)){ // NULL termination if needed will over-write SysEx end flag byte
+					if(pktSize <= size){
+						// resize the reusable packet buffer if needed, with a byte to spare for raw packet null termination
+						if(packet)
+							free(packet);
+						if(packet = (controlPacket *)malloc(size + 1))
+							pktSize = size + 1;
+						else
+							pktSize = 0;
+					}
+					if(!packet)
+						// can't hold it: drop it
+						jack_ringbuffer_read_advance(mixEngine->ctlInQueue, size);
+					else{ // NULL termination if needed will over-write SysEx end flag byte
 						jack_ringbuffer_read(mixEngine->ctlInQueue, (char*)packet, size);
 						decodeControlPacket(packet, 0);
 						// convert endia-ness from network to host
@@ -1786,8 +1906,6 @@ void *controlQueueInWatcher(void *refCon){
 						if(((packet->type & cType_MASK) == cType_end) && ((packet->type & cPeer_MASK) == cPeer_recorder)){
 							releaseMetaRecord(packet->peer);
 						}
-
-						free(packet);
 					}
 				}else{
 					// nothing else to read
@@ -1798,115 +1916,12 @@ void *controlQueueInWatcher(void *refCon){
 				break;
 			}
 		}
-		pthread_mutex_lock(&mixEngine->ctlInQueueMutex);
-		pthread_cond_wait(&mixEngine->ctlInQueueSemaphore, &mixEngine->ctlInQueueMutex);
-		pthread_mutex_unlock(&mixEngine->ctlInQueueMutex);
+		waitEventFD(mixEngine->ctlInQueueFD, -1);
 	}
 	if(vuRecord)
 		free(vuRecord);
+	if(packet)
+		free(packet);
 
 	return NULL;
 }
-
-uint16_t controlDataSizeFromRaw(uint16_t byteCount){
-	// calculated a new byte size required to hold the data and additional bytes 
-	// for required encoding to pass as midi data where MSbit is always zero.
-	if(byteCount)
-		byteCount += ((byteCount - 1) / 7) + 1;
-	return byteCount;
-}
-
-char *encodeControlData(char *data, uint16_t *size, char *extraPtr){
-	// size on entry is size of data in bytes.  On return, the size of additional bytes encoded.
-	// Result is additional data bytes needed to 7 bit rncode 8 bit data. if result is not null, the memory must be freed.
-	// If extraPtr is not NULL on entry, no axtra bytes are allocated or returned, and the extar data is writen to this pointer.
-	if(!size || (*size == 0))
-		return NULL;
-	uint16_t newSize = controlDataSizeFromRaw(*size) - *size + 1; // extra byte is for the 0xF7 MIDI SysEx end flag
-	char *newData = NULL;
-	if(!extraPtr)
-		extraPtr = newData = (char *)calloc(1, newSize);
-	char *extra = extraPtr;
-	uint16_t rem = *size;
-	uint16_t bit = 0;
-	char *byte = data;
-	*extra = 0;
-	while(rem){
-		if(bit >= 7){
-			bit = 0;
-			extra++;
-			*extra = 0;
-		}
-		if(*byte & 0x80){
-			*byte = *byte & 0x7F; 	// clear top bit
-			*extra = *extra | (1 << bit);	// set corrisponding bit in current extra byte
-		}
-		bit++;
-		byte++;
-		rem--;
-	}
-	extra++;
-	*extra = 0xF7;
-	*size = newSize;
-	return newData;
-}
-
-void decodeControlData(char *data, uint16_t origSize){
-	// *data must point to origSize bytes plus extra bytes at the end needed for endoding. See controlDataSizeFromRaw()
-	uint16_t rem = origSize;
-	uint16_t bit = 0;
-	char *byte = data;
-	char *extra = data + origSize; // top bit clusters added at end of raw array
-	while(rem){
-		if(*extra & (1 << bit))
-			*byte = *byte | 0x80; 	// set top bit
-		bit++;
-		byte++;
-		rem--;
-		if(bit >= 7){
-			bit = 0;
-			extra++;
-		}
-	}
-}
-
-unsigned char decodeControlPacket(controlPacket *packet, char headerOnly){
-	if(packet->sysExFlag == 0xF0){
-		// must start with MIDI SysEx flag
-		char *byte = (char *)&packet->type;
-		char topBits = packet->topBits;
-		for(char b = 0; b < 7; b++){
-			if(topBits & (1 << b))
-				*byte = *byte | 0x80; 	// set top bit
-			byte++;
-		}
-		if(!headerOnly && packet->dataSize)
-			decodeControlData(packet->data, ntohs(packet->dataSize));
-		return true;
-	}
-	return false; // bad packet format
-}
-
-char *encodeControlPacket(controlPacket *header, char *data, uint16_t *size, char *extraPtr){
-	// size on entry is size of data in bytes.  On return, the size of additionall bytes returned.
-	// Result is additional bytes needed to 7 bit rncode 8 bit data. if result is not null, the memory must be freed.
-	// if extraPtr is not NULL, extra data will be stored in this location, and result will be NULL (No new memory 
-	// allocated needing to be freed)  NOTE: extraPtr must point to enouch memory to store the extra data.
-	char *result = NULL;
-	int8_t *byte = header->data;
-	header->topBits = 0;
-	header->sysExFlag = 0xF0;	// MIDI SysEx start flag
-	if(size && *size)
-		result = encodeControlData(data, size, extraPtr);
-	else
-		*header->data = 0xF7;	// MIDI SysEx end flag
-	byte = (char *)(&header->type);
-	for(char b=0; b < 7; b++){
-		if(*byte & 0x80){
-			*byte = *byte & 0x7F; 	// clear top bit
-			header->topBits = header->topBits | (1 << b);	// set corrisponding bit in corrisponding topBits byte
-		}
-		byte++;
-	}
-	return result;
-}
@@ -36,6 +36,7 @@ extern "C"
 #include "arserver.h"
 #include "utilities.h"
 #include "mix_engine.h"
+#include "../common/ctlcodec.h"
 
 #define 	nType_vol		0x01	// player or output volume change, ref=0xC0000000 + index for output or 0x00 + index for input/player
 #define 	nType_bal		0x02	// player balance change
@@ -50,6 +51,8 @@ extern "C"
 #define 	nType_del		0x0b	// item deleted, ref=UID
 #define 	nType_dly		0x0c	// delay setting changed - sync with current delay setting
 #define 	nType_load		0x10	// Processor load, cVal[0] = % realtime JACK load, 0.8 format
+#define 	nType_wbus		0x12	// player wide bus change, after nType_bus when there are more than 24 buses, 
+									//	ref=(word << 24) + index, iVal = buses 32 * word to 32 * word + 31
 									
 // the following are no longer used in audiorack4 
 
@@ -87,21 +90,9 @@ extern "C"
 #define cType_vol			9	// change volume - data is a float
 #define cType_lock		10	// set recorder to locked - data is empty
 #define cType_unlock		11	// set recorder to unlocked - data is empty
-#define cType_posack		12	// arServer acknowlage of pos change back to a player - data is empty
-
-typedef struct __attribute__((packed)){
-						/* Structure of contol packet: used to control/communicate with recorders and players
-						 * NOTE: packets passed as midi data via jackaudio midi API, even though the data format
-						 * is not midi.  Jack is fine with this, but don't try to connect the arserver control midi
-						 * ports to other applications that are expecting actual midi data. */
-	uint8_t			sysExFlag;
-	uint8_t			topBits;
-	uint8_t			type;
-	uint32_t			peer;		// network byte order - player input number [0,N] or recorder UID.
-	uint16_t			dataSize;	// network byte order - size, in bytes, of the raw data prior to 7 bit endoding, if any.
-	int8_t			data[1];	// network byte order or text.  Text need NOT to be null terminated
-									// due to the size (length) specified above.
-} controlPacket;
+#define cType_posack		12	// arServer acknowlage of pos change back to a player - data is the frame in the cycle the pos was taken at (int)
+
+/* controlPacket and its codec: see ../common/ctlcodec.h */
 
 typedef struct {
 		void *next;			// next record in list, or NULL for end
@@ -146,6 +137,15 @@ void shutdownDispatcherThreads(void);
 void serverLogMakeEntry(char *message);
 unsigned char serverLogRotateLogFile(void);
 
+typedef struct{
+	uint32_t high;		// atomic: most notices found queued at the start of a batch
+	uint32_t sent;		// atomic: notices sent
+	uint32_t dropped;	// atomic: notices dropped for a full ring
+	uint32_t oversize;	// atomic: notices dropped for being larger than a slot
+} notifyQueueStats;
+
+extern notifyQueueStats notifyStats;
+
 void notifyMakeEntry(char type, void *data, unsigned short size);
 
 void programLogMakeEntry(ProgramLogRecord *entry);
@@ -153,10 +153,6 @@ void programLogUIDEntry(uint32_t passUID, unsigned char Added, unsigned char Pla
 
 unsigned char queueControlOutPacket(mixEngineRecPtr mixRef, char type, uint32_t peer, size_t size, char *data);
 
-uint16_t controlDataSizeFromRaw(uint16_t byteCount);
-unsigned char decodeControlPacket(controlPacket *packet, char headerOnly);
-char *encodeControlPacket(controlPacket *header, char *data, uint16_t *size, char *extraPtr);
-
 #ifdef __cplusplus
 }
 #endif
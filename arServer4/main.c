@@ -20,6 +20,7 @@
 #include "arserver.h"
 #include "database.h"
 #include "mix_engine.h"
+#include "mixworkers.h"
 #include "session.h"
 #include "data.h"
 #include "tasks.h"
@@ -37,7 +38,7 @@
 
 
 /* program wide globals */
-unsigned int maxSessions = 25;
+unsigned int maxSessions = 0;
 const char *versionStr="4.1.3"; 
 const char *versionCR="2004-2025  Ethan Funk";
 mixEngineRecPtr mixEngine;
@@ -55,6 +56,7 @@ unsigned int chCnt;
 unsigned int inCnt;
 unsigned int outCnt;
 unsigned int busCnt;
+unsigned int mixThreads;
 char *lock_path;
 char *ourJackName;
 char *jackServer;
@@ -92,6 +94,8 @@ void HUPhandler(int sig)
 	
 	ctl_session session;
 	session.cs = STDERR_FILENO;
+	session.conn = NULL;
+	session.extFD = 0;
 	session.silent = 1;
 	session.lastPlayer = -1;
 	session.lastAID = 0;
@@ -164,6 +168,12 @@ void loadPreConfig(void)
 			}else if (strcmp(arg, "-w") == 0) {
 				// channel width specified
 				chCnt = atoi(param);
+			}else if (strcmp(arg, "-t") == 0) {
+				// mix worker thread count specified
+				mixThreads = atoi(param);
+			}else if (strcmp(arg, "-g") == 0) {
+				// huge page backed mix buffers
+				mixbuffer_hugePages = atoi(param);
 			}else if (strcmp(arg, "-j") == 0) {
 				// requested JACK name for arserver
 				str_setstr(&ourJackName, param);
@@ -227,11 +237,13 @@ int main(int argc, const char *argv[])
 			fprintf(stdout,"\t-b [audio mixing matrix bus/output count]\n");
 			fprintf(stdout,"\t-o [output group count]\n");
 			fprintf(stdout,"\t-w [channel width i.e. 2 = stereo]\n");
+			fprintf(stdout,"\t-t [mix worker thread count, to share input mixing with the JACK thread] (default 0, none)\n");
+			fprintf(stdout,"\t-g [1 to back large mix buffers with huge pages] (default 0)\n");
 			fprintf(stdout,"\t-r [/runlock/file/directory/path/] (file named ars{portNumber}.pid, and contains pid)\n");
 			fprintf(stdout,"\t-j [requested JACK name for us (arServer)]\n");
 			fprintf(stdout,"\t-s [name of JACK server to connect to]\n");
 			fprintf(stdout,"\t-x Prevent starting of default jackd audio server if jackd isn't already running\n");
-			fprintf(stdout,"\t-l [Maximum number of concurrent tcp listening command connections]\n"); 
+			fprintf(stdout,"\t-l [Maximum number of concurrent tcp listening command connections] (default 0, no limit)\n"); 
 			fprintf(stdout,"\t<none> uses defaults:\n");
 			fprintf(stdout,"\t\tcontrol tcp port (9550)\n");
 			fprintf(stdout,"\t\tJack name ars<control port number>\n");
@@ -422,6 +434,7 @@ int main(int argc, const char *argv[])
 	inCnt = 10;
 	outCnt = 6;
 	busCnt = 4;
+	mixThreads = 0;
 	
 	lock_path = NULL;
 	wdir_path = NULL;
@@ -474,6 +487,16 @@ int main(int argc, const char *argv[])
 			i = i + 1;
 			inCnt = atoi(argv[i]);
 			i = i + 1;
+		}else if(strcmp(argv[i], "-t") == 0) {
+			// mix worker thread count specified
+			i = i + 1;
+			mixThreads = atoi(argv[i]);
+			i = i + 1;
+		}else if(strcmp(argv[i], "-g") == 0) {
+			// huge page backed mix buffers
+			i = i + 1;
+			mixbuffer_hugePages = atoi(argv[i]);
+			i = i + 1;
 		}else if(strcmp(argv[i], "-o") == 0) {
 			// output count specified
 			i = i + 1;
@@ -596,7 +619,10 @@ int main(int argc, const char *argv[])
 		write(STDERR_FILENO, "\n", 1);
 		goto fail;
 	}
-	snprintf(command, sizeof command, "listening on port %d, max connections = %d\n", tcpPort, maxSessions);
+	if(maxSessions)
+		snprintf(command, sizeof command, "listening on port %d, max connections = %d\n", tcpPort, maxSessions);
+	else
+		snprintf(command, sizeof command, "listening on port %d, max connections = no limit\n", tcpPort);
 	write(STDERR_FILENO, command, strlen(command));
 	
 	if(strlen(ourJackName) == 0){
@@ -616,8 +642,15 @@ int main(int argc, const char *argv[])
 		write(STDERR_FILENO, "\n", 1);
 		goto fail;
 	}else{
-		err = "Audio engine started.\n";
-		write(STDERR_FILENO, err, strlen(err));
+		snprintf(command, sizeof command, "Audio engine started, using %s mix kernels.\n", mixKernels.name);
+		write(STDERR_FILENO, command, strlen(command));
+		if(mixThreads){
+			if(err = mixworkers_init(mixEngine, mixThreads, jack_get_buffer_size(mixEngine->client)))
+				snprintf(command, sizeof command, "Mix worker threads not started (%s): mixing on the JACK thread only.\n", err);
+			else
+				snprintf(command, sizeof command, "Mixing with %u worker threads.\n", mixThreads);
+			write(STDERR_FILENO, command, strlen(command));
+		}
 	}
 	
 	initDispatcherThreads();
@@ -633,6 +666,8 @@ int main(int argc, const char *argv[])
 	write(STDERR_FILENO, command, strlen(command));
 	ctl_session session;
 	session.cs = 0;
+	session.conn = NULL;
+	session.extFD = 0;
 	session.silent = 1;
 	session.lastPlayer = -1;
 	session.lastAID = 0;
@@ -1038,6 +1038,16 @@ void GetURLMetaData(uint32_t UID, const char *url){
 		}else if(!strcmp(type, "gst")){
 			SetMetaData(UID, "Name", "custom gstreamer pipeline player");
 			SetMetaData(UID, "Missing", "0");
+		}else if(!strcmp(type, "mem")){
+			// RAM resident cart: the meta data of the url it holds
+			char *tmp, *inner;
+			if(tmp = str_NthField(url, ":///", 1)){
+				inner = uriDecode(tmp);
+				free(tmp);
+				GetURLMetaData(UID, inner);
+				free(inner);
+			}
+			SetMetaData(UID, "Type", type);
 		}else if(!strcmp(type, "sip")){
 			SetMetaData(UID, "Name", "sip URLs are not loadable directly");
 			SetMetaData(UID, "Missing", "1");
@@ -1221,6 +1231,7 @@ uint32_t LoadJackPlayer(int pNum, const char *url_str, uint32_t UID){
 	
 	instance->fadePos = GetMetaFloat(instance->UID, "FadeOut", NULL);
 	instance->fadeTime = GetMetaFloat(instance->UID, "FadeTime", NULL);
+	scheduleInChanEvents(mixEngine, instance, event_fade | event_fadeTime);
 		
 	/* make jack connections */
 	if(portList = str_NthField(url_str, ":///", 1)){
@@ -1308,6 +1319,7 @@ uint32_t LoadInputPlayer(int pNum, const char *url_str, uint32_t UID){
 
 	instance->fadePos = GetMetaFloat(locUID, "FadeOut", NULL);
 	instance->fadeTime = GetMetaFloat(locUID, "FadeTime", NULL);
+	scheduleInChanEvents(mixEngine, instance, event_fade | event_fadeTime);
 	
 	/* make jack connections */
 	if(tmp = str_NthField(url_str, ":///", 1)){
@@ -1395,13 +1407,34 @@ uint32_t LoadInputPlayer(int pNum, const char *url_str, uint32_t UID){
 	return result;
 }
 
+/* With the ctl_shm setting on, make a shared memory control channel for 
+ * the player about to be launched on input pNum, and give it to render.  
+ * Returns the channel fd for the child to pass on, or -1 to keep to MIDI 
+ * control. */
+static int playerCtlChannel(int pNum){
+	ctlShm *shm;
+	int fd;
+	
+	if(!GetMetaInt(0, "ctl_shm", NULL))
+		return -1;
+	if(!(shm = ctlshm_create(&fd))){
+		serverLogMakeEntry("[media] LoadPlayer-: shared memory control channel failed; using MIDI control");
+		return -1;
+	}
+	if(!setInChanCtl(mixEngine, pNum, shm)){
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
 uint32_t LoadURLPlayer(int pNum, const char *url_str, uint32_t UID){
 	inChannel *instance;
 	char command[1024];
 	char *tmp;
 	float vol;	
 	char *wdir, *bin;
-	int i, fd;
+	int i, fd, shmFD, keepFD;
 	uint32_t locUID, result, controls;
 	
 	struct execRec{
@@ -1473,11 +1506,17 @@ uint32_t LoadURLPlayer(int pNum, const char *url_str, uint32_t UID){
 	
 	instance->fadePos = GetMetaFloat(instance->UID, "FadeOut", NULL);
 	instance->fadeTime = GetMetaFloat(instance->UID, "FadeTime", NULL);
+	scheduleInChanEvents(mixEngine, instance, event_fade | event_fadeTime);
 	
 	// fork and execute;
-	if((recPtr->child = fork()) < 0)
+	shmFD = playerCtlChannel(pNum);
+	if((recPtr->child = fork()) < 0){
+		if(shmFD >= 0){
+			setInChanCtl(mixEngine, pNum, NULL);
+			close(shmFD);
+		}
 		goto end;
-	else if(recPtr->child == 0){
+	}else if(recPtr->child == 0){
 		// We are the forked child
 		
 		// set working dir as determined at arserver startup
@@ -1500,9 +1539,11 @@ uint32_t LoadURLPlayer(int pNum, const char *url_str, uint32_t UID){
 			dup2(fd, STDERR_FILENO);
 			close(fd);
 		}
+		// pass on the control channel, if any
+		keepFD = ctlshm_pass(shmFD);
 		// close all other file descriptors
 		for(fd=(getdtablesize()-1); fd >= 0; --fd){
-			if((fd != STDERR_FILENO) && (fd != STDIN_FILENO) && (fd != STDOUT_FILENO))
+			if((fd != STDERR_FILENO) && (fd != STDIN_FILENO) && (fd != STDOUT_FILENO) && (fd != keepFD))
 				close(fd); // close all descriptors we are not interested in
 		}
 		// unblock all signals and set to default handlers
@@ -1526,6 +1567,8 @@ uint32_t LoadURLPlayer(int pNum, const char *url_str, uint32_t UID){
 		exit(0);
 	}
 	// Continuation of the parent here...
+	if(shmFD >= 0)
+		close(shmFD);
 
 	instance->attached = recPtr->child;
 
@@ -1554,7 +1597,7 @@ uint32_t LoadGSTPlayer(int pNum, const char *url_str, uint32_t UID){
 	char *tmp, *pipeline;
 	float vol;	
 	char *wdir, *bin;
-	int i, fd;
+	int i, fd, shmFD, keepFD;
 	uint32_t locUID, result, controls;
 	
 	struct execRec{
@@ -1631,11 +1674,17 @@ uint32_t LoadGSTPlayer(int pNum, const char *url_str, uint32_t UID){
 		
 		instance->fadePos = GetMetaFloat(instance->UID, "FadeOut", NULL);
 		instance->fadeTime = GetMetaFloat(instance->UID, "FadeTime", NULL);
+		scheduleInChanEvents(mixEngine, instance, event_fade | event_fadeTime);
 		
 		// fork and execute;
-		if((recPtr->child = fork()) < 0)
+		shmFD = playerCtlChannel(pNum);
+		if((recPtr->child = fork()) < 0){
+			if(shmFD >= 0){
+				setInChanCtl(mixEngine, pNum, NULL);
+				close(shmFD);
+			}
 			goto end;
-		else if(recPtr->child == 0){
+		}else if(recPtr->child == 0){
 			// We are the forked child
 			
 			// set working dir as determined at arserver startup
@@ -1658,9 +1707,11 @@ uint32_t LoadGSTPlayer(int pNum, const char *url_str, uint32_t UID){
 				dup2(fd, STDERR_FILENO);
 				close(fd);
 			}
+			// pass on the control channel, if any
+			keepFD = ctlshm_pass(shmFD);
 			// close all other file descriptors
 			for(fd=(getdtablesize()-1); fd >= 0; --fd){
-				if((fd != STDERR_FILENO) && (fd != STDIN_FILENO) && (fd != STDOUT_FILENO))
+				if((fd != STDERR_FILENO) && (fd != STDIN_FILENO) && (fd != STDOUT_FILENO) && (fd != keepFD))
 					close(fd); // close all descriptors we are not interested in
 			}
 			// unblock all signals and set to default handlers
@@ -1684,6 +1735,8 @@ uint32_t LoadGSTPlayer(int pNum, const char *url_str, uint32_t UID){
 			exit(0);
 		}
 		// Continuation of the parent here...
+		if(shmFD >= 0)
+			close(shmFD);
 	}
 	instance->attached = recPtr->child;
 	result = locUID;
@@ -1706,6 +1759,165 @@ end:
 	return result;
 }
 
+struct cartDecode{
+	jack_default_audio_sample_t *samples;	// interleaved
+	size_t frames;
+	size_t space;
+	size_t max;
+	unsigned int chanCount;
+	unsigned char failed;
+};
+
+static void cartHandoff(GstElement *sink, GstBuffer *buffer, GstPad *pad, gpointer user_data){
+	struct cartDecode *dec = (struct cartDecode *)user_data;
+	jack_default_audio_sample_t *grown;
+	GstMapInfo map;
+	size_t frames, space;
+	
+	if(dec->failed || !gst_buffer_map(buffer, &map, GST_MAP_READ))
+		return;
+	frames = map.size / (sizeof(jack_default_audio_sample_t) * dec->chanCount);
+	if((dec->frames + frames) > dec->space){
+		space = dec->space * 2;
+		if(space < (dec->frames + frames))
+			space = dec->frames + frames;
+		if(space > dec->max)
+			space = dec->max;
+		if(((dec->frames + frames) > space) || ((grown = (jack_default_audio_sample_t *)realloc(dec->samples, 
+							space * dec->chanCount * sizeof(jack_default_audio_sample_t))) == NULL)){
+			/* too long for a cart, or out of memory: stop the decode */
+			dec->failed = 1;
+			gst_element_post_message(sink, gst_message_new_application(GST_OBJECT(sink), NULL));
+			gst_buffer_unmap(buffer, &map);
+			return;
+		}
+		dec->samples = grown;
+		dec->space = space;
+	}
+	memcpy(dec->samples + (dec->frames * dec->chanCount), map.data, 
+						frames * dec->chanCount * sizeof(jack_default_audio_sample_t));
+	dec->frames = dec->frames + frames;
+	gst_buffer_unmap(buffer, &map);
+}
+
+/* Decode url into the cart pool, at the mixer sample rate and channel 
+ * count, or find it there if it has been decoded already.  The item 
+ * returned is held for the caller. */
+static cartItem *getCartItem(const char *url){
+	GstElement *pipeline, *src, *sink;
+	GstMessage *msg;
+	GstBus *bus;
+	struct cartDecode dec;
+	cartItem *item;
+	char desc[512];
+	
+	if(item = mixcarts_find(mixEngine->carts, url))
+		return item;
+	
+	memset(&dec, 0, sizeof(dec));
+	dec.chanCount = mixEngine->chanCount;
+	dec.max = (size_t)mixcart_max_seconds * mixEngine->mixerSampleRate;
+	snprintf(desc, sizeof desc, "uridecodebin name=src ! audioconvert ! audioresample ! "
+				"audio/x-raw,format=%s,layout=interleaved,rate=%u,channels=%u ! "
+				"fakesink name=sink signal-handoffs=true sync=false", 
+				(G_BYTE_ORDER == G_LITTLE_ENDIAN) ? "F32LE" : "F32BE",
+				mixEngine->mixerSampleRate, mixEngine->chanCount);
+	if((pipeline = gst_parse_launch(desc, NULL)) == NULL)
+		return NULL;
+	src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+	sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+	if(src && sink){
+		g_object_set(src, "uri", url, NULL);
+		g_signal_connect(sink, "handoff", G_CALLBACK(cartHandoff), &dec);
+		bus = gst_element_get_bus(pipeline);
+		if(gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE){
+			msg = gst_bus_timed_pop_filtered(bus, 60 * GST_SECOND, 
+						GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_APPLICATION);
+			if(msg){
+				if((GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS) && !dec.failed && dec.frames)
+					item = mixcarts_add(mixEngine->carts, url, dec.samples, dec.frames);
+				gst_message_unref(msg);
+			}
+		}
+		gst_element_set_state(pipeline, GST_STATE_NULL);
+		gst_object_unref(bus);
+	}
+	if(src)
+		gst_object_unref(src);
+	if(sink)
+		gst_object_unref(sink);
+	gst_object_unref(pipeline);
+	if(dec.samples)
+		free(dec.samples);
+	return item;
+}
+
+uint32_t LoadMemPlayer(int pNum, const char *url_str, uint32_t UID){
+	inChannel *instance;
+	cartItem *item;
+	char *tmp, *url;
+	double val;
+	uint32_t locUID, result, controls;
+	int mb;
+	
+	result = 0;
+	instance = &mixEngine->ins[pNum];
+
+	if(UID == 0){
+		locUID = createMetaRecord(url_str, NULL, 0);
+		GetURLMetaData(locUID, url_str);
+	}else{ 
+		locUID = UID;
+		retainMetaRecord(UID);
+	}
+	instance->UID = locUID;
+	
+	if((mb = GetMetaInt(0, "cart_pool_mb", NULL)) > 0)
+		mixcarts_setLimit(mixEngine->carts, (size_t)mb << 20);
+	item = NULL;
+	if(tmp = str_NthField(url_str, ":///", 1)){
+		url = uriDecode(tmp);
+		free(tmp);
+		item = getCartItem(url);
+		free(url);
+	}
+	if(item){
+		// set up mixer channel
+		instance->busses = GetMetaInt(instance->UID, "def_bus", NULL);
+		if(instance->busses == 0)
+			instance->busses = def_busses;
+
+		val = GetMetaFloat(instance->UID, "Volume", NULL);
+		if((val == 0.0) || (val > 10)) 
+			val = def_vol;
+		instance->vol = val;
+		
+		tmp = GetMetaData(instance->UID, "Controls", 0);
+		controls = strtoul(tmp, NULL, 16);
+		free(tmp);
+		tmp = hstr(controls | ctl_vol | ctl_pos | ctl_fade, 8);
+		SetMetaData(instance->UID, "Controls", tmp); 
+		free(tmp);
+		
+		instance->fadePos = GetMetaFloat(instance->UID, "FadeOut", NULL);
+		instance->fadeTime = GetMetaFloat(instance->UID, "FadeTime", NULL);
+		scheduleInChanEvents(mixEngine, instance, event_fade | event_fadeTime);
+		
+		// render plays the item: it is ready as soon as render takes it
+		setInChanCart(mixEngine, pNum, item);
+		result = locUID;
+	}else{
+		tmp = NULL;
+		str_setstr(&tmp, "[media] LoadMemPlayer-:cart decode failed; ");
+		str_appendstr(&tmp, url_str);
+		serverLogMakeEntry(tmp);
+		free(tmp);
+		setInChanToDefault(instance);
+		instance->status = status_empty;
+	}
+	return result;
+}
+
 uint32_t LoadDBItemPlayer(int *pNum, const char *url_str, uint32_t UID){
 	uint32_t localUID;
 	char *tmp;
@@ -1842,6 +2054,8 @@ uint32_t LoadPlayer(int *pNum, const char *url_str, uint32_t UID, unsigned char
 			result = LoadJackPlayer(*pNum, url_str, UID);
 		else if(!strcmp(type, "gst"))
 			result = LoadGSTPlayer(*pNum, url_str, UID);
+		else if(!strcmp(type, "mem"))
+			result = LoadMemPlayer(*pNum, url_str, UID);
 		else if(!strcmp(type, "item"))
 			result = LoadDBItemPlayer(pNum, url_str, UID); // note: passing pNum as pointer here
 		else
@@ -1871,6 +2085,7 @@ uint32_t LoadPlayer(int *pNum, const char *url_str, uint32_t UID, unsigned char
 					// find the next record after 0.1 sec, used to exclude any
 					// eronious item at 0.0 second offset (invalid offset time)
 					instance->nextAplEvent = associatedPLNext(instance->aplFile, 0.1);
+					scheduleInChanEvents(mixEngine, instance, event_apl);
 				}
 			}
 			
@@ -16,19 +16,33 @@
  DEALINGS IN THE SOFTWARE.
 */
 
-#define mix_buffer_durration	16 /* minimum length (seconds) of mix buffers */
-#define	ctlQueueSizeBytes 	64 * 1024  /* control packet queue size in bytes */
+#define mix_bus_frames	4096 /* minimum size (frames) of the per cycle bus buffers */
+#define mix_delay_max	16.0 /* maximum output group delay, seconds */
+#define retiredLinesSize	256	/* delay lines that can wait to be freed */
+#define retiredChainsSize	256	/* dsp chains that can wait to be freed */
+#define retiredCtlsSize	256	/* player control channels that can wait to be freed */
+#define	ctlQueueSizeBytes 	256 * 1024  /* control packet queue size in bytes: room for a few full size raw packets */
+#define	cmdQueueSize 	4096  /* mixer command queue size in records */
+#define	cmdHeldSize 	256  /* timed commands render can hold for later cycles */
+#define	cmdQueueWait 	100  /* ms an app thread will wait for command queue space */
+#define	changeQueueSize 	4096  /* render change queue size in records */
 
 #include "mix_engine.h"
 #include "arserver.h"
 #include "dispatch.h"
+#include "mixworkers.h"
+#include "mixstats.h"
 #include <math.h>
 #include <pthread.h>
 #include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 
 float def_vol;				// default scalar gain
 unsigned int def_busses;	// default bus settings
 float def_bal;				// default balance
+static float muteGain[256];	// output group gain for each mute level: (level / 255) cubed
 
 void clearCBQ(callbackQueue *Q){
 	pthread_spin_lock(&Q->spinlock);
@@ -65,6 +79,38 @@ unsigned char putCBQitem(callbackQueue *Q, jack_port_id_t ID){
 	return 1;
 }
 
+/* wake a thread waiting on an eventfd: safe to call from the render thread */
+void signalEventFD(int fd){
+	uint64_t one = 1;
+	
+	if(write(fd, &one, sizeof(one)) < 0){
+		/* counter overflow only: the waiter is already due to wake */
+	}
+}
+
+/* wait up to timeout ms (-1 for no timeout) for an eventfd to be signaled, 
+ * and reset it.  Returns true if signaled. */
+unsigned char waitEventFD(int fd, int timeout){
+	struct pollfd pfd;
+	uint64_t count;
+	
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	if(poll(&pfd, 1, timeout) <= 0)
+		return 0;
+	if(read(fd, &count, sizeof(count)) != sizeof(count))
+		return 0;
+	return 1;
+}
+
+static unsigned char publishChange(mixEngineRecPtr mixEngineRef, mixChange *change){
+	/* render thread only */
+	if(jack_ringbuffer_write_space(mixEngineRef->changeQueue) < sizeof(mixChange))
+		return 0;
+	jack_ringbuffer_write(mixEngineRef->changeQueue, (char *)change, sizeof(mixChange));
+	return 1;
+}
+
 unsigned char checkPnumber(int pNum)
 {
 	if(pNum < 0)
@@ -74,7 +120,14 @@ unsigned char checkPnumber(int pNum)
 	return 1;
 }
 
-/* 3 JACK callbacks for the condition stated in the function name */
+/* JACK callbacks for the condition stated in the function name */
+int jack_xrun_callback(void *arg){
+	mixEngineRecPtr mixEngineRef = (mixEngineRecPtr)arg;
+	
+	mixstats_xrun(mixEngineRef->stats, __atomic_load_n(&mixEngineRef->frameClock, __ATOMIC_RELAXED));
+	return 0;
+}
+
 void jack_shutdown_callback(void *arg){
 	mixEngineRecPtr mixEngineRef = (mixEngineRecPtr)arg;
 	
@@ -119,12 +172,12 @@ static void jack_rename_callback(jack_port_id_t port_id, const char *old_name, c
 }
 
 void setInChanToDefault(inChannel *chrec){
-	chrec->isConnected = 0;
 	chrec->vol = def_vol;		// default scalar gain
 	chrec->busses = def_busses;	// default bus settings
+	busset_zero(&chrec->routes);	// buses 0-23 follow busses
 	chrec->feedBus = 0;
 	chrec->feedVol = 1.0;
-	chrec->bal = def_bal;		// default balance value
+	setInChanBal(chrec, def_bal);		// default balance value
 	chrec->posack = 0;
 	chrec->segNext = 0;
 	chrec->posSeg = 0.0;
@@ -137,6 +190,13 @@ void setInChanToDefault(inChannel *chrec){
 	chrec->managed	= 0;
 }
 
+/* sets the balance of an input, with it's pan law gains */
+void setInChanBal(inChannel *chrec, float bal){
+	chrec->bal = bal;
+	chrec->panLeft = sqrt(1.0 - bal);
+	chrec->panRight = sqrt(1.0 + bal);
+}
+
 void setAllUnloadedToDefault(mixEngineRecPtr mixRef){
 	inChannel *chrec = mixRef->ins;
 	unsigned int i, incnt;
@@ -148,26 +208,1057 @@ void setAllUnloadedToDefault(mixEngineRecPtr mixRef){
 	}
 }
 
+static void clearInChanEvents(inChannel *chrec){
+	/* render thread only */
+	chrec->evSegue = -1;
+	chrec->evFade = -1;
+	chrec->evFadeTime = -1;
+	chrec->evApl = -1;
+	chrec->evSegNext = 0;
+	chrec->evSegLevel = 0.0;
+	chrec->fading = 0;
+	chrec->fadeOffset = 0;
+}
+
+/**
+ * Queue a command for the render thread, which applies queued commands in 
+ * order at the start of a cycle, or at the cycle containing the frameClock 
+ * frame cmd->when, if set.  Called from app threads: waits a while for space 
+ * if the queue is full.  Returns the sequence number given to the command, 
+ * to check for with mixCommandDone(), or zero if the command was dropped.
+ */
+uint32_t queueMixCommand(mixEngineRecPtr mixEngineRef, mixCommand *cmd){
+	uint32_t seq;
+	int tries;
+	
+	seq = 0;
+	for(tries=0; tries<cmdQueueWait; tries++){
+		pthread_mutex_lock(&mixEngineRef->cmdQueueMutex);
+		if(jack_ringbuffer_write_space(mixEngineRef->cmdQueue) >= sizeof(mixCommand)){
+			seq = ++mixEngineRef->cmdSeq;
+			if(seq == 0)
+				// zero is reserved for a dropped command
+				seq = ++mixEngineRef->cmdSeq;
+			cmd->seq = seq;
+			jack_ringbuffer_write(mixEngineRef->cmdQueue, (char *)cmd, sizeof(mixCommand));
+		}
+		pthread_mutex_unlock(&mixEngineRef->cmdQueueMutex);
+		if(seq)
+			return seq;
+		usleep(1000);
+	}
+	serverLogMakeEntry("[mixer] queueMixCommand-:command queue full; command dropped");
+	return 0;
+}
+
+uint32_t sendMixCommand(mixEngineRecPtr mixEngineRef, uint32_t type, unsigned int target, uint32_t iVal, float fVal){
+	mixCommand cmd;
+	
+	cmd.type = type;
+	cmd.target = target;
+	cmd.iVal = iVal;
+	cmd.fVal = fVal;
+	cmd.frame = -1;
+	cmd.when = 0;
+	cmd.ptr = NULL;
+	return queueMixCommand(mixEngineRef, &cmd);
+}
+
+/* true once render has taken command seq off the queue */
+unsigned char mixCommandDone(mixEngineRecPtr mixEngineRef, uint32_t seq){
+	return (int32_t)(__atomic_load_n(&mixEngineRef->cmdAck, __ATOMIC_ACQUIRE) - seq) >= 0;
+}
+
+/**
+ * Free the delay lines render has swapped out.  
+ * NOTE: app threads only, with outGrpLock write locked.
+ */
+void freeRetiredDelayLines(mixEngineRecPtr mixEngineRef){
+	mixbuffer_t *line;
+	
+	while(jack_ringbuffer_read(mixEngineRef->retiredLines, (char *)&line, sizeof(line)) == sizeof(line))
+		mixbuffer_free(line);
+}
+
+/**
+ * Free the dsp chains render has swapped out.  
+ * NOTE: app threads only, with outGrpLock write locked.
+ */
+static void freeRetiredDspChains(mixEngineRecPtr mixEngineRef){
+	dspChain *chain;
+	
+	while(jack_ringbuffer_read(mixEngineRef->retiredChains, (char *)&chain, sizeof(chain)) == sizeof(chain))
+		mixdsp_free(chain);
+}
+
+/**
+ * Free the player control channels render has swapped out.  Called from 
+ * app threads.
+ */
+static void freeRetiredCtls(mixEngineRecPtr mixEngineRef){
+	ctlShm *shm;
+	
+	pthread_mutex_lock(&mixEngineRef->retiredCtlsMutex);
+	while(jack_ringbuffer_read(mixEngineRef->retiredCtls, (char *)&shm, sizeof(shm)) == sizeof(shm))
+		ctlshm_free(shm);
+	pthread_mutex_unlock(&mixEngineRef->retiredCtlsMutex);
+}
+
+/* Render thread: swap in a new dsp chain, retiring the old one for app 
+ * threads to free.  If the retired queue is full, the old chain is lost 
+ * rather than freed while in use. */
+static void swapDspChain(mixEngineRecPtr mixEngineRef, dspChain **slot, dspChain *chain){
+	if(*slot != chain){
+		if(*slot && (jack_ringbuffer_write_space(mixEngineRef->retiredChains) >= sizeof(dspChain *)))
+			jack_ringbuffer_write(mixEngineRef->retiredChains, (char *)slot, sizeof(dspChain *));
+		*slot = chain;
+	}
+}
+
+/* Make the chain for spec, or no chain for an empty spec, and send it to 
+ * render with a cmd_outDsp or cmd_busDsp command.  On success, *saved is 
+ * replaced with a copy of spec. */
+static const char *sendDspChain(mixEngineRecPtr mixEngineRef, uint32_t type, 
+							unsigned int target, const char *spec, char **saved){
+	dspChain *chain;
+	mixCommand cmd;
+	const char *err;
+	
+	freeRetiredDspChains(mixEngineRef);
+	chain = NULL;
+	if(spec && strlen(spec)){
+		if((chain = mixdsp_create(spec, mixEngineRef->chanCount, mixEngineRef->mixerSampleRate, 
+						mixEngineRef->busFrames, &err)) == NULL)
+			return err;
+	}
+	cmd.type = type;
+	cmd.target = target;
+	cmd.iVal = 0;
+	cmd.fVal = 0.0;
+	cmd.frame = -1;
+	cmd.when = 0;
+	cmd.ptr = chain;
+	if(!queueMixCommand(mixEngineRef, &cmd)){
+		mixdsp_free(chain);
+		return "mix command queue full";
+	}
+	if(*saved)
+		free(*saved);
+	*saved = NULL;
+	if(chain)
+		*saved = strdup(spec);
+	return NULL;
+}
+
+/**
+ * Set the insert processing of output group out from a mixdsp spec string, 
+ * run after the output group volume.  An empty or NULL spec removes it.  
+ * Returns an error string on failure, NULL on success.
+ * NOTE: app threads only, with outGrpLock write locked.
+ */
+const char *setOutputDsp(mixEngineRecPtr mixEngineRef, unsigned int out, const char *spec){
+	if(out >= mixEngineRef->outCount)
+		return "bad output group";
+	return sendDspChain(mixEngineRef, cmd_outDsp, out, spec, &mixEngineRef->outs[out].dspSpec);
+}
+
+/**
+ * Set the insert processing of mix bus bus, as for setOutputDsp().  The 
+ * chain runs on the bus sum, before the bus feeds any other bus, output 
+ * group or mix-minus feed.
+ * NOTE: app threads only, with outGrpLock write locked.
+ */
+const char *setBusDsp(mixEngineRecPtr mixEngineRef, unsigned int bus, const char *spec){
+	if(bus >= mixEngineRef->busCount)
+		return "bad bus number";
+	return sendDspChain(mixEngineRef, cmd_busDsp, bus, spec, &mixEngineRef->busDspSpecs[bus]);
+}
+
+/**
+ * Set the delay of output group out, in seconds.  The delay history is 
+ * allocated here, sized for the delay, and handed to render with the 
+ * command.  Render swaps it in and retires the old line for app threads 
+ * to free.  Undelayed output groups have no delay line at all.
+ * NOTE: app threads only, with outGrpLock write locked.
+ */
+void setOutputDelay(mixEngineRecPtr mixEngineRef, unsigned int out, float delay){
+	outChannel *outchrec;
+	mixbuffer_t *line;
+	mixCommand cmd;
+	size_t size, frames;
+	
+	if(out >= mixEngineRef->outCount)
+		return;
+	freeRetiredDelayLines(mixEngineRef);
+	outchrec = &mixEngineRef->outs[out];
+	if(delay < 0.0)
+		delay = 0.0;
+	if(delay > mix_delay_max)
+		delay = mix_delay_max;
+	frames = mixEngineRef->busFrames;
+	size = delay * mixEngineRef->mixerSampleRate;
+	line = outchrec->sentDelayLine;
+	if(size == 0)
+		line = NULL;
+	else if(!line || (line->bufSizeSamples < (size + frames)) || 
+								(line->bufSizeSamples > (4 * (size + frames)))){
+		/* no line, or the line is too short, or much too long for the delay */
+		if((line = mixbuffer_create(size + frames, mixEngineRef->chanCount, 1, NULL)) == NULL){
+			serverLogMakeEntry("[mixer] setOutputDelay-:delay line allocation failed; delay unchanged");
+			return;
+		}
+	}
+	cmd.type = cmd_outDelay;
+	cmd.target = out;
+	cmd.iVal = 0;
+	cmd.fVal = delay;
+	cmd.frame = -1;
+	cmd.when = 0;
+	cmd.ptr = line;
+	if(queueMixCommand(mixEngineRef, &cmd)){
+		outchrec->sentDelayLine = line;
+		outchrec->sentDelay = delay;
+	}else if(line && (line != outchrec->sentDelayLine))
+		mixbuffer_free(line);
+}
+
+/**
+ * Pass the segue, fade and APL event times of an input, as just set in the 
+ * input record by an app thread, on to the render thread.  Events are given 
+ * as bits of the event_ values.  Play position times are converted to sample 
+ * frames, and fadeTime (wall clock) to a frameClock frame, so render can act 
+ * on each at the exact frame within a cycle without checking the time.
+ */
+void scheduleInChanEvents(mixEngineRecPtr mixEngineRef, inChannel *chrec, uint32_t events){
+	mixCommand cmd;
+	struct timeval now;
+	double rate, wait;
+	
+	rate = mixEngineRef->mixerSampleRate;
+	cmd.target = chrec - mixEngineRef->ins;
+	cmd.when = 0;
+	cmd.ptr = NULL;
+	cmd.iVal = 0;
+	cmd.fVal = 0.0;
+	if(events & event_segue){
+		cmd.type = cmd_inSegue;
+		cmd.frame = -1;
+		if(chrec->segNext && chrec->posSeg){
+			cmd.frame = llround(chrec->posSeg * rate);
+			cmd.iVal = chrec->segNext;
+			cmd.fVal = chrec->levelSeg;
+		}
+		queueMixCommand(mixEngineRef, &cmd);
+		cmd.iVal = 0;
+		cmd.fVal = 0.0;
+	}
+	if(events & event_fade){
+		cmd.type = cmd_inFade;
+		cmd.frame = -1;
+		if(chrec->fadePos)
+			cmd.frame = llround(chrec->fadePos * rate);
+		queueMixCommand(mixEngineRef, &cmd);
+	}
+	if(events & event_fadeTime){
+		cmd.type = cmd_inFadeTime;
+		cmd.frame = -1;
+		if(chrec->fadeTime){
+			gettimeofday(&now, NULL);
+			wait = (double)chrec->fadeTime - ((double)now.tv_sec + now.tv_usec / 1000000.0);
+			if(wait < 0.0)
+				wait = 0.0;
+			cmd.frame = __atomic_load_n(&mixEngineRef->frameClock, __ATOMIC_RELAXED) + llround(wait * rate);
+		}
+		queueMixCommand(mixEngineRef, &cmd);
+	}
+	if(events & event_apl){
+		cmd.type = cmd_inApl;
+		cmd.frame = -1;
+		if(chrec->nextAplEvent)
+			cmd.frame = llround(chrec->nextAplEvent * rate);
+		queueMixCommand(mixEngineRef, &cmd);
+	}
+}
+
+/**
+ * Set the full bus routing of an input, including buses past 23 that the 
+ * packed busses word can't hold, as one command per 32 bus word.  Words 
+ * taken off the queue in the same cycle are applied together.
+ */
+void setInChanRoutes(mixEngineRecPtr mixEngineRef, unsigned int in, const busSet *routes){
+	mixCommand cmd;
+	unsigned int w, count;
+	
+	cmd.type = cmd_inBusWord;
+	cmd.target = in;
+	cmd.fVal = 0.0;
+	cmd.frame = -1;
+	cmd.when = 0;
+	cmd.ptr = NULL;
+	count = (mixEngineRef->busCount + 31) / 32;
+	for(w=0; w<count; w++){
+		cmd.word = w;
+		cmd.iVal = busset_word(routes, w);
+		queueMixCommand(mixEngineRef, &cmd);
+	}
+}
+
+/**
+ * Make input in a RAM resident cart player of item, held from the cart 
+ * pool, or unload the cart with a NULL item.  Render plays the item from 
+ * the pool in place of the input ports, and counts the input as connected 
+ * while it has an item.  If the command can't be queued, the item is let 
+ * go of here.
+ */
+void setInChanCart(mixEngineRecPtr mixEngineRef, unsigned int in, cartItem *item){
+	mixCommand cmd;
+	
+	mixcarts_collect(mixEngineRef->carts);
+	cmd.type = cmd_inCart;
+	cmd.target = in;
+	cmd.iVal = 0;
+	cmd.fVal = 0.0;
+	cmd.frame = -1;
+	cmd.when = 0;
+	cmd.ptr = item;
+	if(!queueMixCommand(mixEngineRef, &cmd))
+		mixcarts_release(mixEngineRef->carts, item);
+}
+
+/**
+ * Give input in the shared memory control channel shm, made for the player 
+ * about to be launched on it, or take its channel away with a NULL shm.  
+ * Render keeps to the MIDI control port until the player attaches.  If 
+ * the command can't be queued, the channel is freed here, and zero returned.
+ */
+unsigned char setInChanCtl(mixEngineRecPtr mixEngineRef, unsigned int in, ctlShm *shm){
+	mixCommand cmd;
+	
+	freeRetiredCtls(mixEngineRef);
+	cmd.type = cmd_inCtl;
+	cmd.target = in;
+	cmd.iVal = 0;
+	cmd.fVal = 0.0;
+	cmd.frame = -1;
+	cmd.when = 0;
+	cmd.ptr = shm;
+	if(!queueMixCommand(mixEngineRef, &cmd)){
+		ctlshm_free(shm);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * Unload input in: a player goes when its ports are disconnected, a cart 
+ * when render drops its item.
+ */
+void unloadInChan(mixEngineRecPtr mixEngineRef, unsigned int in){
+	inChannel *instance;
+	jack_port_t **port;
+	unsigned int c;
+	
+	if(in >= mixEngineRef->inCount)
+		return;
+	instance = &mixEngineRef->ins[in];
+	if(instance->sourceType == sourceTypeMem){
+		setInChanCart(mixEngineRef, in, NULL);
+		return;
+	}
+	setInChanCtl(mixEngineRef, in, NULL);
+	port = instance->in_jPorts;
+	pthread_mutex_lock(&mixEngineRef->jackMutex);
+	for(c=0; c<mixEngineRef->chanCount; c++){
+		jack_port_disconnect(mixEngineRef->client, *port);
+		port++;
+	}
+	pthread_mutex_unlock(&mixEngineRef->jackMutex);
+}
+
+/**
+ * Set the per cycle budget render drains ctlOutQueue with: at most bytes 
+ * of encoded packets and events packets a cycle.  Zero or less for either 
+ * takes the default.
+ */
+void setCtlOutBudget(mixEngineRecPtr mixEngineRef, int bytes, int events){
+	if(bytes < 0)
+		bytes = 0;
+	if(events < 0)
+		events = 0;
+	__atomic_store_n(&mixEngineRef->ctlOutBytes, bytes, __ATOMIC_RELAXED);
+	__atomic_store_n(&mixEngineRef->ctlOutEvents, events, __ATOMIC_RELAXED);
+}
+
+/**
+ * Put the submix feeds in render order, a topological sort of the bus 
+ * graph: every feed into a bus comes before any feed out of it, so each 
+ * bus is complete before it is summed on.  Returns zero, leaving the 
+ * order as it was, if the feeds make a loop.  Called from the render 
+ * thread, only when the feeds change.
+ */
+static unsigned char orderBusFeeds(mixEngineRecPtr mixEngineRef){
+	busFeed sorted[mix_max_busFeeds];
+	unsigned int pending[mix_max_buses];	// feeds into each bus not yet placed
+	unsigned char ready[mix_max_buses];		// buses with all their feeds in placed
+	unsigned int i, b, count, placed, head, tail;
+	busFeed *feed;
+	
+	count = mixEngineRef->busFeedCount;
+	feed = mixEngineRef->busFeeds;
+	memset(pending, 0, sizeof(pending));
+	for(i=0; i<count; i++)
+		pending[feed[i].dst]++;
+	tail = 0;
+	for(b=0; b<mixEngineRef->busCount; b++){
+		if(pending[b] == 0)
+			ready[tail++] = b;
+	}
+	placed = 0;
+	for(head=0; head<tail; head++){
+		b = ready[head];
+		for(i=0; i<count; i++){
+			if(feed[i].src == b){
+				sorted[placed++] = feed[i];
+				if(--pending[feed[i].dst] == 0)
+					ready[tail++] = feed[i].dst;
+			}
+		}
+	}
+	if(placed < count)
+		return 0;
+	memcpy(feed, sorted, count * sizeof(busFeed));
+	return 1;
+}
+
+/**
+ * Add, change or, with a zero gain, remove the feed of bus src into bus 
+ * dst.  A new feed that would make a loop is ignored.  Called from the 
+ * render thread.
+ */
+static void setBusFeed(mixEngineRecPtr mixEngineRef, unsigned int src, unsigned int dst, float gain){
+	unsigned int i, count;
+	busFeed *feed;
+	
+	if((src >= mixEngineRef->busCount) || (dst >= mixEngineRef->busCount) || (src == dst))
+		return;
+	count = mixEngineRef->busFeedCount;
+	feed = mixEngineRef->busFeeds;
+	for(i=0; i<count; i++){
+		if((feed[i].src == src) && (feed[i].dst == dst))
+			break;
+	}
+	if(i < count){
+		if(gain){
+			feed[i].gain = gain;
+			return;
+		}
+		/* removing a feed keeps the rest in order */
+		memmove(&feed[i], &feed[i + 1], (count - i - 1) * sizeof(busFeed));
+		mixEngineRef->busFeedCount = count - 1;
+		return;
+	}
+	if(!gain || (count >= mix_max_busFeeds))
+		return;
+	feed[count].src = src;
+	feed[count].dst = dst;
+	feed[count].gain = gain;
+	mixEngineRef->busFeedCount = count + 1;
+	if(!orderBusFeeds(mixEngineRef))
+		/* a loop: drop the new feed, from the end where it was added */
+		mixEngineRef->busFeedCount = count;
+}
+
+/**
+ * Apply a command from the command queue.  Called from the render thread.
+ */
+static void applyMixCommand(mixEngineRecPtr mixEngineRef, mixCommand *cmd){
+	inChannel *inchrec;
+	outChannel *outchrec;
+	uint32_t type;
+	
+	type = cmd->type;
+	if(type < cmd_outVol){
+		if(cmd->target >= mixEngineRef->inCount)
+			return;
+		inchrec = &mixEngineRef->ins[cmd->target];
+		if(type == cmd_inVol){
+			inchrec->reqVol = cmd->fVal;
+			inchrec->requested = inchrec->requested | change_vol;
+		}else if(type == cmd_inBal){
+			inchrec->reqBal = cmd->fVal;
+			inchrec->requested = inchrec->requested | change_bal;
+		}else if(type == cmd_inPos){
+			inchrec->reqPos = cmd->fVal;
+			inchrec->requested = inchrec->requested | change_pos;
+		}else if((type == cmd_inBus) || (type == cmd_inBusWord)){
+			if((inchrec->requested & change_bus) == 0){
+				/* start from the current routing: a load sets buses 0-23 in busses */
+				inchrec->reqRoutes = inchrec->routes;
+				busset_setWord(&inchrec->reqRoutes, 0, (busset_word(&inchrec->reqRoutes, 0) & 0xff000000) 
+												| (inchrec->busses & 0x00ffffff));
+			}
+			if(type == cmd_inBus)
+				busset_setWord(&inchrec->reqRoutes, 0, (busset_word(&inchrec->reqRoutes, 0) & 0xff000000) 
+												| (cmd->iVal & 0x00ffffff));
+			else if(cmd->word < (busSetWords * 2))
+				busset_setWord(&inchrec->reqRoutes, cmd->word, cmd->iVal);
+			inchrec->reqBusses = (inchrec->reqBusses & 0xff000000) | 
+								(busset_word(&inchrec->reqRoutes, 0) & 0x00ffffff);
+			inchrec->requested = inchrec->requested | change_bus;
+		}else if(type == cmd_inMutes){
+			inchrec->reqBusses = (inchrec->reqBusses & 0x00ffffff) | (cmd->iVal & 0xff000000);
+			inchrec->requested = inchrec->requested | change_mutes;
+		}else if(type == cmd_inFeedBus){
+			inchrec->reqFeedBus = cmd->iVal;
+			inchrec->requested = inchrec->requested | change_feedbus;
+		}else if(type == cmd_inFeedVol){
+			inchrec->reqFeedVol = cmd->fVal;
+			inchrec->requested = inchrec->requested | change_feedvol;
+		}else if(type == cmd_inPlay){
+			inchrec->requested = inchrec->requested | change_play;
+		}else if(type == cmd_inStop){
+			inchrec->requested = inchrec->requested | change_stop;
+		}else if(type == cmd_inSegue){
+			inchrec->evSegue = cmd->frame;
+			inchrec->evSegNext = cmd->iVal;
+			inchrec->evSegLevel = cmd->fVal;
+		}else if(type == cmd_inFade)
+			inchrec->evFade = cmd->frame;
+		else if(type == cmd_inFadeTime)
+			inchrec->evFadeTime = cmd->frame;
+		else if(type == cmd_inApl)
+			inchrec->evApl = cmd->frame;
+		else if(type == cmd_inCart){
+			/* the old item, if any, goes back to app threads: with no new 
+			 * item, the input is disconnected, and unloads this cycle */
+			if(inchrec->cart != (cartItem *)cmd->ptr)
+				mixcarts_retire(mixEngineRef->carts, inchrec->cart);
+			inchrec->cart = (cartItem *)cmd->ptr;
+			if(inchrec->cart){
+				inchrec->sourceType = sourceTypeMem;
+				inchrec->changed = inchrec->changed | change_type;
+			}
+		}else if(type == cmd_inCtl){
+			if((inchrec->ctl != (ctlShm *)cmd->ptr) && inchrec->ctl){
+				/* if the retired queue is full, the old channel is lost 
+				 * rather than freed while in use */
+				if(jack_ringbuffer_write_space(mixEngineRef->retiredCtls) >= sizeof(ctlShm *))
+					jack_ringbuffer_write(mixEngineRef->retiredCtls, (char *)&inchrec->ctl, sizeof(ctlShm *));
+			}
+			inchrec->ctl = (ctlShm *)cmd->ptr;
+		}
+		/* timed play, stop and volume changes land on their frame of the cycle */
+		if(((type == cmd_inVol) || (type == cmd_inPlay) || (type == cmd_inStop)) 
+								&& (cmd->when > mixEngineRef->frameClock))
+			inchrec->reqOffset = cmd->when - mixEngineRef->frameClock;
+	}else if(type < cmd_talkbackOn){
+		if(cmd->target >= mixEngineRef->outCount)
+			return;
+		outchrec = &mixEngineRef->outs[cmd->target];
+		if(type == cmd_outVol){
+			outchrec->reqVol = cmd->fVal;
+			outchrec->requested = outchrec->requested | change_vol;
+		}else if(type == cmd_outBus){
+			outchrec->reqBus = cmd->iVal;
+			outchrec->requested = outchrec->requested | change_bus;
+		}else if(type == cmd_outDelay){
+			outchrec->reqDelay = cmd->fVal;
+			outchrec->requested = outchrec->requested | change_delay;
+			/* swap in the new line now: once the command is acknowledged, 
+			 * the old line is no longer used.  If the retired queue is full, 
+			 * the old line is lost rather than freed while in use. */
+			if(outchrec->delayLine != (mixbuffer_t *)cmd->ptr){
+				if(outchrec->delayLine && (jack_ringbuffer_write_space(mixEngineRef->retiredLines) >= sizeof(mixbuffer_t *)))
+					jack_ringbuffer_write(mixEngineRef->retiredLines, (char *)&outchrec->delayLine, sizeof(mixbuffer_t *));
+				outchrec->delayLine = (mixbuffer_t *)cmd->ptr;
+			}
+		}else if(type == cmd_outDsp)
+			swapDspChain(mixEngineRef, &outchrec->dsp, (dspChain *)cmd->ptr);
+	}else if(type == cmd_talkbackOn)
+		mixEngineRef->reqTalkBackBits = mixEngineRef->reqTalkBackBits | cmd->iVal;
+	else if(type == cmd_talkbackOff)
+		mixEngineRef->reqTalkBackBits = mixEngineRef->reqTalkBackBits & ~cmd->iVal;
+	else if(type == cmd_busFeed)
+		setBusFeed(mixEngineRef, cmd->target, cmd->iVal, cmd->fVal);
+	else if((type == cmd_busDsp) && (cmd->target < mixEngineRef->busCount))
+		swapDspChain(mixEngineRef, &mixEngineRef->busDsp[cmd->target], (dspChain *)cmd->ptr);
+}
+
+/**
+ * Run the insert chain of bus b, if it has one and it hasn't run yet this 
+ * cycle.  A bus with a chain is never marked silent, so the chain runs 
+ * every cycle: a bus nothing was mixed into is zeroed first.  Called from 
+ * the render thread once the bus sum is complete.
+ */
+static void runBusDsp(mixEngineRecPtr mixEngineRef, unsigned int b, jack_nframes_t nframes, 
+												busSet *written, busSet *done){
+	dspChain *chain;
+	unsigned int c;
+	
+	if(!(chain = mixEngineRef->busDsp[b]) || busset_has(done, b))
+		return;
+	busset_add(done, b);
+	for(c=0; c<mixEngineRef->chanCount; c++){
+		chain->bufs[c] = mixbuffer_span(mixEngineRef->mixbuses, c, b);
+		if(!busset_has(written, b))
+			memset(chain->bufs[c], 0, nframes * sizeof(jack_default_audio_sample_t));
+	}
+	busset_add(written, b);
+	mixdsp_process(chain, nframes);
+}
+
+/**
+ * Send a control packet of type to the player on input i: by its shared 
+ * memory control channel once the player has attached to it, else on the 
+ * MIDI control port.  val, in network byte order, is the data, or NULL for 
+ * none.  Called from the render thread.
+ */
+static void sendPlayerControl(inChannel *inchrec, unsigned int i, void *midi_buffer, 
+									uint8_t type, valuetype *val){
+	controlPacket *packet;
+	uint16_t size;
+	
+	size = 0;
+	if(val)
+		size = sizeof(valuetype);
+	if(ctlshm_attached(inchrec->ctl)){
+		ctlshm_write(&inchrec->ctl->toPeer, type | cPeer_player, i, val, size);
+		return;
+	}
+	if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, controlPacketSize(size))){
+		packet->type = type | cPeer_player;
+		packet->peer = htonl(i);
+		packet->dataSize = htons(size);
+		if(size)
+			memcpy(packet->data, val, size);
+		encodeControlPacket(packet, size);
+	}
+}
+
+/**
+ * Act on a real time control packet from a player: end of media, position 
+ * and volume.  header is the packet header, decoded; the data, if used, is 
+ * decoded from packet in place, unless the packet is raw.  time is the 
+ * frame in the cycle the packet arrived at.  Returns zero for a packet 
+ * that is for an app thread to handle instead.  Called from the render 
+ * thread.
+ */
+static unsigned char playerControl(mixEngineRecPtr mixEngineRef, controlPacket *header, 
+									controlPacket *packet, jack_nframes_t time){
+	inChannel *inchrec;
+	valuetype *val;
+	double syncTime;
+	unsigned int i;
+	size_t size;
+	
+	if((header->type & cPeer_MASK) == cPeer_player){
+		i = ntohl(header->peer);
+		if(checkPnumber(i)){
+			inchrec = &mixEngineRef->ins[i];
+			if(inchrec->status){
+				char type = header->type & 0x0f;
+				size = ntohs(header->dataSize);
+				if(type == cType_end){
+					// handle end of media message
+					inchrec->status = inchrec->status | status_finished;
+					// force a segue when one is set
+					if(inchrec->evSegue >= 0)
+						inchrec->evSegue = 0;
+					inchrec->requested = inchrec->requested | change_stop;
+					inchrec->reqOffset = time;
+					return 1;
+				}else if((type == cType_pos) && (size == sizeof(valuetype))){
+					decodeControlPacket(packet, 0);
+					val = (valuetype *)packet->data;
+					val->iVal = ntohl(val->iVal);
+					syncTime = val->fVal;
+					inchrec->posack = 1;	// set flag to send pos ack control packet
+					inchrec->posackOffset = time;
+					if(inchrec->status & status_playing)
+						// adjust for midi arrive time within sample frame - NOTE: nFrames of time will be added soon
+						syncTime = syncTime - (double)time / (double)mixEngineRef->mixerSampleRate;
+					if(inchrec->sourceType != sourceTypeCanRepos){
+						inchrec->sourceType = sourceTypeCanRepos;
+						inchrec->changed = inchrec->changed | change_type;
+					}
+					if(fabs(syncTime - inchrec->pos) > 0.1){
+						// more than a minor adjustment
+						inchrec->pos = syncTime;
+						inchrec->changed = inchrec->changed | change_pos;
+					}
+					inchrec->pos = syncTime;
+					return 1;
+				}else if((type == cType_vol) && (size == sizeof(valuetype))){
+					decodeControlPacket(packet, 0);
+					val = (valuetype *)packet->data;
+					val->iVal = ntohl(val->iVal);
+					inchrec->requested = inchrec->requested | change_vol;
+					inchrec->reqVol = val->fVal;
+					inchrec->reqOffset = time;
+					return 1;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * Start input i playing, if it isn't already: sends the start control packet 
+ * to the player.  Called from the render thread, for a play request or a 
+ * segue.
+ */
+static void playInput(inChannel *inchrec, unsigned int i, void *midi_buffer){
+	if((inchrec->status & status_playing) == 0){
+		/* a cart has no player to tell */
+		if(inchrec->sourceType != sourceTypeMem)
+			sendPlayerControl(inchrec, i, midi_buffer, cType_start, NULL);
+		inchrec->changed = inchrec->changed | change_play;
+		inchrec->status = inchrec->status | status_playing;
+		if((inchrec->busses & 2L) == 0){ 
+			// not in cue
+			inchrec->status = inchrec->status | status_hasPlayed;
+		}
+		if(inchrec->sourceType == sourceTypeLive){
+			inchrec->pos = 0.0;
+			inchrec->changed = inchrec->changed | change_pos;
+		}
+	}
+}
+
+/**
+ * Act on the scheduled events of an input that fall within this cycle, 
+ * and run any fade in progress.  busbits are the buses the input is mixing 
+ * into this cycle.  Returns the fader gain of the input for the cycle.  
+ * Called from the render thread.
+ */
+static float runInChanEvents(mixEngineRecPtr mixEngineRef, inChannel *inchrec, 
+				jack_nframes_t nframes, void *midi_buffer, uint32_t busbits){
+	int64_t posFrame, endFrame, frame, clock;
+	jack_nframes_t offset;
+	unsigned char playing;
+	unsigned int next;
+	inChannel *nextrec;
+	double rate;
+	float vol;
+	
+	rate = mixEngineRef->mixerSampleRate;
+	clock = mixEngineRef->frameClock;
+	/* the span of play position frames this cycle covers: status at the 
+	 * start of the cycle, so a segue forced by an end of media still runs */
+	playing = (inchrec->tmpStatus & status_playing) != 0;
+	posFrame = llround(inchrec->pos * rate);
+	if(playing)
+		endFrame = posFrame + nframes;
+	else
+		endFrame = posFrame + 1;
+	
+	/* fade start, by play position or by time, whichever comes first */
+	if(!inchrec->fading){
+		frame = -1;
+		offset = 0;
+		if((inchrec->evFade >= 0) && (inchrec->evFade < endFrame)){
+			frame = posFrame;
+			if(inchrec->evFade > posFrame){
+				frame = inchrec->evFade;
+				offset = frame - posFrame;
+			}
+		}
+		if((inchrec->evFadeTime >= 0) && (inchrec->evFadeTime < (clock + nframes))){
+			if(inchrec->evFadeTime > clock){
+				if((frame < 0) || ((inchrec->evFadeTime - clock) < offset)){
+					offset = inchrec->evFadeTime - clock;
+					frame = posFrame;
+					if(playing)
+						frame = frame + offset;
+				}
+			}else{
+				offset = 0;
+				frame = posFrame;
+			}
+		}
+		if(frame >= 0){
+			inchrec->fading = 1;
+			inchrec->fadeOffset = offset;
+			inchrec->evFade = -1;
+			inchrec->evFadeTime = -1;
+			inchrec->fadePos = frame / rate;
+			inchrec->fadeTime = 0;
+			/* segout on fade too */
+			inchrec->levelSeg = 0.0;
+			inchrec->evSegLevel = 0.0;
+			if(inchrec->evSegue >= 0){
+				inchrec->evSegue = frame;
+				inchrec->posSeg = inchrec->fadePos;
+			}
+		}
+	}
+	
+	/* segue to the next input when playing and not in Cue */
+	if((inchrec->evSegue >= 0) && playing && ((busbits & 2) == 0) && (inchrec->evSegue < endFrame)){
+		/* level holdoff, by the input's level as of the last cycle */
+		if((inchrec->evSegLevel == 0.0) || (inchrec->tmpSegLevel < inchrec->evSegLevel)){
+			next = inchrec->evSegNext;
+			if(next && (next <= mixEngineRef->inCount)){
+				nextrec = &mixEngineRef->ins[next-1];
+				if(nextrec > inchrec){
+					/* not handled yet this cycle: start it on the segue frame */
+					nextrec->requested = nextrec->requested | change_play;
+					if(inchrec->evSegue > posFrame)
+						nextrec->reqOffset = inchrec->evSegue - posFrame;
+				}else if(nextrec->status & status_standby){
+					playInput(nextrec, next-1, midi_buffer);
+					/* status may have been sampled already this cycle */
+					nextrec->changed = nextrec->changed | change_stat;
+				}else
+					nextrec->requested = nextrec->requested | change_play;
+			}
+			inchrec->evSegue = -1;
+			inchrec->posSeg = 0.0;
+			inchrec->segNext = 0;
+			inchrec->levelSeg = 0.0;
+		}
+	}
+	
+	/* past next APL event when playing and not in Cue */
+	if((inchrec->evApl >= 0) && playing && ((busbits & 2) == 0) && (inchrec->evApl < endFrame)){
+		inchrec->changed = inchrec->changed | change_aplEvent;
+		inchrec->evApl = -1;
+	}
+	
+	/* handle fading */
+	vol = inchrec->vol;
+	if(inchrec->fading){
+		// 3 sec. fade from unity gain, from the fade start frame
+		vol = vol - (((nframes - inchrec->fadeOffset) / rate) * 0.333333);
+		inchrec->fadeOffset = 0;
+		if(vol < 0.0)
+			vol = 0.0;
+		inchrec->changed = inchrec->changed | change_vol;
+		if(vol < 0.0001){	// faded to below -80 dB
+			inchrec->status = inchrec->status | status_finished;
+			vol = 0.0;
+			inchrec->fading = 0;
+			inchrec->fadePos = 0.0;
+			inchrec->fadeTime = 0;
+			
+			inchrec->requested = inchrec->requested | change_stop;
+		}
+		inchrec->vol = vol;
+	}
+	return vol;
+}
+
+/**
+ * Scale, meter and mix one input into it's assigned buses.  With partial 
+ * NULL, the samples are mixed into the mixbus buffers at the current write 
+ * point.  Otherwise they are mixed into the partial bus accumulator, a 
+ * busCount * chanCount array of stride length sample buffers.  The first 
+ * input mixed into a bus replaces the samples there: written holds the bits 
+ * of the buses that have already been written to.  Called from the render 
+ * thread, or from a mix worker thread.
+ * Each input channel is read once: the fanout kernel scales it, meters it, 
+ * and writes it to every bus it is on, and to the mix-minus feed output 
+ * in one pass.
+ * A gain change of an input that was sounding last cycle and still is 
+ * ramps across the cycle, to or from zero too, so fades, mutes and level 
+ * changes have no zipper noise or click.  Starting and stopping are 
+ * steps, at the split frame of the cycle if one is set.
+ * This is the body of mixInput() and its channel width specializations: 
+ * with ccount a constant, the channel loop and gain selection fold away.
+ */
+static inline __attribute__((always_inline)) void mixInputWidth(mixEngineRecPtr mixEngineRef, 
+				inChannel *inchrec, jack_nframes_t nframes, jack_default_audio_sample_t *partial, 
+				size_t stride, busSet *written, const unsigned int ccount){
+	unsigned int b, c, w, bcount, setCount, destCount;
+	jack_default_audio_sample_t *dests[mix_max_buses], *feed;
+	jack_default_audio_sample_t **in_buf, **out_buf;
+	float gain, preGain, pk, avr, splitPk, curSegLevel;
+	jack_nframes_t split;
+	busSet route, first;
+	unsigned char mmFeed;
+	size_t step;
+	vuData *vu;
+	
+	bcount = mixEngineRef->busCount;
+	in_buf = inchrec->inBufs;
+	out_buf = inchrec->mmBufs;
+	route = inchrec->tmpRoutes;
+	
+	/* the first input mixed into a bus this cycle replaces the samples */
+	for(w=0; w<busSetWords; w++){
+		first.w[w] = route.w[w] & ~written->w[w];
+		written->w[w] = written->w[w] | route.w[w];
+		route.w[w] = route.w[w] & ~first.w[w];
+	}
+	
+	/* channel 0 of each bus the input is on: the buses it replaces first, 
+	 * then those it sums into.  Channel c is c * step samples on. */
+	destCount = 0;
+	for(b = busset_next(&first, 0); b < bcount; b = busset_next(&first, b + 1)){
+		if(partial)
+			dests[destCount++] = partial + (stride * ccount * b);
+		else
+			dests[destCount++] = mixbuffer_span(mixEngineRef->mixbuses, 0, b);
+	}
+	setCount = destCount;
+	for(b = busset_next(&route, 0); b < bcount; b = busset_next(&route, b + 1)){
+		if(partial)
+			dests[destCount++] = partial + (stride * ccount * b);
+		else
+			dests[destCount++] = mixbuffer_span(mixEngineRef->mixbuses, 0, b);
+	}
+	if(partial)
+		step = stride;
+	else
+		step = mixEngineRef->mixbuses->chanStride;
+	
+	/* A connected mix-minus feed of an input that is also on the feed bus 
+	 * gets the inverted input samples, for the feed bus to be added to.  
+	 * Otherwise the mix-minus stage just copies the feed bus. */
+	mmFeed = inchrec->mmConnected && inchrec->tmpFeedBus && (inchrec->tmpFeedBus <= bcount) 
+						&& busset_has(&inchrec->tmpRoutes, inchrec->tmpFeedBus - 1);
+	if(mmFeed)
+		inchrec->tmpMixMinus = 1;
+	
+	split = inchrec->tmpSplit;
+	curSegLevel = 0.0;
+	for(c=0; c<ccount; c++){ 	// channel c of the input
+		if(c & 0x1){
+			gain = inchrec->tmpRightVol;
+			preGain = inchrec->tmpPreRightVol;
+		}else{
+			gain = inchrec->tmpLeftVol;
+			preGain = inchrec->tmpPreLeftVol;
+		}
+		if(mmFeed)
+			feed = *out_buf;
+		else
+			feed = NULL;
+		
+		// VU meter sample calculations - all VU levels are squared (power)
+		if(!split && inchrec->tmpRamp && (preGain != gain)){
+			/* volume, balance or fade change: ramp from the last cycle's gain */
+			avr = mixKernels.fanout(dests, setCount, destCount, feed, -1.0, *in_buf, preGain, 
+													(gain - preGain) / nframes, nframes, &pk);
+			for(b=0; b<destCount; b++)
+				dests[b] += step;
+		}else if(split && (preGain != gain)){
+			/* the gain changes on frame split of the cycle */
+			avr = mixKernels.fanout(dests, setCount, destCount, feed, -1.0, *in_buf, preGain, 0.0, split, &pk);
+			for(b=0; b<destCount; b++)
+				dests[b] += split;
+			if(feed)
+				feed += split;
+			avr = avr + mixKernels.fanout(dests, setCount, destCount, feed, -1.0, *in_buf + split, 
+													gain, 0.0, nframes - split, &splitPk);
+			if(splitPk > pk)
+				pk = splitPk;
+			for(b=0; b<destCount; b++)
+				dests[b] += step - split;
+		}else{
+			avr = mixKernels.fanout(dests, setCount, destCount, feed, -1.0, *in_buf, gain, 0.0, nframes, &pk);
+			for(b=0; b<destCount; b++)
+				dests[b] += step;
+		}
+		
+		/* VU Block calculations */
+		vu = &(inchrec->VUmeters[c]);
+		// VU avarage over 10,000 samples - aprox 10 Hz @ sample rate = 96,000
+		avr = ( 1.0 - (0.0001 * nframes)) * vu->avr + 0.0001 * avr;
+		if(avr > 100.0) 
+			avr = 100.0;
+		vu->avr = avr;
+		/* for level based segue, use the largest avr VU channel value */
+		if(avr > curSegLevel)
+			curSegLevel = avr;
+		
+		// VU peak fall time constatnt is 50,000 samples - aprox 2 Hz @ sample rate = 96,000
+		vu->peak = vu->peak * ( 1.0 - (0.00002 * nframes));
+		if(pk > 100.0)
+			pk = 100.0;
+		if(pk > vu->peak)
+			vu->peak = pk;
+		
+		in_buf++;
+		out_buf++;
+	}
+	inchrec->tmpSegLevel = curSegLevel;
+}
+
+/* mixInput() for any channel width */
+void mixInput(mixEngineRecPtr mixEngineRef, inChannel *inchrec, jack_nframes_t nframes, 
+				jack_default_audio_sample_t *partial, size_t stride, busSet *written){
+	mixInputWidth(mixEngineRef, inchrec, nframes, partial, stride, written, mixEngineRef->chanCount);
+}
+
+/* mixInput() for mono, stereo and 5.1 */
+static void mixInput1(mixEngineRecPtr mixEngineRef, inChannel *inchrec, jack_nframes_t nframes, 
+				jack_default_audio_sample_t *partial, size_t stride, busSet *written){
+	mixInputWidth(mixEngineRef, inchrec, nframes, partial, stride, written, 1);
+}
+
+static void mixInput2(mixEngineRecPtr mixEngineRef, inChannel *inchrec, jack_nframes_t nframes, 
+				jack_default_audio_sample_t *partial, size_t stride, busSet *written){
+	mixInputWidth(mixEngineRef, inchrec, nframes, partial, stride, written, 2);
+}
+
+static void mixInput6(mixEngineRecPtr mixEngineRef, inChannel *inchrec, jack_nframes_t nframes, 
+				jack_default_audio_sample_t *partial, size_t stride, busSet *written){
+	mixInputWidth(mixEngineRef, inchrec, nframes, partial, stride, written, 6);
+}
+
 /**
  * The process callback for this JACK application is called in a
  * special realtime thread, once for each audio cycle.
  */
+/* Render thread: zero every audio output port, and send no control 
+ * packets, for a cycle that can't be rendered */
+static void silenceOutputs(mixEngineRecPtr mixEngineRef, jack_nframes_t nframes){
+	unsigned int i, c, ccount;
+	jack_port_t **port;
+	size_t size;
+	
+	ccount = mixEngineRef->chanCount;
+	size = nframes * sizeof(jack_default_audio_sample_t);
+	jack_midi_clear_buffer(jack_port_get_buffer(mixEngineRef->ctlOutPort, nframes));
+	port = mixEngineRef->mixbuses->busout_jPorts;
+	for(i=0; i<(mixEngineRef->busCount * ccount); i++){
+		memset(jack_port_get_buffer(*port, nframes), 0, size);
+		port++;
+	}
+	for(i=0; i<mixEngineRef->outCount; i++){
+		if(port = mixEngineRef->outs[i].jPorts){
+			for(c=0; c<ccount; c++)
+				memset(jack_port_get_buffer(port[c], nframes), 0, size);
+		}
+	}
+	for(i=0; i<mixEngineRef->inCount; i++){
+		if(port = mixEngineRef->ins[i].mm_jPorts){
+			for(c=0; c<ccount; c++)
+				memset(jack_port_get_buffer(port[c], nframes), 0, size);
+		}
+	}
+}
+
 int process(jack_nframes_t nframes, void *arg){
 	mixEngineRecPtr mixEngineRef = (mixEngineRecPtr)arg;
 	
-	unsigned int i, b, c, s, max, icount, ccount, bcount, busbits;
-	jack_default_audio_sample_t *src, *samp, *dest;
-	jack_port_t **in_port;
+	unsigned int i, b, c, s, a, w, max, icount, ccount, bcount, busbits;
+	unsigned int *active, acount, fcount;
+	busSet mixedBus, writtenBus, feedBus, dspBus, route;
+	jack_default_audio_sample_t *samp, *dest;
 	jack_port_t **out_port;
 	float leftVol, rightVol, vol;
 	float SampSqrd, pk, avr, sum;
-	double frameTime, syncTime;
+	double frameTime;
 	int delay;
 	unsigned int tmpStatus;
 	size_t sizeA, sizeB, size;
 	inChannel *inchrec;
 	outChannel *outchrec;
 	vuData *vu;
+	busFeed *feed;
 	uint32_t activeBus, tbBits;
 	jack_midi_event_t in_event;
 	jack_nframes_t event_count;
@@ -175,13 +1266,40 @@ int process(jack_nframes_t nframes, void *arg){
 	void* midi_buffer;
 	controlPacket *packet;
 	controlPacket header;
-	valuetype *val;
+	union{
+		controlPacket packet;
+		char bytes[sizeof(controlPacket) + sizeof(valuetype)];
+	} small;		// a real time packet off a shared memory control channel
+	ctlRing *ring;
+	valuetype ctlVal;
 	unsigned int groupGain, least;
-	unsigned char wakeChanged;
+	unsigned char wakeChanged, talkback, sounding;
 	float curSegLevel;
+	mixCommand cmd, *held;
+	mixChange change;
+	uint64_t endClock;
+	uint32_t seq;
 	unsigned char handled = 0;
-	unsigned char invertflag;
+	mixStats *stats;
+	uint64_t start, mark;
+	int64_t posFrame;
+	mixbuffer_t *line;
 	
+	if(line = __atomic_exchange_n(&mixEngineRef->busResize, NULL, __ATOMIC_ACQUIRE)){
+		/* longer bus buffers from the buffer size callback: the old 
+		 * ones are retired with the delay lines, for app threads to free */
+		mixbuffer_swapSamples(mixEngineRef->mixbuses, line);
+		if(jack_ringbuffer_write_space(mixEngineRef->retiredLines) >= sizeof(mixbuffer_t *))
+			jack_ringbuffer_write(mixEngineRef->retiredLines, (char *)&line, sizeof(mixbuffer_t *));
+	}
+	if(nframes > mixEngineRef->mixbuses->bufSizeSamples){
+		/* JACK period longer than the mix bus buffers: can't render */
+		silenceOutputs(mixEngineRef, nframes);
+		return 0;
+	}
+	stats = mixEngineRef->stats;
+	mixstats_begin(stats);
+	start = mark = mixstats_now();
 	wakeChanged = 0;
 	activeBus = 0;
 	ccount = mixEngineRef->chanCount;
@@ -197,53 +1315,7 @@ int process(jack_nframes_t nframes, void *arg){
 		if(in_event.size >= sizeof(controlPacket)){
 			header = *packet; // copy header portion, for header decoding
 			if(decodeControlPacket(&header, 1)){
-				handled = 0;
-				if((header.type & cPeer_MASK) == cPeer_player){
-					i = ntohl(header.peer);
-					if(checkPnumber(i)){
-						inchrec = &mixEngineRef->ins[i];
-						if(inchrec->status){
-							char type = header.type & 0x0f;
-							size = ntohs(header.dataSize);
-							if(type == cType_end){
-								// handle end of media message
-								inchrec->status = inchrec->status | status_finished;
-								// force a segue when segNext is set
-								if(inchrec->segNext)
-									inchrec->posSeg = 0.1;
-								inchrec->requested = inchrec->requested | change_stop;
-								handled = 1;
-							}else if((type == cType_pos) && (size == sizeof(valuetype))){
-								decodeControlPacket(packet, 0);
-								val = (valuetype *)packet->data;
-								val->iVal = ntohl(val->iVal);
-								syncTime = val->fVal;
-								inchrec->posack = 1;	// set flag to send pos ack control packet
-								if(inchrec->status & status_playing)
-									// adjust for midi arrive time within sample frame - NOTE: nFrames of time will be added soon
-									syncTime = syncTime - (double)in_event.time / (double)mixEngineRef->mixerSampleRate;
-								if(inchrec->sourceType != sourceTypeCanRepos){
-									inchrec->sourceType = sourceTypeCanRepos;
-									inchrec->changed = inchrec->changed | change_type;
-								}
-								if(fabs(syncTime - inchrec->pos) > 0.1){
-									// more than a minor adjustment
-									inchrec->pos = syncTime;
-									inchrec->changed = inchrec->changed | change_pos;
-								}
-								inchrec->pos = syncTime;
-								handled = 1;
-							}else if((type == cType_vol) && (size == sizeof(valuetype))){
-								decodeControlPacket(packet, 0);
-								val = (valuetype *)packet->data;
-								val->iVal = ntohl(val->iVal);
-								inchrec->requested = inchrec->requested | change_vol;
-								inchrec->reqVol = val->fVal;
-								handled = 1;
-							}
-						}
-					}
-				}
+				handled = playerControl(mixEngineRef, &header, packet, in_event.time);
 				if(!handled){
 					// non-realtime packet... queue it for handling by another thread
 					if(jack_ringbuffer_write_space(mixEngineRef->ctlInQueue) >= in_event.size){
@@ -255,11 +1327,59 @@ int process(jack_nframes_t nframes, void *arg){
 			}
 		}
 	}
+	/* and from players with a shared memory control channel: raw 
+	 * packets, which go on the same way */
+	inchrec = mixEngineRef->ins;
+	for(i=0; i<mixEngineRef->inCount; i++){
+		if(inchrec->ctl){
+			ring = &inchrec->ctl->toServer;
+			for(a=0; a<ctl_drain_events; a++){
+				if(!(size = ctlshm_next(ring)))
+					break;
+				if(size <= sizeof(small)){
+					ctlshm_copy(ring, 0, &small, size);
+					if(playerControl(mixEngineRef, &small.packet, &small.packet, 0)){
+						ctlshm_skip(ring, size);
+						continue;
+					}
+				}
+				if(!ctlqueue_fromShm(mixEngineRef->ctlInQueue, ring, size))
+					break;
+				wakeChanged = 1;
+			}
+		}
+		inchrec++;
+	}
 	if(wakeChanged){
-		pthread_cond_broadcast(&mixEngineRef->ctlInQueueSemaphore);
+		signalEventFD(mixEngineRef->ctlInQueueFD);
 		wakeChanged = 0;
 	}
 	
+	/* apply commands queued by app threads, in order: timed commands 
+	 * held from earlier cycles first, then the queue */
+	endClock = mixEngineRef->frameClock + nframes;
+	held = mixEngineRef->cmdHeld;
+	for(a=0; a<mixEngineRef->heldCount; ){
+		if(held[a].when < endClock){
+			applyMixCommand(mixEngineRef, &held[a]);
+			mixEngineRef->heldCount--;
+			memmove(&held[a], &held[a+1], (mixEngineRef->heldCount - a) * sizeof(mixCommand));
+		}else
+			a++;
+	}
+	seq = 0;
+	while(jack_ringbuffer_read_space(mixEngineRef->cmdQueue) >= sizeof(mixCommand)){
+		jack_ringbuffer_read(mixEngineRef->cmdQueue, (char *)&cmd, sizeof(mixCommand));
+		seq = cmd.seq;
+		if((cmd.when >= endClock) && (mixEngineRef->heldCount < cmdHeldSize))
+			held[mixEngineRef->heldCount++] = cmd;
+		else
+			applyMixCommand(mixEngineRef, &cmd);
+	}
+	if(seq)
+		__atomic_store_n(&mixEngineRef->cmdAck, seq, __ATOMIC_RELEASE);
+	mixstats_mark(stats, stage_decode, &mark);
+	
 	/* re-assign control buffer for output control packets */
 	midi_buffer = jack_port_get_buffer(mixEngineRef->ctlOutPort, nframes);
 	jack_midi_clear_buffer(midi_buffer);
@@ -268,34 +1388,47 @@ int process(jack_nframes_t nframes, void *arg){
 	tbBits = (uint32_t)mixEngineRef->reqTalkBackBits << 29;
 	activeBus = tbBits;  // activeBus bit may be modified as we loop through channels, tbBit will not.
 	 
-	/* Mix each input to it's assigned mixbus ring-buffers */
+	/* Handle control for each input, and build a list of the inputs
+	 * that have audio to be mixed this cycle */
+	active = mixEngineRef->activeIns;
+	acount = 0;
+	busset_zero(&mixedBus);
 	inchrec = mixEngineRef->ins;
 	icount = mixEngineRef->inCount;
 	for(i=0; i<icount; i++){
 		/* input number i */
-		in_port = inchrec->in_jPorts;
-		out_port = inchrec->mm_jPorts;
-		
 		if(inchrec->posack){
-			/* send pos ack control packet */
-			if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, sizeof(controlPacket))){
-				packet->type = cType_posack | cPeer_player;
-				packet->peer = htonl(i);
-				packet->dataSize = 0;
-				encodeControlPacket(packet, NULL, NULL, NULL); // size = 0, no additional bytes returned.
-			}
+			/* send pos ack control packet, with the frame in the cycle the 
+			 * position was taken at */
+			ctlVal.iVal = htonl(inchrec->posackOffset);
+			sendPlayerControl(inchrec, i, midi_buffer, cType_posack, &ctlVal);
 			inchrec->posack = 0;
 		}
+		
+		/* a cart reaching the end of its item this cycle: as for a 
+		 * player's end of media message, but on the exact frame */
+		if((inchrec->sourceType == sourceTypeMem) && inchrec->cart && (inchrec->status & status_playing)){
+			posFrame = llround(inchrec->pos * mixEngineRef->mixerSampleRate);
+			if((posFrame + nframes) >= inchrec->cart->frames){
+				inchrec->status = inchrec->status | status_finished;
+				if(inchrec->evSegue >= 0)
+					inchrec->evSegue = inchrec->cart->frames;
+				inchrec->requested = inchrec->requested | change_stop;
+				inchrec->reqOffset = 0;
+				if(posFrame < inchrec->cart->frames)
+					inchrec->reqOffset = inchrec->cart->frames - posFrame;
+			}
+		}
 
 		/* handle change requests */
-		tmpStatus = inchrec->status;
+		inchrec->tmpStatus = inchrec->status;
 		if(inchrec->requested & change_vol){
 			inchrec->vol = inchrec->reqVol;
 			inchrec->changed = inchrec->changed | change_vol;
 			inchrec->requested = inchrec->requested & ~change_vol;
 		}
 		if(inchrec->requested & change_bal){
-			inchrec->bal = inchrec->reqBal;
+			setInChanBal(inchrec, inchrec->reqBal);
 			inchrec->changed = inchrec->changed | change_bal;
 			inchrec->requested = inchrec->requested & ~change_bal;
 		}
@@ -311,6 +1444,7 @@ int process(jack_nframes_t nframes, void *arg){
 			}
 			// change only bottom 3 bytes
 			inchrec->busses = (inchrec->busses & 0xff000000) | (inchrec->reqBusses & 0x00ffffff);
+			inchrec->routes = inchrec->reqRoutes;
 			inchrec->changed = inchrec->changed | change_bus;
 			inchrec->requested = inchrec->requested & ~change_bus;
 		}
@@ -323,54 +1457,33 @@ int process(jack_nframes_t nframes, void *arg){
 		if(inchrec->requested & change_pos){
 			if(inchrec->status & status_standby){
 				inchrec->status = inchrec->status & ~status_finished;
-				if(inchrec->sourceType == sourceTypeCanRepos){
-					size = controlDataSizeFromRaw(sizeof(valuetype));
-					if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, sizeof(controlPacket) + size)){
-						packet->type = cType_pos | cPeer_player;
-						packet->peer = htonl(i);
-						packet->dataSize = htons(sizeof(valuetype));
-						val = (valuetype*)packet->data;
-						val->fVal = inchrec->reqPos;
-						val->iVal = htonl(val->iVal); 
-						uint16_t dataSize = sizeof(valuetype);
-						encodeControlPacket(packet, (char*)val, &dataSize, (char*)val+sizeof(valuetype)); // extraPtr is set for inline use: no additional bytes returned.
-					}
+				if((inchrec->sourceType == sourceTypeMem) && inchrec->cart){
+					/* render is the player: take the position now */
+					inchrec->pos = inchrec->reqPos;
+					if(inchrec->pos < 0.0)
+						inchrec->pos = 0.0;
+					if(inchrec->pos > ((double)inchrec->cart->frames / mixEngineRef->mixerSampleRate))
+						inchrec->pos = (double)inchrec->cart->frames / mixEngineRef->mixerSampleRate;
+					inchrec->changed = inchrec->changed | change_pos;
+				}else if(inchrec->sourceType == sourceTypeCanRepos){
+					ctlVal.fVal = inchrec->reqPos;
+					ctlVal.iVal = htonl(ctlVal.iVal); 
+					sendPlayerControl(inchrec, i, midi_buffer, cType_pos, &ctlVal);
 				}
 			}
 			inchrec->requested = inchrec->requested & ~change_pos;
 		}
 		if(inchrec->requested & change_play){
 			if(inchrec->status & status_standby){
-				if((inchrec->status & status_playing) == 0){
-					if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, sizeof(controlPacket))){
-						packet->type = cType_start | cPeer_player;
-						packet->peer = htonl(i);
-						packet->dataSize = 0;
-						encodeControlPacket(packet, NULL, NULL, NULL); // size = 0, no additional bytes returned.
-					}
-					inchrec->changed = inchrec->changed | change_play;
-					inchrec->status = inchrec->status | status_playing;
-					if((inchrec->busses & 2L) == 0){ 
-						// not in cue
-						inchrec->status = inchrec->status | status_hasPlayed;
-					}
-					if(inchrec->sourceType != sourceTypeCanRepos){
-						inchrec->pos = 0.0;
-						inchrec->changed = inchrec->changed | change_pos;
-					}
-				}
+				playInput(inchrec, i, midi_buffer);
 				inchrec->requested = inchrec->requested & ~change_play;
 			}
 		}
 		if(inchrec->requested & change_stop){
 			if(inchrec->status & status_standby){
 				if(inchrec->status & status_playing){
-					if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, 0, sizeof(controlPacket))){
-						packet->type = cType_stop | cPeer_player;	
-						packet->peer = htonl(i);
-						packet->dataSize = 0;
-						encodeControlPacket(packet, NULL, NULL, NULL); // size = 0, no additional bytes returned.
-					}
+					if(inchrec->sourceType != sourceTypeMem)
+						sendPlayerControl(inchrec, i, midi_buffer, cType_stop, NULL);
 					inchrec->status = inchrec->status & ~status_playing;
 					inchrec->changed = inchrec->changed | change_stop;
 					if((inchrec->status & status_cueing) == 0){ 
@@ -399,32 +1512,12 @@ int process(jack_nframes_t nframes, void *arg){
 			inchrec->requested = inchrec->requested & ~change_feedvol;
 		}
 		
-		/* handle volume and fading */
-		vol = inchrec->vol;
-		if(inchrec->fadeTime && (inchrec->fadeTime < time(NULL))){
-			inchrec->fadePos = inchrec->pos;
-			inchrec->fadeTime = 0;
-		}
-		
-		if(inchrec->fadePos && (inchrec->pos >= inchrec->fadePos)){
-			inchrec->levelSeg = 0.0;
-			inchrec->posSeg = inchrec->fadePos;  // segout on fade too
-			vol = vol - (frameTime * 0.333333);		// 3 sec. fade from unity gain
-			if(vol < 0.0)
-				vol = 0.0;
-			inchrec->changed = inchrec->changed | change_vol;
-			if(vol < 0.0001){	// faded to below -80 dB
-				inchrec->status = inchrec->status | status_finished;
-				vol = 0.0;
-				inchrec->fadePos = 0.0;
-				inchrec->fadeTime = 0;
-				
-				inchrec->requested = inchrec->requested | change_stop;
-			}
-			inchrec->vol = vol;
-		}
-		
+		/* buses 0-23 may have been set in busses by an app thread, while loading */
+		busset_setWord(&inchrec->routes, 0, (busset_word(&inchrec->routes, 0) & 0xff000000) 
+												| (inchrec->busses & 0x00ffffff));
+		route = inchrec->routes;
 		busbits = inchrec->busses;
+		talkback = 0;
 		if(tbBits & busbits){
 			// talkback is on for a TB channel that is input has enabled, route to cue
 			if((inchrec->sourceType == sourceTypeLive) && (inchrec->status & status_standby) && !(inchrec->status & status_loading)){
@@ -432,7 +1525,9 @@ int process(jack_nframes_t nframes, void *arg){
 				activeBus = activeBus | 0x00000002 | (busbits & 0x0f000000);
 				inchrec->status = inchrec->status | status_talkback;
 				busbits = 2;
-				vol = 1.0;	// ignore fader when in Talkback mode
+				busset_zero(&route);
+				busset_add(&route, 1);
+				talkback = 1;
 			}
 		}else{
 			if(inchrec->status & status_talkback)
@@ -441,6 +1536,8 @@ int process(jack_nframes_t nframes, void *arg){
 			if(busbits & 2){
 				/* when in cue, disable mixing into all other buses */
 				busbits = 0x01000002;
+				busset_zero(&route);
+				busset_add(&route, 1);
 				if((inchrec->sourceType == sourceTypeLive) && (inchrec->status & status_standby) && !(inchrec->status & status_loading)){
 					// live sources activeate cue mute bus even when not playing
 					activeBus = activeBus | 0x01000002;
@@ -452,23 +1549,33 @@ int process(jack_nframes_t nframes, void *arg){
 				inchrec->status = inchrec->status & ~status_cueing;
 		}
 		
+		/* scheduled events and fading */
+		vol = runInChanEvents(mixEngineRef, inchrec, nframes, midi_buffer, busbits);
+		if(talkback)
+			vol = 1.0;	// ignore fader when in Talkback mode
+		
 		if(inchrec->status & status_playing){
 			activeBus = activeBus | (busbits & 0x0fffffff);	// ignore top TalkBack bits, but include mute group bits
 		}
 		
+		sounding = 1;
 		if(inchrec->sourceType == sourceTypeLive){
-			if((inchrec->status & status_render) == 0)
+			if((inchrec->status & status_render) == 0){
 				/* channel is muted */
 				vol = 0.0;
+				sounding = 0;
+			}
 		}else{
-			if((inchrec->status & status_playing) == 0)
+			if((inchrec->status & status_playing) == 0){
 				/* channel is muted */
 				vol = 0.0;
+				sounding = 0;
+			}
 		}
 		
 		if(vol){
-			leftVol = vol * sqrt(1.0 - inchrec->bal);
-			rightVol = vol * sqrt(1.0 + inchrec->bal);
+			leftVol = vol * inchrec->panLeft;
+			rightVol = vol * inchrec->panRight;
 		}else{
 			leftVol = rightVol = 0.0;
 		}
@@ -481,96 +1588,131 @@ int process(jack_nframes_t nframes, void *arg){
 			inchrec->tmpFeedBus = 2;
 		else
 			// otherwise, use the specified mix bus number + 1 for the feed source
-			inchrec->tmpFeedBus = 0x0000001f & inchrec->feedBus;
+			inchrec->tmpFeedBus = 0x000000ff & inchrec->feedBus;
 		
-		curSegLevel = 0.0;
-		for(c=0; c<ccount; c++){ 	// channel c of input number i
-			/* clear mixminus/feed outputs - we are using these buffers for
-			 * temporary volume/balance scaled input sample storage */
-			src = dest = jack_port_get_buffer(*out_port, nframes);
-			memset(dest, 0, nframes * sizeof(jack_default_audio_sample_t));
-			
-			/* get actual input buffer */
-			samp = jack_port_get_buffer(*in_port, nframes);
-			// volume and balance scaling
-			pk = 0.0;
-			avr = 0.0;
-			for(s = 0; s < nframes; s++){
-				if(c & 0x1)
-					*dest = *samp * rightVol;
-				else
-					*dest = *samp * leftVol;
-					
-				// VU meter sample calculations - all VU levels are squared (power)
-				SampSqrd = (*dest) * (*dest);
-				avr = avr + SampSqrd;
-				if(SampSqrd > pk)
-					pk = SampSqrd;
-					
-				samp++;
-				dest++;
+		/* A play, stop or volume change that lands part way through the 
+		 * cycle splits it: the last cycle's gains run up to the change */
+		inchrec->tmpSplit = 0;
+		if(inchrec->reqOffset < nframes)
+			inchrec->tmpSplit = inchrec->reqOffset;
+		inchrec->reqOffset = 0;
+		inchrec->tmpPreLeftVol = inchrec->tmpLeftVol;
+		inchrec->tmpPreRightVol = inchrec->tmpRightVol;
+		/* plays and stops are steps; fader moves, to and from zero too, ramp */
+		inchrec->tmpRamp = sounding && inchrec->tmpSounding;
+		inchrec->tmpSounding = sounding;
+		
+		inchrec->tmpRoutes = route;
+		inchrec->tmpLeftVol = leftVol;
+		inchrec->tmpRightVol = rightVol;
+		inchrec->tmpMixMinus = 0;
+		if((vol || ((inchrec->tmpSplit || inchrec->tmpRamp) && (inchrec->tmpPreLeftVol || inchrec->tmpPreRightVol))) 
+					&& (inchrec->cart || inchrec->portConnected) 
+					&& (!inchrec->cart || (nframes <= inchrec->cart->pad))){
+			/* audio to mix: get the port buffers here, in the render thread.  
+			 * A cart padded for shorter cycles than this one is skipped. */
+			*active++ = i;
+			acount++;
+			for(w=0; w<busSetWords; w++)
+				mixedBus.w[w] = mixedBus.w[w] | route.w[w];
+			if(inchrec->cart){
+				/* a cart reads straight from its item: one that starts part 
+				 * way through the cycle reads silence up to the split */
+				posFrame = llround(inchrec->pos * mixEngineRef->mixerSampleRate);
+				if(!(inchrec->tmpStatus & status_playing))
+					posFrame = posFrame - inchrec->tmpSplit;
+				for(c=0; c<ccount; c++)
+					inchrec->inBufs[c] = mixcarts_span(inchrec->cart, c, posFrame);
+			}else{
+				for(c=0; c<ccount; c++)
+					inchrec->inBufs[c] = jack_port_get_buffer(inchrec->in_jPorts[c], nframes);
 			}
-			
-			/* VU Block calculations */
-			vu = &(inchrec->VUmeters[c]);
-			// VU avarage over 10,000 samples - aprox 10 Hz @ sample rate = 96,000
-			avr = ( 1.0 - (0.0001 * nframes)) * vu->avr + 0.0001 * avr;
-			if(avr > 100.0) 
-				avr = 100.0;
-			vu->avr = avr;
-			/* for level based segue, use the largest avr VU channel value */
-			if(avr > curSegLevel)
-				curSegLevel = avr;
-			
-			// VU peak fall time constatnt is 50,000 samples - aprox 2 Hz @ sample rate = 96,000
-			vu->peak = vu->peak * ( 1.0 - (0.00002 * nframes));
-			if(pk > 100.0)
-				pk = 100.0;
-			if(pk > vu->peak)
-				vu->peak = pk;
-			
-			/* Mix samples into mix ringbuffers at current write point */
-			invertflag = 0;
-			for(b=0; b<bcount; b++){
-				/* bus b, channel c arranged as a linear array of alternating 
-				 * channels grouped by bus, index = 2*b+c */
-				if(i == 0)
-					/* zero ALL the channel mix buffers for the first mixer input */
-					mixbuffer_sum(mixEngineRef->mixbuses, nframes, NULL, c, b, 1);
-					
-				/* if bus is enabled, mix samples into it's buffer */
-				if((1 << b) & busbits){ // note: only one busbit bit should be set, if any
-					mixbuffer_sum(mixEngineRef->mixbuses, nframes, src, c, b, 0);
-					if((b + 1) == inchrec->tmpFeedBus){
-						invertflag = 1;
-						/* If this bus is also the feed bus, invert scaled input samples
-						 * that are already in the mixminus/feed output buffer */
-						dest = src;
-						for(s = 0; s < nframes; s++){
-							*dest = -(*dest);
-							dest++;
-						}
-					}
-				}
-				
-				if(i == (icount-1)){
-					/* readback of summed bus VU meters goes here */
-				}
+			for(c=0; c<ccount; c++)
+				inchrec->mmBufs[c] = jack_port_get_buffer(inchrec->mm_jPorts[c], nframes);
+		}else{
+			/* silent or idle input: nothing to mix, just let the meters fall */
+			inchrec->tmpLeftVol = inchrec->tmpRightVol = 0.0;
+			curSegLevel = 0.0;
+			vu = inchrec->VUmeters;
+			for(c=0; c<ccount; c++){
+				vu->avr = ( 1.0 - (0.0001 * nframes)) * vu->avr;
+				if(vu->avr > curSegLevel)
+					curSegLevel = vu->avr;
+				vu->peak = vu->peak * ( 1.0 - (0.00002 * nframes));
+				vu++;
 			}
-			if(invertflag == 0)
-				// no mixminus in the feed out.  Zero the temporary scaled input samples.
-				memset(src, 0, nframes * sizeof(jack_default_audio_sample_t));
-			
-			in_port++;
-			out_port++;
+			inchrec->tmpSegLevel = curSegLevel;
 		}
-		
-		if(inchrec->isConnected){
+		inchrec++;
+	}
+	
+	/* buses with insert processing always run it, for a limiter's look-ahead 
+	 * or a compressor's release to carry on into silence */
+	for(b=0; b<bcount; b++){
+		if(mixEngineRef->busDsp[b])
+			busset_add(&mixedBus, b);
+	}
+	
+	/* a bus fed by a bus with audio has audio too: in render order, this 
+	 * carries through any number of submix levels */
+	feed = mixEngineRef->busFeeds;
+	for(i=0; i<mixEngineRef->busFeedCount; i++){
+		if(busset_has(&mixedBus, feed->src))
+			busset_add(&mixedBus, feed->dst);
+		feed++;
+	}
+	
+	/* Flag the mixbus ring spans at the current write point: buses no 
+	 * active input mixes into are marked silent rather than zeroed */
+	for(b=0; b<bcount; b++)
+		mixbuffer_mark(mixEngineRef->mixbuses, nframes, b, !busset_has(&mixedBus, b));
+	mixstats_mark(stats, stage_control, &mark);
+	
+	/* Mix each active input to it's assigned mixbus ring-buffers, with 
+	 * the help of the worker threads, if any */
+	busset_zero(&writtenBus);
+	if(!(mixEngineRef->workers && (acount > 1) && mixworkers_run(mixEngineRef->workers, 
+										mixEngineRef->activeIns, acount, nframes, &writtenBus))){
+		active = mixEngineRef->activeIns;
+		for(a=0; a<acount; a++)
+			mixEngineRef->mixInputProc(mixEngineRef, &mixEngineRef->ins[active[a]], nframes, NULL, 0, &writtenBus);
+	}
+	
+	/* then sum the submix buses on, in render order, running any bus 
+	 * insert chain once the bus is complete: before it feeds on */
+	busset_zero(&dspBus);
+	feed = mixEngineRef->busFeeds;
+	for(i=0; i<mixEngineRef->busFeedCount; i++){
+		runBusDsp(mixEngineRef, feed->src, nframes, &writtenBus, &dspBus);
+		if(busset_has(&writtenBus, feed->src)){
+			for(c=0; c<ccount; c++){
+				samp = mixbuffer_span(mixEngineRef->mixbuses, c, feed->src);
+				dest = mixbuffer_span(mixEngineRef->mixbuses, c, feed->dst);
+				if(busset_has(&writtenBus, feed->dst))
+					mixKernels.scaleSum(dest, samp, feed->gain, nframes);
+				else
+					mixKernels.scale(dest, samp, feed->gain, nframes);
+			}
+			busset_add(&writtenBus, feed->dst);
+		}
+		feed++;
+	}
+	for(b=0; b<bcount; b++)
+		runBusDsp(mixEngineRef, b, nframes, &writtenBus, &dspBus);
+	mixstats_mark(stats, stage_mix, &mark);
+	
+	/* update connection status and advance position: a cart is connected 
+	 * while render has its item */
+	inchrec = mixEngineRef->ins;
+	for(i=0; i<icount; i++){
+		tmpStatus = inchrec->tmpStatus;
+		if(inchrec->cart || inchrec->portConnected){
 			if((inchrec->status & status_standby) == 0){
 				inchrec->status = inchrec->status & (~status_loading);
 				inchrec->status = inchrec->status | status_standby;
 				inchrec->pos = 0.0;
 				inchrec->posSeg = 0.0;
+				inchrec->evSegue = -1;
 				inchrec->changed = inchrec->changed | (change_pos | change_loaded);
 				if(inchrec->persist == persistDisConn)
 					inchrec->persist = persistConnected;
@@ -585,70 +1727,104 @@ int process(jack_nframes_t nframes, void *arg){
 						inchrec->changed = inchrec->changed | change_unloaded;
 					inchrec->status = status_empty;
 					setInChanToDefault(inchrec); 
+					clearInChanEvents(inchrec);
 				}
 			}
 		}
 		
-		/* advance curent time position counter & check for segue */
+		/* advance curent time position counter: an input that started or 
+		 * stopped part way through the cycle played only part of it */
 		if(inchrec->status & status_playing){
-			inchrec->pos = inchrec->pos + frameTime;
-			
-			/* check for time segue when playing and not in Cue, and if segTime & segNext are valid */
-			if(inchrec->posSeg){
-				if((inchrec->segNext) && (inchrec->segNext <= icount)){
-					if((busbits & 2) == 0){
-						if(inchrec->pos > inchrec->posSeg){
-							if((inchrec->levelSeg == 0.0) || (curSegLevel < inchrec->levelSeg)){
-								inChannel *next = &mixEngineRef->ins[inchrec->segNext-1];
-								next->requested = next->requested | change_play;
-								inchrec->posSeg = 0.0;
-								inchrec->segNext = 0;
-								inchrec->levelSeg = 0.0;
-							}
-						}
-					}
-				}
-			}
-			/* check for past next APL event when playing and not in Cue */
-			if(inchrec->nextAplEvent){
-				if(((busbits & 2) == 0) && (inchrec->pos > inchrec->nextAplEvent)){
-					inchrec->changed = inchrec->changed | change_aplEvent;
-				}
-			}
-		}
+			if(inchrec->tmpSplit && !(tmpStatus & status_playing))
+				inchrec->pos = inchrec->pos + (nframes - inchrec->tmpSplit) / (double)mixEngineRef->mixerSampleRate;
+			else
+				inchrec->pos = inchrec->pos + frameTime;
+		}else if(inchrec->tmpSplit && (tmpStatus & status_playing))
+			inchrec->pos = inchrec->pos + inchrec->tmpSplit / (double)mixEngineRef->mixerSampleRate;
+		/* a cart started part way through a cycle can run off the end of 
+		 * its item: the rest read as silence, and it stops next cycle */
+		if(inchrec->cart && (inchrec->pos > ((double)inchrec->cart->frames / mixEngineRef->mixerSampleRate)))
+			inchrec->pos = (double)inchrec->cart->frames / mixEngineRef->mixerSampleRate;
 		
 		if(inchrec->status != tmpStatus){
 			inchrec->changed = inchrec->changed | change_stat;
 		}
-		/* check if we changed the associated changed flags */
+		/* publish the changes, if any.  If the queue is full, the 
+		 * bits are kept and go out with the next cycle's */
 		if(inchrec->changed){
-			wakeChanged = 1;
+			change.target = i;
+			change.changed = inchrec->changed;
+			change.status = inchrec->status;
+			change.bus = inchrec->busses;
+			change.routes = inchrec->routes;
+			change.feedBus = inchrec->feedBus;
+			change.vol = inchrec->vol;
+			change.bal = inchrec->bal;
+			change.feedVol = inchrec->feedVol;
+			change.delay = 0.0;
+			change.pos = inchrec->pos;
+			if(publishChange(mixEngineRef, &change)){
+				inchrec->changed = 0;
+				wakeChanged = 1;
+			}
 		}
 		inchrec++;
 	}
+	mixstats_mark(stats, stage_status, &mark);
 	
-	/* distrubute mix buffers to assigned input mix-minus outputs */
+	/* distrubute mix buffers to assigned input mix-minus outputs: first 
+	 * list the inputs with a feed to render, and the buses they are fed */
+	busset_zero(&feedBus);
+	fcount = 0;
 	inchrec = mixEngineRef->ins;
 	for(i=0; i<icount; i++){
-		if(inchrec->tmpFeedBus && (inchrec->tmpFeedBus <= bcount)){
+		if(inchrec->mmConnected && inchrec->tmpFeedBus && (inchrec->tmpFeedBus <= bcount)){
+			mixEngineRef->feedIns[fcount++] = i;
+			busset_add(&feedBus, inchrec->tmpFeedBus - 1);
+			inchrec->mmRendered = 1;
+		}else if(inchrec->mmRendered){
+			/* no feed, or nothing connected to hear it: clear the outputs once, 
+			 * so no stale samples are played if the outputs are connected later */
 			out_port = inchrec->mm_jPorts;
-			vol = inchrec->feedVol;
 			for(c=0; c<ccount; c++){
-				/* channel c */
 				samp = jack_port_get_buffer(*out_port, nframes);
-				/* add samples from assigned mixbus ring buffer */
-				mixbuffer_read(mixEngineRef->mixbuses, nframes, 
-										0, samp, c, inchrec->tmpFeedBus-1, 1);
-				/* scale the sample for the set mix-minus volume */
-				for(s = 0; s < nframes; s++){
-					*samp = *samp * vol;
-					samp++;
-				}
+				memset(samp, 0, nframes * sizeof(jack_default_audio_sample_t));
 				out_port++;
 			}
+			inchrec->mmRendered = 0;
 		}
 		inchrec++;
 	}
+	/* then one bus channel at a time, so the bus samples stay in cache 
+	 * while every feed of the bus is written from them.  Each feed is the 
+	 * bus minus the input's own contribution: the inverted input samples 
+	 * left in the feed output by mixInput() when the input is on the bus */
+	for(b = busset_next(&feedBus, 0); b < bcount; b = busset_next(&feedBus, b + 1)){
+		for(c=0; c<ccount; c++){
+			/* silent buses were never written this cycle */
+			if(busset_has(&mixedBus, b))
+				dest = mixbuffer_span(mixEngineRef->mixbuses, c, b);
+			else
+				dest = NULL;
+			for(a=0; a<fcount; a++){
+				inchrec = &mixEngineRef->ins[mixEngineRef->feedIns[a]];
+				if(inchrec->tmpFeedBus != (b + 1))
+					continue;
+				vol = inchrec->feedVol;
+				samp = jack_port_get_buffer(inchrec->mm_jPorts[c], nframes);
+				if(inchrec->tmpMixMinus){
+					if(dest)
+						mixKernels.sumScale(samp, dest, vol, nframes);
+					else
+						mixKernels.scale(samp, samp, vol, nframes);
+				}else if(dest)
+					mixKernels.scale(samp, dest, vol, nframes);
+				else
+					memset(samp, 0, nframes * sizeof(jack_default_audio_sample_t));
+			}
+		}
+	}
+	mixstats_mark(stats, stage_mixMinus, &mark);
 	
 	/* distribute mix buffers to assigned output groups */
 	icount = mixEngineRef->outCount;
@@ -672,9 +1848,23 @@ int process(jack_nframes_t nframes, void *arg){
 			outchrec->changed = outchrec->changed | change_bus;
 		}
 		
-		delay = outchrec->delay * mixEngineRef->mixerSampleRate;
 		if((b = outchrec->bus) >= bcount)
 			b = 0;
+		if((line = outchrec->delayLine) && (line->bufSizeSamples < nframes))
+			/* too short for the cycle, until the callback's longer line arrives */
+			line = NULL;
+		if(line){
+			/* feed this cycle's bus samples into the delay line, even with 
+			 * nothing connected, so the history is there when there is */
+			delay = outchrec->delay * mixEngineRef->mixerSampleRate;
+			if(delay > (line->bufSizeSamples - nframes))
+				delay = line->bufSizeSamples - nframes;
+			mixbuffer_mark(line, nframes, 0, !busset_has(&mixedBus, b));
+			if(busset_has(&mixedBus, b)){
+				for(c=0; c<ccount; c++)
+					mixbuffer_copy(line, nframes, mixEngineRef->mixbuses, c, 0, b);
+			}
+		}
 
 			// set output device volume to lowest active mute group channel gain * current device volume
 			least = 0xff;
@@ -703,36 +1893,69 @@ int process(jack_nframes_t nframes, void *arg){
 				if(groupGain < least)
 					least = groupGain;
 			}
-			vol = ((float)least / 255.0); // make a float
-			vol = powf(vol, 3) * outchrec->vol;
+			vol = muteGain[least] * outchrec->vol;
 		
-		/* note: ccount still set from input processing loop */
-		for(c=0; c<ccount; c++){
-			/* channel c of output number i */
-			samp = dest = jack_port_get_buffer(*out_port, nframes);
-			
-			/* get samples from assigned mixbus ring buffer */
-			mixbuffer_read(mixEngineRef->mixbuses, nframes, 
-											delay, dest, c, b, 0);
-			
-			if(vol < 1.0){	
-				/* scale the sample for the output group volume */
-				for(s = 0; s < nframes; s++){
-					*samp = *samp * vol;
-					samp++;
-				}
+		if(outchrec->isConnected){
+			/* note: ccount still set from input processing loop */
+			for(c=0; c<ccount; c++){
+				/* channel c of output number i */
+				samp = dest = jack_port_get_buffer(*out_port, nframes);
+				
+				if(line)
+					/* get samples from the delay line */
+					mixbuffer_read(line, nframes, delay, dest, c, 0, 0);
+				else
+					/* get samples from assigned mixbus buffer */
+					mixbuffer_read(mixEngineRef->mixbuses, nframes, 
+												0, dest, c, b, 0);
+				
+				if(vol != outchrec->tmpGain)
+					/* ramp from the last cycle's gain, rather than step */
+					mixKernels.scaleRamp(dest, dest, outchrec->tmpGain, 
+											(vol - outchrec->tmpGain) / nframes, nframes);
+				else if(vol < 1.0)
+					/* scale the sample for the output group volume */
+					mixKernels.scale(dest, dest, vol, nframes);
+				if(outchrec->dsp)
+					outchrec->dsp->bufs[c] = dest;
+				out_port++;
 			}
-			out_port++;
+			if(outchrec->dsp)
+				/* insert processing, after the volume */
+				mixdsp_process(outchrec->dsp, nframes);
+			outchrec->rendered = 1;
+		}else if(outchrec->rendered){
+			/* nothing connected: clear the outputs once, then skip them */
+			for(c=0; c<ccount; c++){
+				dest = jack_port_get_buffer(*out_port, nframes);
+				memset(dest, 0, nframes * sizeof(jack_default_audio_sample_t));
+				out_port++;
+			}
+			outchrec->rendered = 0;
 		}
+		outchrec->tmpGain = vol;
+		if(line)
+			mixbuffer_advance(line, nframes);
 		/* after all requests have been handled */
 		outchrec->requested = 0;
 		
-		/* check if we changed the associated changed flags */
-		if(outchrec->changed)
-			wakeChanged = 1;
+		/* publish the changes, if any */
+		if(outchrec->changed){
+			memset(&change, 0, sizeof(change));
+			change.target = i | changeOutGroup;
+			change.changed = outchrec->changed;
+			change.bus = outchrec->bus;
+			change.vol = outchrec->vol;
+			change.delay = outchrec->delay;
+			if(publishChange(mixEngineRef, &change)){
+				outchrec->changed = 0;
+				wakeChanged = 1;
+			}
+		}
 			
 		outchrec++;
 	}
+	mixstats_mark(stats, stage_outGroups, &mark);
 	
 	/* and copy mix buffers to corrisponding mix outputs */
 	bcount = mixEngineRef->busCount;
@@ -740,20 +1963,36 @@ int process(jack_nframes_t nframes, void *arg){
 	for(b=0; b<bcount; b++){
 		for(c=0; c<ccount; c++){
 			/* channel c of mix output number b */
-			dest = samp = jack_port_get_buffer(*out_port, nframes);
-			/* get samples from assigned mixbus ring buffer */
-			mixbuffer_read(mixEngineRef->mixbuses, nframes, 
-														0, dest, c, b, 0);
+			dest = jack_port_get_buffer(*out_port, nframes);
+			if(busset_has(&mixedBus, b))
+				/* get samples from assigned mixbus ring buffer */
+				mixbuffer_read(mixEngineRef->mixbuses, nframes, 
+															0, dest, c, b, 0);
+			else
+				/* silent bus: nothing to read back */
+				memset(dest, 0, nframes * sizeof(jack_default_audio_sample_t));
+			out_port++;
+		}
+	}
+	mixstats_mark(stats, stage_busOut, &mark);
+	
+	/* and meter the mix outputs */
+	out_port = mixEngineRef->mixbuses->busout_jPorts;
+	for(b=0; b<bcount; b++){
+		for(c=0; c<ccount; c++){
 			pk = 0.0;
 			avr = 0.0;
-			for(s = 0; s < nframes; s++){
-				// VU meter sample calculations - all VU levels are squared (power)
-				SampSqrd = (*samp) * (*samp);
-				avr = avr + SampSqrd;
-				if(SampSqrd > pk)
-					pk = SampSqrd;
-					
-				samp++;
+			if(busset_has(&mixedBus, b)){
+				samp = jack_port_get_buffer(*out_port, nframes);
+				for(s = 0; s < nframes; s++){
+					// VU meter sample calculations - all VU levels are squared (power)
+					SampSqrd = (*samp) * (*samp);
+					avr = avr + SampSqrd;
+					if(SampSqrd > pk)
+						pk = SampSqrd;
+						
+					samp++;
+				}
 			}
 			
 			/* VU Block calculations */
@@ -774,34 +2013,84 @@ int process(jack_nframes_t nframes, void *arg){
 			out_port++;
 		}
 	}
+	mixstats_mark(stats, stage_meters, &mark);
 	
 	// update the mix-engine record of the active mute buses
-	if(activeBus != mixEngineRef->activeBus){
-		mixEngineRef->activeBus = activeBus;
-		wakeChanged = 1;
-	}
-	
-	/* advance mixbus buffer write marker */
-	mixbuffer_advance(mixEngineRef->mixbuses, nframes);
-	
-	/* handle sending queued out-going control packets
-	 *  upto one per  process cycle.  These come off the ring buffer already MIDI SysEx encoded. */
-	size = jack_ringbuffer_peek(mixEngineRef->ctlOutQueue, (char*)&header, sizeof(controlPacket));
-	if(size == sizeof(controlPacket)){
-		if(decodeControlPacket(&header, 1)){
-			size = sizeof(controlPacket) + controlDataSizeFromRaw(ntohs(header.dataSize));
-			if(jack_ringbuffer_read_space(mixEngineRef->ctlOutQueue) >= size){
-				if(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, nframes-1, size)){
-					jack_ringbuffer_read(mixEngineRef->ctlOutQueue, (char*)packet, size);
-				}
-			}
+	mixEngineRef->activeBus = activeBus;
+	if(activeBus != mixEngineRef->sentActiveBus){
+		memset(&change, 0, sizeof(change));
+		change.target = changeEngine;
+		change.bus = activeBus;
+		if(publishChange(mixEngineRef, &change)){
+			mixEngineRef->sentActiveBus = activeBus;
+			wakeChanged = 1;
 		}
 	}
 	
-	/* One or more Changed flags have been set... signal the thread that cares */
+	/* advance the frame clock: the mixbus buffers are not advanced, they 
+	 * hold just the current cycle */
+	__atomic_store_n(&mixEngineRef->frameClock, mixEngineRef->frameClock + nframes, __ATOMIC_RELAXED);
+	
+	/* send queued out-going control packets, as many as the budget allows.  
+	 * These come off the ring buffer already MIDI SysEx encoded. */
+	ctlqueue_drain(mixEngineRef->ctlOutQueue, midi_buffer, nframes-1, 
+			__atomic_load_n(&mixEngineRef->ctlOutBytes, __ATOMIC_RELAXED), 
+			__atomic_load_n(&mixEngineRef->ctlOutEvents, __ATOMIC_RELAXED), 
+			&mixEngineRef->ctlOutStats);
+	
+	/* One or more changes have been published... signal the thread that cares */
 	if(wakeChanged)
-		pthread_cond_broadcast(&mixEngineRef->changedSemaphore);
+		signalEventFD(mixEngineRef->changeFD);
+	
+	mixstats_mark(stats, stage_cycle, &start);
+	mixstats_end(stats);
+	return 0;
+}
+
+/* JACK buffer size callback: called before the first process cycle of a 
+ * new period size, in a JACK thread, not the render thread.  A period 
+ * longer than the bus buffers gets longer ones made here, for render to 
+ * swap in, and the delay lines, dsp chains and cart padding are resized 
+ * to match.  Shorter periods use the buffers as they are. */
+static int jack_bufsize_callback(jack_nframes_t nframes, void *arg){
+	mixEngineRecPtr mixEngineRef = (mixEngineRecPtr)arg;
+	mixbuffer_t *buses;
+	outChannel *outchrec;
+	unsigned int i;
+	char *spec;
 	
+	if(nframes <= mixEngineRef->busFrames)
+		return 0;
+	if((buses = mixbuffer_create(nframes, mixEngineRef->chanCount, mixEngineRef->busCount, NULL)) == NULL){
+		serverLogMakeEntry("[mixer] jack_bufsize_callback-:bus buffer allocation failed; outputs will be silent");
+		return 0;
+	}
+	pthread_rwlock_wrlock(&mixEngineRef->outGrpLock);
+	mixEngineRef->busFrames = buses->bufSizeSamples;
+	if(buses = __atomic_exchange_n(&mixEngineRef->busResize, buses, __ATOMIC_ACQ_REL))
+		/* render never took the last ones */
+		mixbuffer_free(buses);
+	mixcarts_setPad(mixEngineRef->carts, mixEngineRef->busFrames);
+	
+	/* remake what is sized by the period, from the settings last sent */
+	for(i=0; i<mixEngineRef->outCount; i++){
+		outchrec = &mixEngineRef->outs[i];
+		if(outchrec->sentDelayLine)
+			setOutputDelay(mixEngineRef, i, outchrec->sentDelay);
+		if(outchrec->dspSpec && (spec = strdup(outchrec->dspSpec))){
+			if(setOutputDsp(mixEngineRef, i, spec))
+				serverLogMakeEntry("[mixer] jack_bufsize_callback-:output dsp chain not resized");
+			free(spec);
+		}
+	}
+	for(i=0; i<mixEngineRef->busCount; i++){
+		if(mixEngineRef->busDspSpecs[i] && (spec = strdup(mixEngineRef->busDspSpecs[i]))){
+			if(setBusDsp(mixEngineRef, i, spec))
+				serverLogMakeEntry("[mixer] jack_bufsize_callback-:bus dsp chain not resized");
+			free(spec);
+		}
+	}
+	pthread_rwlock_unlock(&mixEngineRef->outGrpLock);
 	return 0;
 }
 
@@ -826,6 +2115,15 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 	def_busses = 0x5;	// default to monitor and main bus
 	def_bal = 0.0;		// default to center
 	
+	*mixEngineRef = NULL;
+	if(buses > mix_max_buses)
+		return "too many mix buses";
+	
+	/* pick the fastest sample kernels this CPU supports */
+	mixkernels_init(NULL);
+	for(i=0; i<256; i++)
+		muteGain[i] = powf(i / 255.0, 3);
+	
 	/* create holdering structore for all mixer related stuff */
 	size = sizeof(mixEngineRec);
 	*mixEngineRef = mixRef = calloc(1, size);
@@ -835,6 +2133,15 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 
 	/* set related mixer reference variables */
 	mixRef->chanCount = width;
+	/* channel count specific render paths for the common widths */
+	if(width == 1)
+		mixRef->mixInputProc = mixInput1;
+	else if(width == 2)
+		mixRef->mixInputProc = mixInput2;
+	else if(width == 6)
+		mixRef->mixInputProc = mixInput6;
+	else
+		mixRef->mixInputProc = mixInput;
 	mixRef->inCount = inputs;
 	mixRef->outCount = outputs;
 	mixRef->busCount = buses;
@@ -842,14 +2149,17 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 	pthread_mutex_init(&mixRef->jackMutex, NULL);  
 	
 	pthread_mutex_init(&mixRef->ctlOutQueueMutex, NULL);  
-	pthread_mutex_init(&mixRef->changedMutex, NULL);  
-	pthread_cond_init(&mixRef->changedSemaphore, NULL);
+	pthread_mutex_init(&mixRef->cmdQueueMutex, NULL);  
 	pthread_rwlock_init(&mixRef->outGrpLock, NULL);
 
 	pthread_mutex_init(&mixRef->cbQueueMutex, NULL);  
 	pthread_cond_init(&mixRef->cbQueueSemaphore, NULL);
-	pthread_mutex_init(&mixRef->ctlInQueueMutex, NULL);  
-	pthread_cond_init(&mixRef->ctlInQueueSemaphore, NULL);
+	mixRef->ctlInQueueFD = -1;
+	mixRef->changeFD = -1;
+	if((mixRef->ctlInQueueFD = eventfd(0, EFD_CLOEXEC)) < 0)
+		return "control queue eventfd creation failed";
+	if((mixRef->changeFD = eventfd(0, EFD_CLOEXEC)) < 0)
+		return "change queue eventfd creation failed";
 	
 	/* set up connection to jack audio server */
 	if(server)
@@ -865,11 +2175,32 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 	mixRef->ourJackName = jack_get_client_name(mixRef->client);
 	mixRef->mixerSampleRate = jack_get_sample_rate(mixRef->client);
 
-	/* allocate mix buffers (to support output delays) */
-	size = mixRef->mixerSampleRate * mix_buffer_durration; 	// size of buffer in samples
+	/* allocate the mix bus buffers: these hold the current cycle only, 
+	 * output groups with a delay keep their own history */
+	size = jack_get_buffer_size(mixRef->client);
+	if(size < mix_bus_frames)
+		size = mix_bus_frames;
 	mixRef->mixbuses = mixbuffer_create(size, width, buses, mixRef->client);
 	if(mixRef->mixbuses == NULL)
 		return "failed to allocate mix bus buffers";
+	mixRef->busFrames = mixRef->mixbuses->bufSizeSamples;
+	/* carts are read a cycle at a time, starting up to a cycle early */
+	if((mixRef->carts = mixcarts_init(width, mixRef->mixbuses->bufSizeSamples)) == NULL)
+		return "cart pool allocation failed";
+	if((mixRef->retiredLines = jack_ringbuffer_create(retiredLinesSize * sizeof(mixbuffer_t *))) == NULL)
+		return "retired delay line queue allocation failed";
+	mlock(mixRef->retiredLines, retiredLinesSize * sizeof(mixbuffer_t *));
+	if((mixRef->retiredChains = jack_ringbuffer_create(retiredChainsSize * sizeof(dspChain *))) == NULL)
+		return "retired dsp chain queue allocation failed";
+	mlock(mixRef->retiredChains, retiredChainsSize * sizeof(dspChain *));
+	pthread_mutex_init(&mixRef->retiredCtlsMutex, NULL);
+	if((mixRef->retiredCtls = jack_ringbuffer_create(retiredCtlsSize * sizeof(ctlShm *))) == NULL)
+		return "retired control channel queue allocation failed";
+	mlock(mixRef->retiredCtls, retiredCtlsSize * sizeof(ctlShm *));
+
+	/* render stage timing */
+	if((mixRef->stats = mixstats_create()) == NULL)
+		return "failed to allocate mixer timing stats";
 
 	/* create peer control ports and queues */
 	mixRef->ctlInPort = jack_port_register(mixRef->client, "ctlIn", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
@@ -884,18 +2215,47 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 	if((mixRef->ctlOutQueue = jack_ringbuffer_create(ctlQueueSizeBytes)) == NULL)
 		return "control queue (send) ring buffer allocation failed.";
 	mlock(mixRef->ctlOutQueue, ctlQueueSizeBytes);
+	if((mixRef->changeQueue = jack_ringbuffer_create(changeQueueSize * sizeof(mixChange))) == NULL)
+		return "change queue ring buffer allocation failed.";
+	mlock(mixRef->changeQueue, changeQueueSize * sizeof(mixChange));
+	if((mixRef->cmdQueue = jack_ringbuffer_create(cmdQueueSize * sizeof(mixCommand))) == NULL)
+		return "command queue ring buffer allocation failed.";
+	mlock(mixRef->cmdQueue, cmdQueueSize * sizeof(mixCommand));
+	if(mixRef->cmdHeld = (mixCommand *)calloc(cmdHeldSize, sizeof(mixCommand)))
+		mlock(mixRef->cmdHeld, cmdHeldSize * sizeof(mixCommand));
+	else
+		return "memory allocation for timed command list failed";
 
 	pthread_spin_init(&mixRef->cbQueue.spinlock, PTHREAD_PROCESS_PRIVATE);
 	clearCBQ(&mixRef->cbQueue);
 	
+	/* list of inputs with audio to mix, built each cycle by process */
+	if(mixRef->activeIns = (unsigned int*)calloc(inputs, sizeof(unsigned int)))
+		mlock(mixRef->activeIns, sizeof(unsigned int) * inputs);
+	else
+		return "memory allocation for active input list failed";
+	if(mixRef->feedIns = (unsigned int*)calloc(inputs, sizeof(unsigned int)))
+		mlock(mixRef->feedIns, sizeof(unsigned int) * inputs);
+	else
+		return "memory allocation for mix-minus input list failed";
+	if(mixRef->busDsp = (dspChain **)calloc(buses, sizeof(dspChain *)))
+		mlock(mixRef->busDsp, sizeof(dspChain *) * buses);
+	else
+		return "memory allocation for bus dsp list failed";
+	if((mixRef->busDspSpecs = (char **)calloc(buses, sizeof(char *))) == NULL)
+		return "memory allocation for bus dsp list failed";
+
 	/* create JACK mixer input channels */
 	size = sizeof(inChannel) * inputs;
-	if(mixRef->ins = (inChannel*)calloc(inputs, sizeof(inChannel))){
+	if(mixRef->ins = (inChannel*)mixbuffer_alloc(size)){
 		mlock(mixRef->ins, size);
 		inChannel *chrec = mixRef->ins;
 		for(i=0; i<inputs; i++){
 			chrec->status = status_empty; 
+			chrec->mmRendered = 1;	// clear the mm outputs on the first cycle
+			chrec->portConnected = 0;
 			setInChanToDefault(chrec);
+			clearInChanEvents(chrec);
 			/* Create Jack ports for inputs */
 			if(chrec->in_jPorts = (jack_port_t**)calloc(width, 
 											sizeof(jack_port_t *))){
@@ -929,7 +2289,18 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 			}else
 				return "memory allocation for premix tap ports failed";	
 			
-			if(chrec->VUmeters = (vuData*)calloc(width, sizeof(vuData)))
+			/* port buffer pointers for the current cycle */
+			chrec->inBufs = (jack_default_audio_sample_t **)calloc(width, sizeof(jack_default_audio_sample_t *));
+			chrec->mmBufs = (jack_default_audio_sample_t **)calloc(width, sizeof(jack_default_audio_sample_t *));
+			if(chrec->inBufs && chrec->mmBufs){
+				mlock(chrec->inBufs, sizeof(jack_default_audio_sample_t *) * width);
+				mlock(chrec->mmBufs, sizeof(jack_default_audio_sample_t *) * width);
+			}else
+				return "memory allocation for input buffer lists failed";
+			
+			/* each input's meters on their own cache line: mix workers 
+			 * update them for different inputs at the same time */
+			if(chrec->VUmeters = (vuData*)mixbuffer_alloc(sizeof(vuData) * width))
 				mlock(chrec->VUmeters, sizeof(vuData) * width);
 			else
 				return "memory allocation for input VU meter array failed";	
@@ -948,6 +2319,7 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 			chrec->vol = 1.0;
 			chrec->muteLevels = -1; // default no mute/ducking on mute groups
 			chrec->bus = 0x1 << i; // default: associate out number with bus number
+			chrec->rendered = 1;	// clear the outputs on the first cycle
 			/* Create Jack ports for output groups */
 			if(chrec->jPorts = (jack_port_t**)calloc(width, 
 											sizeof(jack_port_t *))){
@@ -970,6 +2342,8 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 
 	jack_set_process_callback(mixRef->client, process, mixRef);
 	jack_on_shutdown(mixRef->client, jack_shutdown_callback, mixRef);
+	jack_set_xrun_callback(mixRef->client, jack_xrun_callback, mixRef);
+	jack_set_buffer_size_callback(mixRef->client, jack_bufsize_callback, mixRef);
 	
 	jack_set_port_registration_callback(mixRef->client, jack_reg_callback, mixRef);
 	jack_set_port_rename_callback(mixRef->client, jack_rename_callback, mixRef);
@@ -996,9 +2370,18 @@ void shutdownMixer(mixEngineRecPtr mixEngineRef){
 	
 	if(mixEngineRef->client)
 		jack_deactivate(mixEngineRef->client);
+	/* stop and free the mix worker threads */
+	if(mixEngineRef->workers)
+		mixworkers_free(mixEngineRef->workers);
 	/* free mix buss ring buffers */
 	if(mixEngineRef->mixbuses)
 		mixbuffer_free(mixEngineRef->mixbuses);
+	if(mixEngineRef->busResize)
+		mixbuffer_free(mixEngineRef->busResize);
+	if(mixEngineRef->stats)
+		mixstats_free(mixEngineRef->stats);
+	/* free the cart items, in use or not: render has stopped */
+	mixcarts_free(mixEngineRef->carts);
 	/* free mixer inputs and associated pre-mix outputs */
 	if(mixEngineRef->ins){
 		inChannel *chrec = mixEngineRef->ins;
@@ -1012,15 +2395,25 @@ void shutdownMixer(mixEngineRecPtr mixEngineRef){
 				free(chrec->mm_jPorts);	
 			}
 			
+			if(chrec->inBufs){
+				munlock(chrec->inBufs, sizeof(jack_default_audio_sample_t *) * mixEngineRef->chanCount);	
+				free(chrec->inBufs);
+			}
+			if(chrec->mmBufs){
+				munlock(chrec->mmBufs, sizeof(jack_default_audio_sample_t *) * mixEngineRef->chanCount);	
+				free(chrec->mmBufs);
+			}
+			ctlshm_free(chrec->ctl);
+			
 			if(chrec->VUmeters){
 				munlock(chrec->VUmeters, sizeof(vuData) * mixEngineRef->chanCount);	
-				free(chrec->VUmeters);
+				mixbuffer_release(chrec->VUmeters, sizeof(vuData) * mixEngineRef->chanCount);
 			}
 			
 			chrec++;	
 		}
 		munlock(mixEngineRef->ins, sizeof(inChannel) * mixEngineRef->inCount);	
-		free(mixEngineRef->ins);
+		mixbuffer_release(mixEngineRef->ins, sizeof(inChannel) * mixEngineRef->inCount);
 	}	
 	
 	/* free mixer output groups */
@@ -1035,13 +2428,53 @@ void shutdownMixer(mixEngineRecPtr mixEngineRef){
 				munlock(chrec->jPorts, sizeof(jack_port_t *) * mixEngineRef->chanCount);
 				free(chrec->jPorts);
 			}
+			if(chrec->delayLine)
+				mixbuffer_free(chrec->delayLine);
+			mixdsp_free(chrec->dsp);
+			if(chrec->dspSpec)
+				free(chrec->dspSpec);
 			chrec++;	
 		}
 		munlock(mixEngineRef->outs, sizeof(outChannel) * mixEngineRef->outCount);	
 		free(mixEngineRef->outs);		
 	}
-	pthread_cond_destroy(&mixEngineRef->changedSemaphore);
-	pthread_mutex_destroy(&mixEngineRef->changedMutex);
+	if(mixEngineRef->activeIns){
+		munlock(mixEngineRef->activeIns, sizeof(unsigned int) * mixEngineRef->inCount);
+		free(mixEngineRef->activeIns);
+	}
+	if(mixEngineRef->feedIns){
+		munlock(mixEngineRef->feedIns, sizeof(unsigned int) * mixEngineRef->inCount);
+		free(mixEngineRef->feedIns);
+	}
+	if(mixEngineRef->busDsp){
+		for(i=0; i<mixEngineRef->busCount; i++)
+			mixdsp_free(mixEngineRef->busDsp[i]);
+		munlock(mixEngineRef->busDsp, sizeof(dspChain *) * mixEngineRef->busCount);
+		free(mixEngineRef->busDsp);
+	}
+	if(mixEngineRef->busDspSpecs){
+		for(i=0; i<mixEngineRef->busCount; i++){
+			if(mixEngineRef->busDspSpecs[i])
+				free(mixEngineRef->busDspSpecs[i]);
+		}
+		free(mixEngineRef->busDspSpecs);
+	}
+	if(mixEngineRef->retiredLines){
+		freeRetiredDelayLines(mixEngineRef);
+		munlock(mixEngineRef->retiredLines, retiredLinesSize * sizeof(mixbuffer_t *));
+		jack_ringbuffer_free(mixEngineRef->retiredLines);
+	}
+	if(mixEngineRef->retiredChains){
+		freeRetiredDspChains(mixEngineRef);
+		munlock(mixEngineRef->retiredChains, retiredChainsSize * sizeof(dspChain *));
+		jack_ringbuffer_free(mixEngineRef->retiredChains);
+	}
+	if(mixEngineRef->retiredCtls){
+		freeRetiredCtls(mixEngineRef);
+		munlock(mixEngineRef->retiredCtls, retiredCtlsSize * sizeof(ctlShm *));
+		jack_ringbuffer_free(mixEngineRef->retiredCtls);
+	}
+	pthread_mutex_destroy(&mixEngineRef->retiredCtlsMutex);
 	pthread_rwlock_destroy(&mixEngineRef->outGrpLock);
 	
 	/* free control ports and queues */
@@ -1055,9 +2488,24 @@ void shutdownMixer(mixEngineRecPtr mixEngineRef){
 		munlock(mixEngineRef->ctlOutQueue, ctlQueueSizeBytes);
 		jack_ringbuffer_free(mixEngineRef->ctlOutQueue);
 	}	
+	if(mixEngineRef->cmdQueue){
+		munlock(mixEngineRef->cmdQueue, cmdQueueSize * sizeof(mixCommand));
+		jack_ringbuffer_free(mixEngineRef->cmdQueue);
+	}
+	if(mixEngineRef->cmdHeld){
+		munlock(mixEngineRef->cmdHeld, cmdHeldSize * sizeof(mixCommand));
+		free(mixEngineRef->cmdHeld);
+	}
 	pthread_mutex_destroy(&mixEngineRef->ctlOutQueueMutex);
-	pthread_cond_destroy(&mixEngineRef->ctlInQueueSemaphore);
-	pthread_mutex_destroy(&mixEngineRef->ctlInQueueMutex);  
+	pthread_mutex_destroy(&mixEngineRef->cmdQueueMutex);
+	if(mixEngineRef->changeQueue){
+		munlock(mixEngineRef->changeQueue, changeQueueSize * sizeof(mixChange));
+		jack_ringbuffer_free(mixEngineRef->changeQueue);
+	}
+	if(mixEngineRef->changeFD >= 0)
+		close(mixEngineRef->changeFD);
+	if(mixEngineRef->ctlInQueueFD >= 0)
+		close(mixEngineRef->ctlInQueueFD);
 	
 	pthread_mutex_destroy(&mixEngineRef->cbQueueMutex);  
 	pthread_cond_destroy(&mixEngineRef->cbQueueSemaphore);
@@ -37,6 +37,10 @@ extern "C"
 #include <jack/ringbuffer.h>
 
 #include "mixbuffers.h"
+#include "mixdsp.h"
+#include "mixcarts.h"
+#include "../common/ctlqueue.h"
+#include "../common/ctlshm.h"
 
 #define cbQsize	256		// must be a power of 2
 #define cbMASK	cbQsize-1
@@ -50,37 +54,120 @@ typedef struct{
 
 #define sourceTypeLive		0
 #define sourceTypeCanRepos	1
+#define sourceTypeMem		2	// RAM resident cart, played by render: no player, no ports
 
 #define persistConnected 1
 #define persistDisConn 2
 #define persistOff 0
 
+/* A set of mix buses, of any width up to mix_max_buses: bus b is bit 
+ * (b & 63) of word b >> 6.  The packed 32 bit busses words of the control 
+ * protocol only have room for buses 0 to 23. */
+#define mix_max_buses	128
+#define busSetWords		(mix_max_buses / 64)
+
+typedef struct{
+	uint64_t w[busSetWords];
+} busSet;
+
+static inline void busset_zero(busSet *set){
+	memset(set, 0, sizeof(busSet));
+}
+
+static inline void busset_add(busSet *set, unsigned int bus){
+	set->w[bus >> 6] |= (uint64_t)1 << (bus & 63);
+}
+
+static inline unsigned char busset_has(const busSet *set, unsigned int bus){
+	return (set->w[bus >> 6] >> (bus & 63)) & 1;
+}
+
+static inline unsigned char busset_any(const busSet *set){
+	unsigned int i;
+	
+	for(i=0; i<busSetWords; i++){
+		if(set->w[i])
+			return 1;
+	}
+	return 0;
+}
+
+/* the first bus in set from bus on, or mix_max_buses if there are none, 
+ * for looping over the buses in a set: 
+ * for(b = busset_next(&set, 0); b < count; b = busset_next(&set, b + 1)) */
+static inline unsigned int busset_next(const busSet *set, unsigned int bus){
+	unsigned int i;
+	uint64_t bits;
+	
+	if(bus >= mix_max_buses)
+		return mix_max_buses;
+	i = bus >> 6;
+	bits = set->w[i] & (~(uint64_t)0 << (bus & 63));
+	while(!bits){
+		if(++i >= busSetWords)
+			return mix_max_buses;
+		bits = set->w[i];
+	}
+	return (i << 6) + __builtin_ctzll(bits);
+}
+
+/* 32 bus words, as in the control protocol: word n is buses 32n to 32n + 31 */
+static inline uint32_t busset_word(const busSet *set, unsigned int n){
+	return set->w[n >> 1] >> ((n & 1) * 32);
+}
+
+static inline void busset_setWord(busSet *set, unsigned int n, uint32_t bits){
+	set->w[n >> 1] = (set->w[n >> 1] & ~((uint64_t)0xffffffff << ((n & 1) * 32))) 
+											| ((uint64_t)bits << ((n & 1) * 32));
+}
+
+/* A submix feed: bus src summed into bus dst at gain, after the inputs 
+ * are mixed.  A bus can feed, and be fed by, any number of other buses, 
+ * as long as there are no loops. */
+#define mix_max_busFeeds	256
+
+typedef struct{
+	unsigned char src;
+	unsigned char dst;
+	float gain;
+} busFeed;
+
+/* input records are cache line aligned: mix worker threads write to 
+ * neighbouring inputs at the same time */
 typedef struct{
 	unsigned char sourceType;
-	unsigned char isConnected;
+	unsigned char portConnected;	// set by jackChangeWatcher only: an input port has a connection
 	uint32_t UID;
 	pid_t attached;
 	FILE *aplFile;
-	float nextAplEvent;		// changed flag change_aplEvent set by render when pos > this. Zero prevents render from checking.
+	float nextAplEvent;		// changed flag change_aplEvent set by render when pos > this, once scheduled. Zero for none.
 	unsigned char aplFPmatch;	// true if apl files's library fingerprint match current library - apl logging can include item IDs.
 	unsigned char persist;
 	jack_port_t **in_jPorts;	// chanCount size array
 	jack_port_t **mm_jPorts;	// chanCount size array
+	jack_default_audio_sample_t **inBufs;	// chanCount array: in_jPorts buffers for the current cycle
+	jack_default_audio_sample_t **mmBufs;	// chanCount array: mm_jPorts buffers for the current cycle
 	vuData *VUmeters;		// chanCount array of vuData
+	cartItem *cart;		// render thread only: the item played in place of in_jPorts, NULL for none
+	ctlShm *ctl;		// render thread only: shared memory control channel to the player, NULL for MIDI only
 	
-	/* requested values, set by external threads */
+	/* requested values, set by render from queued commands */
 	float reqVol;
 	float reqBal;
 	float reqPos;
 	uint32_t reqBusses;
+	busSet reqRoutes;
 	uint32_t reqFeedBus;
 	float reqFeedVol;
 		
 	/* current values, set by render thread */
 	float vol;
 	double pos;			// high res. for small sample chunks
-	float bal;
-	uint32_t busses;		// bits corispond to enabled bus numbers
+	float bal;			// set with setInChanBal()
+	float panLeft;		// pan law gains for bal, so they are not worked out every cycle
+	float panRight;
+	uint32_t busses;		// bits corispond to enabled bus numbers 0-23, and mute groups (top 8 bits)
+	busSet routes;			// all the buses the input is on, set by render: the low 24 are also in busses
 	uint32_t feedBus;			// feed mix-minus bus number assignment + 1; zero for no feed bus
 	float feedVol;
 	unsigned int segNext;	// inNum+1; 0 for no next segue player
@@ -88,16 +175,78 @@ typedef struct{
 	float posSeg;
 	time_t fadeTime;
 	float fadePos;
+	/* NOTE: app threads setting segNext, posSeg, levelSeg, fadeTime, fadePos 
+	 * or nextAplEvent must pass the change to render with scheduleInChanEvents() */
 	
 	unsigned char managed;	// true only if this input is associated with a queue list item
-	uint32_t requested;	// change bits set by app threads, cleared by render
-	uint32_t changed;	// change bits set by Render, cleared app thread
+	uint32_t requested;	// pending change bits, render thread only: app threads use sendMixCommand()
+	uint32_t changed;	// change bits, render thread only: published on changeQueue each cycle
 	unsigned char posack;	// true when render should send a position ack control packet
+	jack_nframes_t posackOffset;	// render thread only: frame in the cycle the acked position was taken at
+	jack_nframes_t reqOffset;	// render thread only: frame in the cycle a requested play, stop or volume change lands on
 	
 	uint32_t status;	// status bits set or cleard by any thread
 	unsigned char mutesGroup;
 	uint32_t tmpFeedBus;	
-} inChannel;
+	
+	/* working values for the current cycle, render thread only */
+	uint32_t tmpStatus;
+	busSet tmpRoutes;	// the buses to mix into this cycle, after cue and talkback
+	float tmpLeftVol;
+	float tmpRightVol;
+	jack_nframes_t tmpSplit;	// frame in the cycle the gains above start at, 0 for the whole cycle
+	float tmpPreLeftVol;	// the last cycle's gains: used up to tmpSplit, or ramped from
+	float tmpPreRightVol;
+	unsigned char tmpSounding;	// not muted by play or render status, this cycle
+	unsigned char tmpRamp;		// sounding last cycle and this: gain changes ramp, to and from zero too
+	float tmpSegLevel;
+	unsigned char tmpMixMinus;	// true if the mm buffers hold this input's inverted samples
+	
+	/* mix-minus output connection state, set by jackChangeWatcher */
+	unsigned char mmConnected;
+	unsigned char mmRendered;	// true if render has written to the mm buffers since they were last cleared
+	
+	/* scheduled events, render thread only.  Frame numbers are play position 
+	 * frames, except evFadeTime, which is an engine frameClock frame: -1 for none */
+	int64_t evSegue;
+	int64_t evFade;
+	int64_t evFadeTime;
+	int64_t evApl;
+	unsigned int evSegNext;	// inNum+1
+	float evSegLevel;
+	unsigned char fading;	// true while fading out
+	jack_nframes_t fadeOffset;	// frame in the current cycle the fade starts at
+} __attribute__((aligned(mixbuffer_align))) inChannel;
+
+typedef struct{
+	uint32_t seq;		// sequence number, set by queueMixCommand()
+	uint32_t type;		// one of the cmd_ values
+	unsigned int target;	// input or output group number
+	uint32_t iVal;
+	float fVal;
+	int64_t frame;		// scheduled event frame, -1 to cancel the event
+	uint64_t when;		// frameClock frame to apply the command at, 0 for the next cycle
+	unsigned int word;	// cmd_inBusWord: the 32 bus word of the routing iVal holds
+	void *ptr;			// cmd_outDelay: the output group's new delay line
+} mixCommand;
+
+#define changeOutGroup	0x40000000	// mixChange target is an output group number
+#define changeEngine	0x80000000	// mixChange is for the engine: activeBus in bus
+
+typedef struct{
+	uint32_t target;	// input number, or output group number | changeOutGroup
+	uint32_t changed;	// change_ bits
+	/* snapshot of the values as of the change */
+	uint32_t status;
+	uint32_t bus;		// input busses, output group bus, or engine activeBus
+	busSet routes;		// input buses, all of them
+	uint32_t feedBus;
+	float vol;
+	float bal;
+	float feedVol;
+	float delay;
+	double pos;
+} mixChange;
 
 typedef struct {
 	uint32_t nameHash;
@@ -111,13 +260,21 @@ typedef struct {
 	float reqVol;
 	float reqDelay;
 	unsigned int reqBus;
+	mixbuffer_t *delayLine;		// render thread only: delay history, NULL when not delayed
+	mixbuffer_t *sentDelayLine;	// app threads, under outGrpLock: the line last sent to render
+	float sentDelay;		// app threads, under outGrpLock: the delay last sent to render
+	dspChain *dsp;			// render thread only: insert processing, NULL for none
+	char *dspSpec;			// app threads, under outGrpLock: the spec dsp was made from
 	
-	unsigned int requested;	// change bits set by app threads, cleared by render
-	unsigned int changed;	// change bits set by Render, cleared app thread
+	unsigned int requested;	// change bits set by render from queued commands, cleared by render
+	unsigned int changed;	// change bits, render thread only: published on changeQueue each cycle
 	unsigned int muteLevels; // Cue (LSB), MuteA, B, C (MSB) levels -> gain / 255
+	unsigned char isConnected;	// set by jackChangeWatcher
+	unsigned char rendered;	// true if render has written to the ports since they were last cleared
+	float tmpGain;	// render thread only: the gain the ports were last rendered at, to ramp from
 } outChannel;
 
-typedef struct{
+typedef struct mixEngineRec{
 	pthread_mutex_t jackMutex;
 	unsigned int chanCount;
 	unsigned int inCount;
@@ -125,8 +282,21 @@ typedef struct{
 	unsigned int busCount;
 	jack_nframes_t mixerSampleRate;
 	mixbuffer_t *mixbuses;
+	mixbuffer_t *busResize;	// atomic: longer bus buffers from the buffer size callback, for render to swap in
+	jack_nframes_t busFrames;	// app threads: the frames a cycle's bus buffers hold, as last sized
 	inChannel *ins;		// custom specific structure array
 	outChannel *outs;	// custom specific structure array
+	unsigned int *activeIns;	// inCount array: input numbers with audio to mix this cycle
+	unsigned int *feedIns;		// inCount array: input numbers with a mix-minus feed to render this cycle
+	busFeed busFeeds[mix_max_busFeeds];	// render thread only: submix bus feeds, in render order
+	unsigned int busFeedCount;
+	dspChain **busDsp;		// busCount array, render thread only: bus insert processing
+	char **busDspSpecs;		// busCount array, app threads, under outGrpLock: the specs busDsp was made from
+	struct mixWorkerPool *workers;	// NULL unless mixing is shared with worker threads
+	struct mixStats *stats;			// render stage timing and xrun log
+	cartPool *carts;		// RAM resident cart items
+	void (*mixInputProc)(struct mixEngineRec *, inChannel *, jack_nframes_t, 
+				jack_default_audio_sample_t *, size_t, busSet *);	// mixInput(), specialized for chanCount
 	jack_client_t *client;
 	const char *ourJackName;
 
@@ -134,22 +304,38 @@ typedef struct{
 	jack_port_t *ctlOutPort;	// control data from attached peers
 	jack_ringbuffer_t *ctlInQueue;
 	jack_ringbuffer_t *ctlOutQueue;
+	uint32_t ctlOutBytes;		// atomic: per cycle ctlOutQueue drain byte budget, zero for the default
+	uint32_t ctlOutEvents;		// atomic: per cycle ctlOutQueue drain packet budget, zero for the default
+	uint32_t ctlOutDropped;		// under ctlOutQueueMutex: packets refused for want of queue space
+	ctlQueueStats ctlOutStats;	// ctlOutQueue depth and high water, written by render
+	jack_ringbuffer_t *cmdQueue;	// mixCommand records for the render thread
+	mixCommand *cmdHeld;	// render thread only: commands timed for a later cycle
+	unsigned int heldCount;
+	uint32_t cmdSeq;	// last command sequence number issued, under cmdQueueMutex
+	uint32_t cmdAck;	// sequence number of the last command render has taken
 	callbackQueue cbQueue;
 	pthread_mutex_t cbQueueMutex;
 	pthread_cond_t cbQueueSemaphore;
 	pthread_mutex_t ctlOutQueueMutex;
-	pthread_mutex_t ctlInQueueMutex;
-	pthread_cond_t ctlInQueueSemaphore;
+	pthread_mutex_t cmdQueueMutex;
+	int ctlInQueueFD;	// eventfd, signaled by render when packets are queued
 	
 	pthread_rwlock_t outGrpLock;
-	pthread_mutex_t changedMutex;
-	pthread_cond_t changedSemaphore;
+	jack_ringbuffer_t *retiredLines;	// delay lines render is finished with, for app threads to free
+	jack_ringbuffer_t *retiredChains;	// dsp chains render is finished with, for app threads to free
+	jack_ringbuffer_t *retiredCtls;		// player control channels render is finished with, for app threads to free
+	pthread_mutex_t retiredCtlsMutex;	// makes the app thread freeing retiredCtls the only reader
+	jack_ringbuffer_t *changeQueue;	// mixChange records published by render
+	int changeFD;	// eventfd, signaled by render when changes are published
 	uint32_t activeBus;
-	unsigned char reqTalkBackBits;	// bits 2, 1, 0 enable Talkback to cue via corrisponding mute groups C, B, A.
+	uint32_t sentActiveBus;	// render thread only: activeBus as last published
+	uint64_t frameClock;	// frames rendered since start up, set by render
+	unsigned char reqTalkBackBits;	// bits 2, 1, 0 enable Talkback to cue via corrisponding mute groups C, B, A. Set by render.
 
 /* NOTE: outGrpLock is for read/write locking output group name, nameHash, 
- * and portList string values of the mix engine "outs" list. This is not 
- * used for locking any other vaues in these records. */
+ * portList and dspSpec string values of the mix engine "outs" list, and 
+ * the busDspSpecs strings. This is not used for locking any other vaues 
+ * in these records. */
 
 } mixEngineRec;
 
@@ -190,6 +376,43 @@ enum{
 	change_mutes		=(1L << 14)
 };
 
+enum{
+	/* input commands: target is the input number */
+	cmd_inVol			=1,		// fVal
+	cmd_inBal,					// fVal
+	cmd_inPos,					// fVal
+	cmd_inBus,					// iVal, low 24 bits: buses 0 to 23
+	cmd_inMutes,				// iVal, top 8 bits
+	cmd_inFeedBus,				// iVal
+	cmd_inFeedVol,				// fVal
+	cmd_inPlay,
+	cmd_inStop,
+	cmd_inSegue,				// frame, segNext in iVal, levelSeg in fVal
+	cmd_inFade,					// frame
+	cmd_inFadeTime,				// frame, of frameClock
+	cmd_inApl,					// frame
+	cmd_inBusWord,				// iVal: buses 32 * word to 32 * word + 31
+	cmd_inCart,					// cart item in ptr, NULL to unload: use setInChanCart()
+	cmd_inCtl,					// control channel in ptr, NULL for none: use setInChanCtl()
+	/* output group commands: target is the output group number */
+	cmd_outVol			=64,	// fVal
+	cmd_outBus,					// iVal
+	cmd_outDelay,				// fVal, delay line in ptr: use setOutputDelay()
+	cmd_outDsp,					// dsp chain in ptr: use setOutputDsp()
+	/* engine commands */
+	cmd_talkbackOn		=128,	// iVal: talkback bits to set
+	cmd_talkbackOff,			// iVal: talkback bits to clear
+	cmd_busFeed,				// target: bus fed from, iVal: bus fed to, fVal: gain, zero to remove
+	cmd_busDsp					// target: bus, dsp chain in ptr: use setBusDsp()
+};
+
+enum{
+	event_segue			=(1L << 0),	// segNext, posSeg and levelSeg
+	event_fade			=(1L << 1),	// fadePos
+	event_fadeTime		=(1L << 2),	// fadeTime
+	event_apl			=(1L << 3)	// nextAplEvent
+};
+
 #define status_render (status_cueing | status_playing | status_talkback)
 
 extern float def_vol;				// default scalar gain
@@ -197,6 +420,7 @@ extern unsigned int def_busses;	// default bus settings
 extern float def_bal;				// default balance
 
 void setInChanToDefault(inChannel *chrec);
+void setInChanBal(inChannel *chrec, float bal);
 void setAllUnloadedToDefault(mixEngineRecPtr mixRef);
 unsigned char checkPnumber(int pNum);
 char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width, 
@@ -205,10 +429,27 @@ char *initMixer(mixEngineRecPtr *mixEngineRef, unsigned int width,
 						const char* reqName, jack_options_t options);
 						
 void shutdownMixer(mixEngineRecPtr mixEngineRef);
+void scheduleInChanEvents(mixEngineRecPtr mixEngineRef, inChannel *chrec, uint32_t events);
+uint32_t queueMixCommand(mixEngineRecPtr mixEngineRef, mixCommand *cmd);
+uint32_t sendMixCommand(mixEngineRecPtr mixEngineRef, uint32_t type, unsigned int target, uint32_t iVal, float fVal);
+unsigned char mixCommandDone(mixEngineRecPtr mixEngineRef, uint32_t seq);
+void setOutputDelay(mixEngineRecPtr mixEngineRef, unsigned int out, float delay);
+void setInChanRoutes(mixEngineRecPtr mixEngineRef, unsigned int in, const busSet *routes);
+void setInChanCart(mixEngineRecPtr mixEngineRef, unsigned int in, cartItem *item);
+void unloadInChan(mixEngineRecPtr mixEngineRef, unsigned int in);
+unsigned char setInChanCtl(mixEngineRecPtr mixEngineRef, unsigned int in, ctlShm *shm);
+void setCtlOutBudget(mixEngineRecPtr mixEngineRef, int bytes, int events);
+void freeRetiredDelayLines(mixEngineRecPtr mixEngineRef);
+const char *setOutputDsp(mixEngineRecPtr mixEngineRef, unsigned int out, const char *spec);
+const char *setBusDsp(mixEngineRecPtr mixEngineRef, unsigned int bus, const char *spec);
+void mixInput(mixEngineRecPtr mixEngineRef, inChannel *inchrec, jack_nframes_t nframes, 
+				jack_default_audio_sample_t *partial, size_t stride, busSet *written);
 void updateOutputConnections(mixEngineRecPtr mixEngineRef, outChannel *rec, 
 							unsigned char updatePorts, const char *portList, const char *matchOnly);
 							
 jack_port_id_t *getCBQitem(callbackQueue *Q);
+void signalEventFD(int fd);
+unsigned char waitEventFD(int fd, int timeout);
 
 #ifdef __cplusplus
 }
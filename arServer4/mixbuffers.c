@@ -18,11 +18,51 @@
 
 #include "mixbuffers.h"
 
+#define hugePageSize	(2 * 1024 * 1024)
+
+unsigned char mixbuffer_hugePages = 0;
+
+void *mixbuffer_alloc(size_t size){
+	void *ptr;
+	
+	if(mixbuffer_hugePages && (size >= hugePageSize)){
+		/* whole huge pages: explicit ones if the system has any reserved, 
+		 * otherwise ask for transparent huge pages */
+		size = (size + hugePageSize - 1) & ~((size_t)hugePageSize - 1);
+		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, 
+							MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if(ptr == MAP_FAILED){
+			ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, 
+							MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(ptr == MAP_FAILED)
+				return NULL;
+			madvise(ptr, size, MADV_HUGEPAGE);
+		}
+		return ptr;	// anonymous maps are zero filled
+	}
+	if(posix_memalign(&ptr, mixbuffer_align, size))
+		return NULL;
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+void mixbuffer_release(void *ptr, size_t size){
+	if(ptr == NULL)
+		return;
+	if(mixbuffer_hugePages && (size >= hugePageSize)){
+		size = (size + hugePageSize - 1) & ~((size_t)hugePageSize - 1);
+		munmap(ptr, size);
+	}else
+		free(ptr);
+}
+
 void mixbuffer_free(mixbuffer_t *mb_rec){
 	size_t i;
 	jack_port_t **port;
 	
 	if(mb_rec){
+		if(mb_rec->mlocked_flags & 0x10)
+			munlock(mb_rec->silentMap, sizeof(uint64_t) * mb_rec->mapWords * mb_rec->busses);
 		if(mb_rec->mlocked_flags & 0x8)
 			munlock(mb_rec->VUmeters, sizeof(vuData) * mb_rec->arrayCount);	
 		if(mb_rec->mlocked_flags & 0x4)
@@ -42,18 +82,46 @@ void mixbuffer_free(mixbuffer_t *mb_rec){
 		free(mb_rec->busout_jPorts);	
 			
 		/* free VU meters array */		
-		if(mb_rec->VUmeters)
-			free(mb_rec->VUmeters);
+		mixbuffer_release(mb_rec->VUmeters, sizeof(vuData) * mb_rec->arrayCount);
+
+		/* free silent block map */		
+		mixbuffer_release(mb_rec->silentMap, sizeof(uint64_t) * mb_rec->mapWords * mb_rec->busses);
 			
 		/* free buffer */		
-		if(mb_rec->buf)
-			free(mb_rec->buf);
+		mixbuffer_release(mb_rec->buf, mb_rec->totalSizeBytes);
 			
 		/* free record */
 		free(mb_rec);	
 	}
 }
 
+void mixbuffer_swapSamples(mixbuffer_t *mb, mixbuffer_t *other){
+	mixbuffer_t tmp;
+	unsigned char flags;
+	
+	tmp = *mb;
+	mb->buf = other->buf;
+	mb->silentMap = other->silentMap;
+	mb->mapWords = other->mapWords;
+	mb->index = other->index;
+	mb->bufSizeSamples = other->bufSizeSamples;
+	mb->chanStride = other->chanStride;
+	mb->totalSizeBytes = other->totalSizeBytes;
+	mb->bufIndexMask = other->bufIndexMask;
+	other->buf = tmp.buf;
+	other->silentMap = tmp.silentMap;
+	other->mapWords = tmp.mapWords;
+	other->index = tmp.index;
+	other->bufSizeSamples = tmp.bufSizeSamples;
+	other->chanStride = tmp.chanStride;
+	other->totalSizeBytes = tmp.totalSizeBytes;
+	other->bufIndexMask = tmp.bufIndexMask;
+	/* the buf (0x2) and silentMap (0x10) mlock flags go with them */
+	flags = mb->mlocked_flags;
+	mb->mlocked_flags = (flags & ~0x12) | (other->mlocked_flags & 0x12);
+	other->mlocked_flags = (other->mlocked_flags & ~0x12) | (flags & 0x12);
+}
+
 mixbuffer_t *mixbuffer_create(size_t sizeSamples, unsigned int chanCount, 
 						unsigned int busCount , jack_client_t *client){
     unsigned int i, c;
@@ -73,69 +141,127 @@ mixbuffer_t *mixbuffer_create(size_t sizeSamples, unsigned int chanCount,
 	mb_rec->arrayCount = busCount * chanCount;
 	mb_rec->index = 0;
 	mb_rec->client = client;
+	mb_rec->buf = NULL;
+	mb_rec->busout_jPorts = NULL;
+	mb_rec->VUmeters = NULL;
+	mb_rec->silentMap = NULL;
 
-	for(bitDepth = 1; (1 << bitDepth) < sizeSamples; bitDepth++);
+	for(bitDepth = mixbuffer_blockBits; (1 << bitDepth) < sizeSamples; bitDepth++);
 
 	mb_rec->bufSizeSamples = 1 << bitDepth;
 	mb_rec->bufIndexMask = mb_rec->bufSizeSamples;
 	mb_rec->bufIndexMask -= 1;
-	mb_rec->totalSizeBytes = mb_rec->arrayCount * mb_rec->bufSizeSamples 
+	/* channel rings are a cache line longer than their power of two size, 
+	 * so the same index in different channels doesn't alias in the cache */
+	mb_rec->chanStride = mb_rec->bufSizeSamples + (mixbuffer_align / sizeof(jack_default_audio_sample_t));
+	mb_rec->totalSizeBytes = mb_rec->arrayCount * mb_rec->chanStride 
 							* sizeof(jack_default_audio_sample_t);
 
-	if((mb_rec->buf = (jack_default_audio_sample_t*)malloc(mb_rec->totalSizeBytes)) == NULL) {
+	if((mb_rec->buf = (jack_default_audio_sample_t*)mixbuffer_alloc(mb_rec->totalSizeBytes)) == NULL) {
 		mixbuffer_free(mb_rec);
 		return NULL;
 	}
 	
-	/* Create Jack ports for output groups */
-	if(mb_rec->busout_jPorts = (jack_port_t**)calloc(mb_rec->arrayCount, 
-											sizeof(jack_port_t *))){
-		port = mb_rec->busout_jPorts;
-		for(i=0; i<busCount; i++){
-			for(c=0; c<chanCount; c++){
-				snprintf(pname, sizeof pname, "mixBus%dch%d", i, c);
-				*port = jack_port_register(mb_rec->client, pname,
-					JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-				if(*port == NULL){
-					mixbuffer_free(mb_rec);
-					return NULL;
+	if(client){
+		/* Create Jack ports for the bus outputs */
+		if(mb_rec->busout_jPorts = (jack_port_t**)calloc(mb_rec->arrayCount, 
+												sizeof(jack_port_t *))){
+			port = mb_rec->busout_jPorts;
+			for(i=0; i<busCount; i++){
+				for(c=0; c<chanCount; c++){
+					snprintf(pname, sizeof pname, "mixBus%dch%d", i, c);
+					*port = jack_port_register(mb_rec->client, pname,
+						JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+					if(*port == NULL){
+						mixbuffer_free(mb_rec);
+						return NULL;
+					}
+					port++;
 				}
-				port++;
 			}
+		}else{
+			mixbuffer_free(mb_rec);
+			return NULL;
+		}
+		
+		mb_rec->VUmeters = (vuData*)mixbuffer_alloc(mb_rec->arrayCount * sizeof(vuData));
+		if(mb_rec->VUmeters == NULL){
+			mixbuffer_free(mb_rec);
+			return NULL;
 		}
-	}else{
-		mixbuffer_free(mb_rec);
-		return NULL;
 	}
 	
-	mb_rec->VUmeters = (vuData*)calloc(mb_rec->arrayCount, sizeof(vuData));
-	if(mb_rec->VUmeters == NULL){
+	/* silent block map: one bit per block, per bus. Everything starts out 
+	 * silent, so delayed reads of the never written ring return zeros */
+	mb_rec->mapWords = ((mb_rec->bufSizeSamples >> mixbuffer_blockBits) + 63) / 64;
+	size = sizeof(uint64_t) * mb_rec->mapWords * busCount;
+	if((mb_rec->silentMap = (uint64_t *)mixbuffer_alloc(size)) == NULL){
 		mixbuffer_free(mb_rec);
 		return NULL;
 	}
+	memset(mb_rec->silentMap, 0xff, size);
 
 	if(mlock(mb_rec, sizeof(mixbuffer_t)) == 0)
 		mb_rec->mlocked_flags = 1;
 	if(mlock(mb_rec->buf, mb_rec->totalSizeBytes) == 0)
 		mb_rec->mlocked_flags += 2;
-	if(mlock(mb_rec->busout_jPorts, sizeof(jack_port_t*) * mb_rec->arrayCount))
-		mb_rec->mlocked_flags += 4;
-	if(mlock(mb_rec->VUmeters, sizeof(vuData) * mb_rec->arrayCount))
-		mb_rec->mlocked_flags += 8;	
+	if(client){
+		if(mlock(mb_rec->busout_jPorts, sizeof(jack_port_t*) * mb_rec->arrayCount))
+			mb_rec->mlocked_flags += 4;
+		if(mlock(mb_rec->VUmeters, sizeof(vuData) * mb_rec->arrayCount))
+			mb_rec->mlocked_flags += 8;	
+	}
+	if(mlock(mb_rec->silentMap, size) == 0)
+		mb_rec->mlocked_flags += 0x10;	
 
 	return mb_rec;
 }
 
+static inline unsigned char blockIsSilent(uint64_t *map, size_t block){
+	return (map[block >> 6] >> (block & 63)) & 1;
+}
+
+static void readSegment(jack_default_audio_sample_t *ring, uint64_t *map, 
+					size_t idx, jack_default_audio_sample_t *dest, 
+					size_t sampCnt, unsigned char suminto){
+	/* idx through idx + sampCnt must not wrap around the end of the ring */
+	size_t end, next, run;
+	unsigned char silent;
+	
+	end = idx + sampCnt;
+	while(idx < end){
+		/* find the run of blocks with the same silent state */
+		silent = blockIsSilent(map, idx >> mixbuffer_blockBits);
+		next = ((idx >> mixbuffer_blockBits) + 1) << mixbuffer_blockBits;
+		while((next < end) && (blockIsSilent(map, next >> mixbuffer_blockBits) == silent))
+			next += mixbuffer_blockSize;
+		if(next > end)
+			next = end;
+		run = next - idx;
+		if(silent){
+			if(!suminto)
+				memset(dest, 0, run * sizeof(jack_default_audio_sample_t));
+		}else if(suminto)
+			mixKernels.sum(dest, ring + idx, run);
+		else
+			mixKernels.copy(dest, ring + idx, run);
+		dest += run;
+		idx = next;
+	}
+}
+
 void mixbuffer_read(mixbuffer_t *mb, size_t sampCnt, 
 					unsigned int offset, jack_default_audio_sample_t *dest, 
 					unsigned int chan, unsigned int bus, unsigned char suminto){
 	
 	size_t i, i_end, i_start, head, tail;
 	unsigned int b;
-	jack_default_audio_sample_t *ptrA, *ptrB;
+	jack_default_audio_sample_t *ptrA;
+	uint64_t *map;
 	
 	b = (mb->channelsPerBus * bus) + chan;
-	ptrA = mb->buf + (mb->bufSizeSamples * b);
+	ptrA = mb->buf + (mb->chanStride * b);
+	map = mb->silentMap + (mb->mapWords * bus);
 	
 	i = mb->index - offset;
 	i_start = i & mb->bufIndexMask;
@@ -143,40 +269,15 @@ void mixbuffer_read(mixbuffer_t *mb, size_t sampCnt,
 	i_end = i & mb->bufIndexMask;
 	if(i == i_end){
 		/* single segment: i_start to i_end */
-		ptrA += i_start;
-		if(suminto){
-			for(i=0; i<sampCnt; i++){
-				*dest += *ptrA;
-				ptrA++;
-				dest++;
-			}
-		}else
-			memcpy(dest, ptrA, sampCnt * sizeof(jack_default_audio_sample_t));
+		readSegment(ptrA, map, i_start, dest, sampCnt, suminto);
 	}else{
 		/* wrap around: two part copy */
 		/* i_start through mb_rec->bufIndexMask */
-		head = mb->bufIndexMask - i_start;
-		ptrB = ptrA + i_start;
-		if(suminto){
-			for(i=0; i<head; i++){
-				*dest += *ptrB;
-				ptrB++;
-				dest++;
-			}
-			/* 0 to i_end */
-			tail = sampCnt - head;
-			for(i=0; i<tail; i++){
-				*dest += *ptrA;
-				ptrA++;
-				dest++;
-			}
-		}else{
-			memcpy(dest, ptrB, head * sizeof(jack_default_audio_sample_t));
-			/* 0 to i_end */
-			dest = dest + head;
-			tail = sampCnt - head;
-			memcpy(dest, ptrA, tail * sizeof(jack_default_audio_sample_t));
-		}
+		head = mb->bufSizeSamples - i_start;
+		readSegment(ptrA, map, i_start, dest, head, suminto);
+		/* 0 to i_end */
+		tail = sampCnt - head;
+		readSegment(ptrA, map, 0, dest + head, tail, suminto);
 	}
 }
 
@@ -190,7 +291,7 @@ void mixbuffer_sum(mixbuffer_t *mb, size_t sampCnt,
 	jack_default_audio_sample_t *ptrA, *ptrB;
 	
 	b = (mb->channelsPerBus * bus) + chan;
-	ptrA = mb->buf + (mb->bufSizeSamples * b);
+	ptrA = mb->buf + (mb->chanStride * b);
 	
 	i_start = mb->index;
 	i = i_start + sampCnt;
@@ -200,39 +301,155 @@ void mixbuffer_sum(mixbuffer_t *mb, size_t sampCnt,
 		ptrA += i_start;
 		if(zero)
 			memset(ptrA, 0, sampCnt * sizeof(jack_default_audio_sample_t));
-		else{
-			for(i=0; i<sampCnt; i++){
-				*ptrA += *source;
-				ptrA++;
-				source++;
-			}
-		}
+		else
+			mixKernels.sum(ptrA, source, sampCnt);
 		
 	}else{
 		/* wrap around: two part copy */
 		/* i_start through mb_rec->bufIndexMask */
-		head = mb->bufIndexMask - i_start;
+		head = mb->bufSizeSamples - i_start;
 		tail = sampCnt - head;
 		ptrB = ptrA + i_start;
 		if(zero){
 			memset(ptrB, 0, head * sizeof(jack_default_audio_sample_t));
 			memset(ptrA, 0, tail * sizeof(jack_default_audio_sample_t));
 		}else{
-			for(i=0; i<head; i++){
-				*ptrB += *source;
-				ptrB++;
-				source++;
-			}
+			mixKernels.sum(ptrB, source, head);
 			/* 0 to i_end */
-			for(i=0; i<tail; i++){
-				*ptrA += *source;
-				ptrA++;
-				source++;
-			}
+			mixKernels.sum(ptrA, source + head, tail);
 		}
 	}					
 }
 					
+void mixbuffer_write(mixbuffer_t *mb, size_t sampCnt, 
+					jack_default_audio_sample_t *source, float gain, 
+					unsigned int chan, unsigned int bus){
+	/* for the first source mixed into a bus each cycle: the ring samples
+	 * are replaced by the scaled source samples, rather than zeroed and 
+	 * summed into */
+	size_t i, i_end, i_start, head, tail;
+	unsigned int b;
+	jack_default_audio_sample_t *ptrA, *ptrB;
+	
+	b = (mb->channelsPerBus * bus) + chan;
+	ptrA = mb->buf + (mb->chanStride * b);
+	
+	i_start = mb->index;
+	i = i_start + sampCnt;
+	i_end = i & mb->bufIndexMask;
+	if(i == i_end){
+		/* single segment: i_start to i_end */
+		ptrA += i_start;
+		if(gain == 1.0)
+			mixKernels.copy(ptrA, source, sampCnt);
+		else
+			mixKernels.scale(ptrA, source, gain, sampCnt);
+	}else{
+		/* wrap around: two part copy */
+		head = mb->bufSizeSamples - i_start;
+		tail = sampCnt - head;
+		ptrB = ptrA + i_start;
+		if(gain == 1.0){
+			mixKernels.copy(ptrB, source, head);
+			mixKernels.copy(ptrA, source + head, tail);
+		}else{
+			mixKernels.scale(ptrB, source, gain, head);
+			mixKernels.scale(ptrA, source + head, gain, tail);
+		}
+	}
+}
+
+jack_default_audio_sample_t *mixbuffer_span(mixbuffer_t *mb, 
+					unsigned int chan, unsigned int bus){
+	return mb->buf + (mb->chanStride * ((mb->channelsPerBus * bus) + chan)) + mb->index;
+}
+
+void mixbuffer_copy(mixbuffer_t *mb, size_t sampCnt, mixbuffer_t *src, 
+					unsigned int chan, unsigned int bus, unsigned int srcBus){
+	/* copies sampCnt samples of channel chan of srcBus at the write point 
+	 * of src to the same channel of bus at the write point of mb.  Silent 
+	 * blocks in src are written as zeros. */
+	size_t done, si, di, run;
+	jack_default_audio_sample_t *srcRing, *ring;
+	uint64_t *map;
+	
+	srcRing = src->buf + (src->chanStride * ((src->channelsPerBus * srcBus) + chan));
+	map = src->silentMap + (src->mapWords * srcBus);
+	ring = mb->buf + (mb->chanStride * ((mb->channelsPerBus * bus) + chan));
+	for(done = 0; done < sampCnt; done += run){
+		/* largest run that wraps around neither ring */
+		si = (src->index + done) & src->bufIndexMask;
+		di = (mb->index + done) & mb->bufIndexMask;
+		run = sampCnt - done;
+		if(run > (src->bufSizeSamples - si))
+			run = src->bufSizeSamples - si;
+		if(run > (mb->bufSizeSamples - di))
+			run = mb->bufSizeSamples - di;
+		readSegment(srcRing, map, si, ring + di, run, 0);
+	}
+}
+
+static void markSegment(mixbuffer_t *mb, unsigned int bus, 
+					size_t start, size_t sampCnt, unsigned char silent){
+	/* start through start + sampCnt must not wrap around the end of the ring */
+	size_t bs, be, end, lo, hi, k;
+	unsigned int c;
+	uint64_t *word, bit;
+	jack_default_audio_sample_t *ring;
+	
+	ring = mb->buf + (mb->chanStride * mb->channelsPerBus * bus);
+	end = start + sampCnt;
+	for(bs = start & ~((size_t)mixbuffer_blockSize - 1); bs < end; bs = be){
+		be = bs + mixbuffer_blockSize;
+		k = bs >> mixbuffer_blockBits;
+		word = mb->silentMap + (mb->mapWords * bus) + (k >> 6);
+		bit = (uint64_t)1 << (k & 63);
+		if((bs >= start) && (be <= end)){
+			/* whole block is in the span: just flag it */
+			if(silent)
+				*word = *word | bit;
+			else
+				*word = *word & ~bit;
+		}else if(silent){
+			/* partial block at a span end: if the block holds samples, 
+			 * zero the part that is in the span */
+			if((*word & bit) == 0){
+				lo = (bs > start) ? bs : start;
+				hi = (be < end) ? be : end;
+				for(c=0; c<mb->channelsPerBus; c++)
+					memset(ring + (mb->chanStride * c) + lo, 0, 
+							(hi - lo) * sizeof(jack_default_audio_sample_t));
+			}
+		}else if(*word & bit){
+			/* partial block about to be written to was silent: zero the 
+			 * whole block so the rest of it stays silent without the flag */
+			for(c=0; c<mb->channelsPerBus; c++)
+				memset(ring + (mb->chanStride * c) + bs, 0, 
+						mixbuffer_blockSize * sizeof(jack_default_audio_sample_t));
+			*word = *word & ~bit;
+		}
+	}
+}
+
+void mixbuffer_mark(mixbuffer_t *mb, size_t sampCnt, 
+					unsigned int bus, unsigned char silent){
+	/* Flags sampCnt samples at the current write point of all channels of 
+	 * the bus as silent, or as about to be written with mixbuffer_write.
+	 * Must be called once per bus each cycle, before any samples are 
+	 * written to the bus. */
+	size_t i_start, head;
+	
+	i_start = mb->index;
+	if((i_start + sampCnt) <= mb->bufSizeSamples)
+		markSegment(mb, bus, i_start, sampCnt, silent);
+	else{
+		/* wrap around: two part mark */
+		head = mb->bufSizeSamples - i_start;
+		markSegment(mb, bus, i_start, head, silent);
+		markSegment(mb, bus, 0, sampCnt - head, silent);
+	}
+}
+					
 void mixbuffer_advance(mixbuffer_t *mb, size_t sampCnt){
 	size_t newIndex;
 	
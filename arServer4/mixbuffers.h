@@ -28,22 +28,36 @@ extern "C"
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/types.h>
+#include <stdint.h>
 
 #include <jack/jack.h>
 
+#include "mixkernels.h"
+
 typedef struct{
 	// values are scalar magnitude
 	float	peak;		
 	float	avr;
 } vuData;
 
+/* Ring buffer spans with no audio are marked silent in a per-bus bitmap, 
+ * one bit per block of samples, rather than being zeroed */
+#define mixbuffer_blockBits	6	// 64 sample blocks
+#define mixbuffer_blockSize	(1 << mixbuffer_blockBits)
+
+/* alignment of render data: a cache line, and a whole AVX-512 vector */
+#define mixbuffer_align	64
+
 typedef struct {
 	jack_default_audio_sample_t	*buf; // bufSizeSamples of audio sample data 
 	jack_port_t **busout_jPorts;	// points to arrayCount array of bus output port pointers
 	vuData *VUmeters;				// points to arrayCount array of vuData    
+	uint64_t *silentMap;			// busses * mapWords array of silent block bits, set bit = all zeros
+	size_t mapWords;
 	size_t arrayCount;
 	size_t index;
 	size_t bufSizeSamples;
+	size_t chanStride;				// samples from the start of one channel ring to the next
 	size_t totalSizeBytes;
 	size_t bufIndexMask;
 	unsigned int busses;
@@ -52,8 +66,24 @@ typedef struct {
 	jack_client_t *client;
 } mixbuffer_t;
 
+/* Set to back large render allocations with huge pages: before initMixer() */
+extern unsigned char mixbuffer_hugePages;
+
+/* Zeroed, mixbuffer_align aligned memory for render data.  Allocations of 
+ * a huge page or more are mapped in huge pages if mixbuffer_hugePages is 
+ * set.  Free with mixbuffer_release(), giving the same size. */
+void *mixbuffer_alloc(size_t size);
+
+void mixbuffer_release(void *ptr, size_t size);
+
 void mixbuffer_free(mixbuffer_t *mb_rec);
 
+/* Exchange the sample rings and silent maps of two buffers with the same 
+ * bus and channel counts, leaving ports and meters where they are.  Render 
+ * thread: used to swap in buffers sized for a longer JACK period. */
+void mixbuffer_swapSamples(mixbuffer_t *mb, mixbuffer_t *other);
+
+/* with a NULL client, no bus output ports or meters are created */
 mixbuffer_t *mixbuffer_create(size_t sizeSamples, 
 					unsigned int chanCount, unsigned int busCount, jack_client_t *client);
 
@@ -65,6 +95,22 @@ void mixbuffer_sum(mixbuffer_t *mb, size_t sampCnt,
 					jack_default_audio_sample_t *source, 
 					unsigned int chan, unsigned int bus, unsigned char zero);
 					
+void mixbuffer_write(mixbuffer_t *mb, size_t sampCnt, 
+					jack_default_audio_sample_t *source, float gain, 
+					unsigned int chan, unsigned int bus);
+
+/* pointer to the samples of chan of bus at the write point, for direct 
+ * access.  The caller must not run past the end of the ring: a buffer that 
+ * is never advanced has bufSizeSamples contiguous samples from here. */
+jack_default_audio_sample_t *mixbuffer_span(mixbuffer_t *mb, 
+					unsigned int chan, unsigned int bus);
+
+void mixbuffer_copy(mixbuffer_t *mb, size_t sampCnt, mixbuffer_t *src, 
+					unsigned int chan, unsigned int bus, unsigned int srcBus);
+
+void mixbuffer_mark(mixbuffer_t *mb, size_t sampCnt, 
+					unsigned int bus, unsigned char silent);
+					
 void mixbuffer_advance(mixbuffer_t *mb, size_t sampCnt);
 
 #ifdef __cplusplus
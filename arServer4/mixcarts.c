@@ -0,0 +1,200 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "mixcarts.h"
+
+cartPool *mixcarts_init(unsigned int chanCount, jack_nframes_t pad){
+	cartPool *pool;
+	
+	if((pool = (cartPool *)calloc(1, sizeof(cartPool))) == NULL)
+		return NULL;
+	if((pool->retired = jack_ringbuffer_create(mixcart_retired * sizeof(cartItem *))) == NULL){
+		free(pool);
+		return NULL;
+	}
+	mlock(pool->retired, mixcart_retired * sizeof(cartItem *));
+	pthread_mutex_init(&pool->lock, NULL);
+	pool->chanCount = chanCount;
+	pool->pad = pad;
+	pool->limit = mixcart_pool_limit;
+	return pool;
+}
+
+static void freeItem(cartItem *item){
+	munlock(item, item->size);
+	free(item->url);
+	free(item);
+}
+
+/* free unused items, oldest first, until the pool is within its limit.  
+ * NOTE: with the pool locked */
+static void trimPool(cartPool *pool){
+	cartItem **prev, **oldest, *item;
+	
+	while(pool->size > pool->limit){
+		oldest = NULL;
+		prev = &pool->items;
+		while(item = *prev){
+			if(!item->refs)
+				oldest = prev;
+			prev = &item->next;
+		}
+		if(!oldest)
+			return;
+		item = *oldest;
+		*oldest = item->next;
+		pool->size = pool->size - item->size;
+		freeItem(item);
+	}
+}
+
+void mixcarts_free(cartPool *pool){
+	cartItem *item;
+	
+	if(pool){
+		while(item = pool->items){
+			pool->items = item->next;
+			freeItem(item);
+		}
+		munlock(pool->retired, mixcart_retired * sizeof(cartItem *));
+		jack_ringbuffer_free(pool->retired);
+		pthread_mutex_destroy(&pool->lock);
+		free(pool);
+	}
+}
+
+void mixcarts_setLimit(cartPool *pool, size_t limit){
+	pthread_mutex_lock(&pool->lock);
+	pool->limit = limit;
+	trimPool(pool);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void mixcarts_setPad(cartPool *pool, jack_nframes_t pad){
+	/* read unlocked by mixcarts_add: items already made keep their padding */
+	if(pad > pool->pad)
+		__atomic_store_n(&pool->pad, pad, __ATOMIC_RELAXED);
+}
+
+/* NOTE: with the pool locked.  Holds the item, and moves it to the front */
+static cartItem *findItem(cartPool *pool, const char *url){
+	cartItem **prev, *item;
+	
+	prev = &pool->items;
+	while(item = *prev){
+		if(!strcmp(item->url, url)){
+			*prev = item->next;
+			item->next = pool->items;
+			pool->items = item;
+			item->refs++;
+			return item;
+		}
+		prev = &item->next;
+	}
+	return NULL;
+}
+
+cartItem *mixcarts_find(cartPool *pool, const char *url){
+	cartItem *item;
+	
+	pthread_mutex_lock(&pool->lock);
+	item = findItem(pool, url);
+	pthread_mutex_unlock(&pool->lock);
+	return item;
+}
+
+cartItem *mixcarts_add(cartPool *pool, const char *url, 
+				const jack_default_audio_sample_t *samples, jack_nframes_t frames){
+	cartItem *item, *found;
+	jack_default_audio_sample_t *dst;
+	unsigned int c, ccount;
+	size_t size, span;
+	jack_nframes_t s;
+	
+	/* one block for the record and every channel, silent padding included */
+	ccount = pool->chanCount;
+	span = (size_t)pool->pad * 2 + frames;
+	size = sizeof(cartItem) + (sizeof(jack_default_audio_sample_t *) * ccount) 
+						+ (sizeof(jack_default_audio_sample_t) * span * ccount);
+	if((item = (cartItem *)calloc(1, size)) == NULL)
+		return NULL;
+	if((item->url = strdup(url)) == NULL){
+		free(item);
+		return NULL;
+	}
+	item->size = size;
+	item->chanCount = ccount;
+	item->frames = frames;
+	item->pad = pool->pad;
+	item->refs = 1;
+	item->pcm = (jack_default_audio_sample_t **)(item + 1);
+	dst = (jack_default_audio_sample_t *)(item->pcm + ccount);
+	for(c=0; c<ccount; c++){
+		item->pcm[c] = dst;
+		dst = dst + item->pad;
+		for(s=0; s<frames; s++)
+			dst[s] = samples[(s * ccount) + c];
+		dst = dst + frames + item->pad;
+	}
+	mlock(item, size);
+	
+	pthread_mutex_lock(&pool->lock);
+	if(found = findItem(pool, url)){
+		pthread_mutex_unlock(&pool->lock);
+		freeItem(item);
+		return found;
+	}
+	item->next = pool->items;
+	pool->items = item;
+	pool->size = pool->size + size;
+	trimPool(pool);
+	pthread_mutex_unlock(&pool->lock);
+	return item;
+}
+
+void mixcarts_release(cartPool *pool, cartItem *item){
+	if(item){
+		pthread_mutex_lock(&pool->lock);
+		if(item->refs)
+			item->refs--;
+		trimPool(pool);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+void mixcarts_retire(cartPool *pool, cartItem *item){
+	if(item && (jack_ringbuffer_write_space(pool->retired) >= sizeof(cartItem *)))
+		jack_ringbuffer_write(pool->retired, (char *)&item, sizeof(cartItem *));
+}
+
+void mixcarts_collect(cartPool *pool){
+	cartItem *item;
+	
+	/* the pool lock also makes this the only reader of the queue */
+	pthread_mutex_lock(&pool->lock);
+	while(jack_ringbuffer_read(pool->retired, (char *)&item, sizeof(item)) == sizeof(item)){
+		if(item->refs)
+			item->refs--;
+	}
+	trimPool(pool);
+	pthread_mutex_unlock(&pool->lock);
+}
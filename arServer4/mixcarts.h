@@ -0,0 +1,108 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _MIXCARTS_H
+#define _MIXCARTS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <jack/jack.h>
+#include <jack/ringbuffer.h>
+
+/* RAM resident carts: short items decoded once into locked memory, and 
+ * played by the render thread straight from there, with no player process 
+ * and no JACK ports.  Items are shared by url: firing the same jingle again 
+ * finds it in the pool.  Items no input is using stay in the pool, most 
+ * recently used first, until the pool is over its size limit. */
+
+#define mixcart_pool_limit	(256 << 20)	// default pool size limit, bytes
+#define mixcart_max_seconds	600		// longest item that will be decoded
+#define mixcart_retired		256		// items render can hand back per collect
+
+typedef struct cartItem{
+	struct cartItem *next;
+	char *url;
+	unsigned int refs;		// inputs holding the item, under the pool lock
+	unsigned int chanCount;
+	jack_nframes_t frames;	// length of the item
+	jack_nframes_t pad;		// silent frames before and after the item
+	size_t size;
+	jack_default_audio_sample_t **pcm;	// chanCount array of pad + frames + pad samples
+} cartItem;
+
+typedef struct cartPool{
+	pthread_mutex_t lock;
+	cartItem *items;		// most recently used first
+	size_t size;			// bytes held by items
+	size_t limit;			// unused items are freed, oldest first, past this
+	unsigned int chanCount;
+	jack_nframes_t pad;
+	jack_ringbuffer_t *retired;	// items render is finished with, for app threads to release
+} cartPool;
+
+/* Make an empty pool for chanCount channel items, to be read by cycles of 
+ * up to pad frames.  App threads only. */
+cartPool *mixcarts_init(unsigned int chanCount, jack_nframes_t pad);
+void mixcarts_free(cartPool *pool);
+void mixcarts_setLimit(cartPool *pool, size_t limit);
+
+/* Pad items added from now on for cycles of up to pad frames, if more than 
+ * before.  Render skips items with less padding than a cycle. */
+void mixcarts_setPad(cartPool *pool, jack_nframes_t pad);
+
+/* Find the item for url in the pool, holding it for the caller, or NULL. */
+cartItem *mixcarts_find(cartPool *pool, const char *url);
+
+/* Add an item for url to the pool from frames of interleaved samples, 
+ * holding it for the caller.  If url was added meanwhile by another 
+ * thread, that item is held and returned instead.  NULL on failure. */
+cartItem *mixcarts_add(cartPool *pool, const char *url, 
+				const jack_default_audio_sample_t *samples, jack_nframes_t frames);
+
+/* Let go of an item held by find or add.  App threads only. */
+void mixcarts_release(cartPool *pool, cartItem *item);
+
+/* Render thread: hand an item back, to be released by the next collect. 
+ * If the retired queue is full, the item stays held rather than being 
+ * freed while in use. */
+void mixcarts_retire(cartPool *pool, cartItem *item);
+
+/* Release the items render has handed back.  App threads only. */
+void mixcarts_collect(cartPool *pool);
+
+/* Render thread: the samples of channel c from frame on.  Up to pad frames 
+ * before the start and after the end of the item read as silence. */
+static inline jack_default_audio_sample_t *mixcarts_span(cartItem *item, unsigned int c, int64_t frame){
+	if(frame < -(int64_t)item->pad)
+		frame = -(int64_t)item->pad;
+	if(frame > item->frames)
+		frame = item->frames;
+	return item->pcm[c] + item->pad + frame;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
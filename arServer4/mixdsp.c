@@ -0,0 +1,405 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+
+#include "mixdsp.h"
+#include "mixkernels.h"
+
+static float dbToGain(float db){
+	return powf(10.0, db / 20.0);
+}
+
+/* per frame one pole coefficient for a time constant of ms */
+static float poleCoef(float ms, jack_nframes_t rate){
+	if(ms <= 0.0)
+		return 1.0;
+	return 1.0 - expf(-1000.0 / (ms * rate));
+}
+
+/* Biquad coefficients, from the RBJ audio EQ cookbook.  Returns zero if 
+ * the settings are out of range. */
+static unsigned char setBiquad(dspStage *stage, float freq, float db, float q, jack_nframes_t rate){
+	double w0, cosw, alpha, A, sqA, a0;
+	
+	if((freq <= 0.0) || (freq >= (rate / 2.0)) || (q <= 0.0))
+		return 0;
+	w0 = 2.0 * M_PI * freq / rate;
+	cosw = cos(w0);
+	alpha = sin(w0) / (2.0 * q);
+	A = pow(10.0, db / 40.0);
+	sqA = 2.0 * sqrt(A) * alpha;
+	if(stage->type == dsp_eq){
+		stage->b0 = 1.0 + alpha * A;
+		stage->b1 = -2.0 * cosw;
+		stage->b2 = 1.0 - alpha * A;
+		a0 = 1.0 + alpha / A;
+		stage->a1 = -2.0 * cosw;
+		stage->a2 = 1.0 - alpha / A;
+	}else if(stage->type == dsp_lowshelf){
+		stage->b0 = A * ((A + 1.0) - (A - 1.0) * cosw + sqA);
+		stage->b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw);
+		stage->b2 = A * ((A + 1.0) - (A - 1.0) * cosw - sqA);
+		a0 = (A + 1.0) + (A - 1.0) * cosw + sqA;
+		stage->a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosw);
+		stage->a2 = (A + 1.0) + (A - 1.0) * cosw - sqA;
+	}else if(stage->type == dsp_highshelf){
+		stage->b0 = A * ((A + 1.0) + (A - 1.0) * cosw + sqA);
+		stage->b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw);
+		stage->b2 = A * ((A + 1.0) + (A - 1.0) * cosw - sqA);
+		a0 = (A + 1.0) - (A - 1.0) * cosw + sqA;
+		stage->a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosw);
+		stage->a2 = (A + 1.0) - (A - 1.0) * cosw - sqA;
+	}else{
+		stage->b0 = (1.0 + cosw) / 2.0;
+		stage->b1 = -(1.0 + cosw);
+		stage->b2 = (1.0 + cosw) / 2.0;
+		a0 = 1.0 + alpha;
+		stage->a1 = -2.0 * cosw;
+		stage->a2 = 1.0 - alpha;
+	}
+	stage->b0 = stage->b0 / a0;
+	stage->b1 = stage->b1 / a0;
+	stage->b2 = stage->b2 / a0;
+	stage->a1 = stage->a1 / a0;
+	stage->a2 = stage->a2 / a0;
+	return 1;
+}
+
+/* Read up to max numbers following a stage name into vals, leaving the 
+ * defaults already in vals for any not given.  Returns zero if there is 
+ * something other than a number, or too many of them. */
+static unsigned char stageSettings(char **save, float *vals, unsigned int max){
+	char *tok, *end;
+	unsigned int n;
+	
+	n = 0;
+	while(tok = strtok_r(NULL, " \t", save)){
+		if(n >= max)
+			return 0;
+		vals[n] = strtod(tok, &end);
+		if(*end)
+			return 0;
+		n++;
+	}
+	return 1;
+}
+
+dspChain *mixdsp_create(const char *spec, unsigned int chanCount, 
+				jack_nframes_t rate, jack_nframes_t maxFrames, const char **err){
+	dspStage stages[dsp_max_stages];
+	dspStage *stage;
+	dspChain *chain;
+	char *copy, *item, *name, *save, *itemSave;
+	float vals[5];
+	unsigned int i, count;
+	size_t size, ring;
+	char *ptr;
+	
+	*err = NULL;
+	if((copy = strdup(spec)) == NULL){
+		*err = "memory allocation for dsp spec failed";
+		return NULL;
+	}
+	
+	/* settings first, and the memory the stages will need */
+	memset(stages, 0, sizeof(stages));
+	count = 0;
+	size = sizeof(dspChain) + (sizeof(jack_default_audio_sample_t *) * chanCount) 
+						+ (sizeof(float) * maxFrames);
+	item = strtok_r(copy, ",", &save);
+	while(item && !*err){
+		if((name = strtok_r(item, " \t", &itemSave)) == NULL){
+			/* empty stage */
+			item = strtok_r(NULL, ",", &save);
+			continue;
+		}
+		if(count >= dsp_max_stages){
+			*err = "too many dsp stages";
+			break;
+		}
+		stage = &stages[count];
+		if(!strcmp(name, "eq") || !strcmp(name, "lowshelf") || !strcmp(name, "highshelf")){
+			if(!strcmp(name, "eq"))
+				stage->type = dsp_eq;
+			else if(!strcmp(name, "lowshelf"))
+				stage->type = dsp_lowshelf;
+			else
+				stage->type = dsp_highshelf;
+			vals[0] = 1000.0;
+			vals[1] = 0.0;
+			vals[2] = 0.707;
+			if(!stageSettings(&itemSave, vals, 3) || !setBiquad(stage, vals[0], vals[1], vals[2], rate))
+				*err = "bad dsp eq setting";
+			size = size + (sizeof(float) * 2 * chanCount);
+		}else if(!strcmp(name, "highpass")){
+			stage->type = dsp_highpass;
+			vals[0] = 40.0;
+			vals[1] = 0.707;
+			if(!stageSettings(&itemSave, vals, 2) || !setBiquad(stage, vals[0], 0.0, vals[1], rate))
+				*err = "bad dsp highpass setting";
+			size = size + (sizeof(float) * 2 * chanCount);
+		}else if(!strcmp(name, "comp")){
+			stage->type = dsp_comp;
+			vals[0] = -18.0;
+			vals[1] = 3.0;
+			vals[2] = 5.0;
+			vals[3] = 150.0;
+			vals[4] = 0.0;
+			if(!stageSettings(&itemSave, vals, 5) || (vals[1] < 1.0) || (vals[2] < 0.0) || (vals[3] < 0.0))
+				*err = "bad dsp comp setting";
+			stage->thresh = dbToGain(vals[0]);
+			stage->slope = (1.0 / vals[1]) - 1.0;
+			stage->attack = poleCoef(vals[2], rate);
+			stage->release = poleCoef(vals[3], rate);
+			stage->makeup = dbToGain(vals[4]);
+			stage->gain = stage->makeup;
+		}else if(!strcmp(name, "limit")){
+			stage->type = dsp_limit;
+			vals[0] = -1.0;
+			vals[1] = 5.0;
+			vals[2] = 80.0;
+			if(!stageSettings(&itemSave, vals, 3) || (vals[0] > 0.0) || (vals[1] < 0.0) 
+									|| (vals[1] > dsp_max_lookahead) || (vals[2] < 0.0))
+				*err = "bad dsp limit setting";
+			stage->thresh = dbToGain(vals[0]);
+			stage->lookahead = vals[1] * rate / 1000.0;
+			/* most of the way to the needed gain by the time the peak 
+			 * is out of the look-ahead delay: a safety clip does the rest */
+			if(stage->lookahead)
+				stage->attack = 1.0 - expf(-3.0 / stage->lookahead);
+			else
+				stage->attack = 1.0;
+			stage->release = poleCoef(vals[2], rate);
+			stage->gain = 1.0;
+			ring = stage->lookahead + 2;
+			size = size + (sizeof(jack_default_audio_sample_t) * chanCount * (stage->lookahead + maxFrames)) 
+							+ ((sizeof(float) + sizeof(uint64_t)) * ring);
+		}else
+			*err = "bad dsp stage name";
+		count++;
+		item = strtok_r(NULL, ",", &save);
+	}
+	free(copy);
+	if(*err)
+		return NULL;
+	
+	/* one block for the chain and everything it uses: uint64_t arrays 
+	 * first, then the float arrays */
+	if((chain = calloc(1, size)) == NULL){
+		*err = "memory allocation for dsp chain failed";
+		return NULL;
+	}
+	mlock(chain, size);
+	chain->size = size;
+	chain->chanCount = chanCount;
+	chain->maxFrames = maxFrames;
+	chain->count = count;
+	memcpy(chain->stages, stages, sizeof(stages));
+	ptr = (char *)chain + sizeof(dspChain);
+	for(i=0; i<count; i++){
+		stage = &chain->stages[i];
+		if(stage->type == dsp_limit){
+			stage->minFrame = (uint64_t *)ptr;
+			ptr = ptr + (sizeof(uint64_t) * (stage->lookahead + 2));
+		}
+	}
+	chain->bufs = (jack_default_audio_sample_t **)ptr;
+	ptr = ptr + (sizeof(jack_default_audio_sample_t *) * chanCount);
+	chain->level = (float *)ptr;
+	ptr = ptr + (sizeof(float) * maxFrames);
+	for(i=0; i<count; i++){
+		stage = &chain->stages[i];
+		if(stage->type == dsp_limit){
+			stage->minGain = (float *)ptr;
+			ptr = ptr + (sizeof(float) * (stage->lookahead + 2));
+			stage->hist = (jack_default_audio_sample_t *)ptr;
+			ptr = ptr + (sizeof(jack_default_audio_sample_t) * chanCount * (stage->lookahead + maxFrames));
+		}else if(stage->type != dsp_comp){
+			stage->z = (float *)ptr;
+			ptr = ptr + (sizeof(float) * 2 * chanCount);
+		}
+	}
+	return chain;
+}
+
+void mixdsp_free(dspChain *chain){
+	if(chain){
+		munlock(chain, chain->size);
+		free(chain);
+	}
+}
+
+static void runBiquad(dspChain *chain, dspStage *stage, jack_nframes_t nframes){
+	jack_default_audio_sample_t *x;
+	float in, out, z1, z2;
+	unsigned int c;
+	jack_nframes_t i;
+	
+	/* transposed direct form II: the recursion is serial in time, so 
+	 * this runs one channel at a time */
+	for(c=0; c<chain->chanCount; c++){
+		x = chain->bufs[c];
+		z1 = stage->z[2 * c];
+		z2 = stage->z[(2 * c) + 1];
+		for(i=0; i<nframes; i++){
+			in = x[i];
+			out = (stage->b0 * in) + z1;
+			z1 = (stage->b1 * in) - (stage->a1 * out) + z2;
+			z2 = (stage->b2 * in) - (stage->a2 * out);
+			x[i] = out;
+		}
+		/* keep denormals out of the state as the signal decays */
+		if(fabsf(z1) < 1.0e-20)
+			z1 = 0.0;
+		if(fabsf(z2) < 1.0e-20)
+			z2 = 0.0;
+		stage->z[2 * c] = z1;
+		stage->z[(2 * c) + 1] = z2;
+	}
+}
+
+static void runComp(dspChain *chain, dspStage *stage, jack_nframes_t nframes){
+	float *level;
+	float env, lvl, gain, target, step;
+	jack_nframes_t i, j, end;
+	unsigned int c;
+	
+	/* linked peak level of the channels */
+	level = chain->level;
+	memset(level, 0, nframes * sizeof(float));
+	for(c=0; c<chain->chanCount; c++)
+		mixKernels.absMax(level, chain->bufs[c], nframes);
+	
+	/* the detector runs every frame; the gain is worked out every 
+	 * dsp_block frames, and ramped between */
+	env = stage->env;
+	gain = stage->gain;
+	for(i=0; i<nframes; i=end){
+		end = i + dsp_block;
+		if(end > nframes)
+			end = nframes;
+		for(j=i; j<end; j++){
+			lvl = level[j];
+			if(lvl > env)
+				env = env + ((lvl - env) * stage->attack);
+			else
+				env = env + ((lvl - env) * stage->release);
+		}
+		target = stage->makeup;
+		if(env > stage->thresh)
+			target = target * powf(env / stage->thresh, stage->slope);
+		step = (target - gain) / (end - i);
+		for(j=i; j<end; j++)
+			level[j] = gain + ((j - i + 1) * step);
+		gain = target;
+	}
+	if(env < 1.0e-20)
+		env = 0.0;
+	stage->env = env;
+	stage->gain = gain;
+	
+	for(c=0; c<chain->chanCount; c++)
+		mixKernels.scaleGains(chain->bufs[c], chain->bufs[c], level, nframes);
+}
+
+static void runLimit(dspChain *chain, dspStage *stage, jack_nframes_t nframes){
+	jack_default_audio_sample_t *x, *hist;
+	float *level;
+	float need, hold, gain, ceiling;
+	size_t window, ring, tail, la;
+	jack_nframes_t i;
+	unsigned int c;
+	
+	level = chain->level;
+	memset(level, 0, nframes * sizeof(float));
+	for(c=0; c<chain->chanCount; c++)
+		mixKernels.absMax(level, chain->bufs[c], nframes);
+	
+	/* the gain each frame needs, held as a running minimum over the 
+	 * look-ahead window, so the gain is down before the peak comes out 
+	 * of the delay.  The minimum candidates are kept in a ring, oldest 
+	 * first, each smaller than the one before. */
+	la = stage->lookahead;
+	window = la + 1;
+	ring = window + 1;
+	ceiling = stage->thresh;
+	gain = stage->gain;
+	for(i=0; i<nframes; i++){
+		need = 1.0;
+		if(level[i] > ceiling)
+			need = ceiling / level[i];
+		while(stage->minCount){
+			tail = (stage->minHead + stage->minCount - 1) % ring;
+			if(stage->minGain[tail] < need)
+				break;
+			stage->minCount--;
+		}
+		tail = (stage->minHead + stage->minCount) % ring;
+		stage->minGain[tail] = need;
+		stage->minFrame[tail] = stage->frame;
+		stage->minCount++;
+		if((stage->frame - stage->minFrame[stage->minHead]) >= window){
+			stage->minHead = (stage->minHead + 1) % ring;
+			stage->minCount--;
+		}
+		hold = stage->minGain[stage->minHead];
+		if(hold < gain)
+			gain = gain + ((hold - gain) * stage->attack);
+		else
+			gain = gain + ((hold - gain) * stage->release);
+		level[i] = gain;
+		stage->frame++;
+	}
+	stage->gain = gain;
+	
+	/* delay each channel by the look-ahead, apply the gain, and clip 
+	 * anything the gain didn't quite catch */
+	for(c=0; c<chain->chanCount; c++){
+		x = chain->bufs[c];
+		hist = stage->hist + (c * (la + chain->maxFrames));
+		mixKernels.copy(hist + la, x, nframes);
+		mixKernels.scaleGains(x, hist, level, nframes);
+		memmove(hist, hist + nframes, la * sizeof(jack_default_audio_sample_t));
+		for(i=0; i<nframes; i++)
+			x[i] = fminf(fmaxf(x[i], -ceiling), ceiling);
+	}
+}
+
+void mixdsp_process(dspChain *chain, jack_nframes_t nframes){
+	unsigned int s;
+	dspStage *stage;
+	
+	if(nframes > chain->maxFrames)
+		/* can't be done without allocating: pass the samples through */
+		return;
+	stage = chain->stages;
+	for(s=0; s<chain->count; s++){
+		if(stage->type == dsp_comp)
+			runComp(chain, stage, nframes);
+		else if(stage->type == dsp_limit)
+			runLimit(chain, stage, nframes);
+		else
+			runBiquad(chain, stage, nframes);
+		stage++;
+	}
+}
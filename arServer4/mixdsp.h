@@ -0,0 +1,108 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _MIXDSP_H
+#define _MIXDSP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include <jack/jack.h>
+
+/* In-process insert processing for mix buses and output groups: a chain 
+ * of up to dsp_max_stages stages, run in place on a cycle's samples by the 
+ * render thread.  A chain is described by a spec string, stages separated 
+ * by commas, each a stage name followed by its settings, any of which may 
+ * be left off for the default:
+ *	eq [freq Hz] [gain dB] [Q]				peaking EQ band
+ *	lowshelf [freq Hz] [gain dB] [Q]		low shelf
+ *	highshelf [freq Hz] [gain dB] [Q]		high shelf
+ *	highpass [freq Hz] [Q]					12 dB/octave high pass
+ *	comp [threshold dB] [ratio] [attack mS] [release mS] [makeup dB]
+ *	limit [ceiling dB] [look-ahead mS] [release mS]
+ * i.e. "highpass 40, eq 3000 2 1.2, comp -18 3 5 150 4, limit -1 5 80".  
+ * Compressor and limiter gains are linked across the channels.  All 
+ * memory is allocated when the chain is created, and the cost of a cycle 
+ * depends only on the stages and the frame count, not on the audio. */
+
+#define dsp_max_stages		8
+#define dsp_max_lookahead	20.0	// limiter look-ahead, mS
+#define dsp_block			16		// frames per compressor gain step
+
+enum{
+	dsp_eq = 1,
+	dsp_lowshelf,
+	dsp_highshelf,
+	dsp_highpass,
+	dsp_comp,
+	dsp_limit
+};
+
+typedef struct{
+	unsigned char type;
+	/* biquads: normalized coefficients, and z1, z2 for each channel */
+	float b0, b1, b2, a1, a2;
+	float *z;
+	/* compressor and limiter */
+	float thresh;		// linear: compressor threshold, or limiter ceiling
+	float slope;		// compressor: 1 / ratio - 1
+	float makeup;		// linear
+	float attack;		// one pole coefficients, per frame
+	float release;
+	float env;			// compressor detector level
+	float gain;			// gain at the end of the last cycle
+	/* limiter look-ahead: the delayed samples, and a running minimum of 
+	 * the gains needed over the look-ahead window */
+	size_t lookahead;	// frames
+	jack_default_audio_sample_t *hist;	// chanCount * (lookahead + maxFrames)
+	float *minGain;		// lookahead + 2 ring of the running minimum candidates
+	uint64_t *minFrame;
+	size_t minHead, minCount;
+	uint64_t frame;
+} dspStage;
+
+typedef struct dspChain{
+	unsigned int chanCount;
+	jack_nframes_t maxFrames;
+	unsigned int count;
+	size_t size;
+	dspStage stages[dsp_max_stages];
+	float *level;		// maxFrames scratch: linked peak level, then gain
+	jack_default_audio_sample_t **bufs;	// chanCount: set by the caller, the samples to process in place
+} dspChain;
+
+/* Make a chain from spec for chanCount channels at rate, for cycles of up 
+ * to maxFrames.  Returns NULL with an error string in *err on failure. 
+ * App threads only. */
+dspChain *mixdsp_create(const char *spec, unsigned int chanCount, 
+				jack_nframes_t rate, jack_nframes_t maxFrames, const char **err);
+
+/* Render thread: run the chain on the nframes samples of each channel 
+ * in chain->bufs. */
+void mixdsp_process(dspChain *chain, jack_nframes_t nframes);
+
+void mixdsp_free(dspChain *chain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
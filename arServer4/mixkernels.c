@@ -0,0 +1,742 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <math.h>
+
+#include "mixkernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MIXKERNELS_X86
+#include <immintrin.h>
+#endif
+
+/* scalar reference kernels */
+
+static void sum_scalar(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count){
+	size_t i;
+
+	for(i=0; i<count; i++)
+		dest[i] += src[i];
+}
+
+static void copy_scalar(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count){
+	if(dest != src)
+		memmove(dest, src, count * sizeof(jack_default_audio_sample_t));
+}
+
+static void scale_scalar(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i;
+
+	for(i=0; i<count; i++)
+		dest[i] = src[i] * gain;
+}
+
+static void scaleSum_scalar(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i;
+
+	for(i=0; i<count; i++)
+		dest[i] += src[i] * gain;
+}
+
+static void sumScale_scalar(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i;
+
+	for(i=0; i<count; i++)
+		dest[i] = (dest[i] + src[i]) * gain;
+}
+
+static void scaleRamp_scalar(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count){
+	size_t i;
+
+	for(i=0; i<count; i++)
+		dest[i] = src[i] * (gain + (float)i * gainStep);
+}
+
+static void scaleGains_scalar(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, const float *gains, size_t count){
+	size_t i;
+
+	for(i=0; i<count; i++)
+		dest[i] = src[i] * gains[i];
+}
+
+static void absMax_scalar(float *dest, const jack_default_audio_sample_t *src, size_t count){
+	size_t i;
+
+	for(i=0; i<count; i++)
+		dest[i] = fmaxf(dest[i], fabsf(src[i]));
+}
+
+/* the scalar fanout steps through the samples in blocks of fanLanes, with 
+ * a meter sum per lane, so the compiler is free to vectorize it */
+#define fanLanes	8
+
+static float fanout_scalar(jack_default_audio_sample_t *const *dests, unsigned int setCount, 
+				unsigned int destCount, jack_default_audio_sample_t *feed, float feedGain, 
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count, float *peak){
+	float v[fanLanes], acc[fanLanes], top[fanLanes];
+	jack_default_audio_sample_t *dest;
+	float g;
+	size_t i, n;
+	unsigned int d, l;
+
+	for(l=0; l<fanLanes; l++){
+		acc[l] = 0.0;
+		top[l] = 0.0;
+	}
+	n = count & ~(size_t)(fanLanes - 1);
+	for(i=0; i<n; i+=fanLanes){
+		for(l=0; l<fanLanes; l++){
+			g = gain + (float)(i + l) * gainStep;
+			v[l] = src[i+l] * g;
+			acc[l] += v[l] * v[l];
+			top[l] = ((v[l] * v[l]) > top[l]) ? (v[l] * v[l]) : top[l];
+		}
+		for(d=0; d<setCount; d++){
+			dest = dests[d] + i;
+			for(l=0; l<fanLanes; l++)
+				dest[l] = v[l];
+		}
+		for(; d<destCount; d++){
+			dest = dests[d] + i;
+			for(l=0; l<fanLanes; l++)
+				dest[l] += v[l];
+		}
+		if(feed){
+			for(l=0; l<fanLanes; l++)
+				feed[i+l] = v[l] * feedGain;
+		}
+	}
+	for(; i<count; i++){
+		v[0] = src[i] * (gain + (float)i * gainStep);
+		acc[0] += v[0] * v[0];
+		if((v[0] * v[0]) > top[0])
+			top[0] = v[0] * v[0];
+		for(d=0; d<setCount; d++)
+			dests[d][i] = v[0];
+		for(; d<destCount; d++)
+			dests[d][i] += v[0];
+		if(feed)
+			feed[i] = v[0] * feedGain;
+	}
+	for(l=1; l<fanLanes; l++){
+		acc[0] += acc[l];
+		if(top[l] > top[0])
+			top[0] = top[l];
+	}
+	*peak = top[0];
+	return acc[0];
+}
+
+#ifdef MIXKERNELS_X86
+
+/* SSE2 kernels: 4 samples per step */
+
+__attribute__((target("sse2")))
+static void sum_sse2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count){
+	size_t i, n;
+
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4)
+		_mm_storeu_ps(dest+i, _mm_add_ps(_mm_loadu_ps(dest+i), _mm_loadu_ps(src+i)));
+	for(; i<count; i++)
+		dest[i] += src[i];
+}
+
+__attribute__((target("sse2")))
+static void scale_sse2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__m128 g;
+
+	g = _mm_set1_ps(gain);
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4)
+		_mm_storeu_ps(dest+i, _mm_mul_ps(_mm_loadu_ps(src+i), g));
+	for(; i<count; i++)
+		dest[i] = src[i] * gain;
+}
+
+__attribute__((target("sse2")))
+static void scaleSum_sse2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__m128 g;
+
+	g = _mm_set1_ps(gain);
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4)
+		_mm_storeu_ps(dest+i, _mm_add_ps(_mm_loadu_ps(dest+i),
+										_mm_mul_ps(_mm_loadu_ps(src+i), g)));
+	for(; i<count; i++)
+		dest[i] += src[i] * gain;
+}
+
+__attribute__((target("sse2")))
+static void sumScale_sse2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__m128 g;
+
+	g = _mm_set1_ps(gain);
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4)
+		_mm_storeu_ps(dest+i, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(dest+i), _mm_loadu_ps(src+i)), g));
+	for(; i<count; i++)
+		dest[i] = (dest[i] + src[i]) * gain;
+}
+
+__attribute__((target("sse2")))
+static void scaleRamp_sse2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count){
+	size_t i, n;
+	__m128 g, gs, idx, four;
+
+	g = _mm_set1_ps(gain);
+	gs = _mm_set1_ps(gainStep);
+	idx = _mm_setr_ps(0.0, 1.0, 2.0, 3.0);
+	four = _mm_set1_ps(4.0);
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4){
+		_mm_storeu_ps(dest+i, _mm_mul_ps(_mm_loadu_ps(src+i), _mm_add_ps(g, _mm_mul_ps(idx, gs))));
+		idx = _mm_add_ps(idx, four);
+	}
+	for(; i<count; i++)
+		dest[i] = src[i] * (gain + (float)i * gainStep);
+}
+
+__attribute__((target("sse2")))
+static void scaleGains_sse2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, const float *gains, size_t count){
+	size_t i, n;
+
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4)
+		_mm_storeu_ps(dest+i, _mm_mul_ps(_mm_loadu_ps(src+i), _mm_loadu_ps(gains+i)));
+	for(; i<count; i++)
+		dest[i] = src[i] * gains[i];
+}
+
+__attribute__((target("sse2")))
+static void absMax_sse2(float *dest, const jack_default_audio_sample_t *src, size_t count){
+	size_t i, n;
+	__m128 mask;
+
+	/* clearing the sign bit gives the magnitude */
+	mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4)
+		_mm_storeu_ps(dest+i, _mm_max_ps(_mm_loadu_ps(dest+i), _mm_and_ps(_mm_loadu_ps(src+i), mask)));
+	for(; i<count; i++)
+		dest[i] = fmaxf(dest[i], fabsf(src[i]));
+}
+
+__attribute__((target("sse2")))
+static float fanout_sse2(jack_default_audio_sample_t *const *dests, unsigned int setCount, 
+				unsigned int destCount, jack_default_audio_sample_t *feed, float feedGain, 
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count, float *peak){
+	float lanes[4], sum, top, x;
+	size_t i, n;
+	unsigned int d;
+	__m128 g, gs, idx, four, fg, v, sq, acc, mx;
+
+	g = _mm_set1_ps(gain);
+	gs = _mm_set1_ps(gainStep);
+	idx = _mm_setr_ps(0.0, 1.0, 2.0, 3.0);
+	four = _mm_set1_ps(4.0);
+	fg = _mm_set1_ps(feedGain);
+	acc = mx = _mm_setzero_ps();
+	n = count & ~(size_t)3;
+	for(i=0; i<n; i+=4){
+		v = _mm_mul_ps(_mm_loadu_ps(src+i), _mm_add_ps(g, _mm_mul_ps(idx, gs)));
+		idx = _mm_add_ps(idx, four);
+		sq = _mm_mul_ps(v, v);
+		acc = _mm_add_ps(acc, sq);
+		mx = _mm_max_ps(mx, sq);
+		for(d=0; d<setCount; d++)
+			_mm_storeu_ps(dests[d]+i, v);
+		for(; d<destCount; d++)
+			_mm_storeu_ps(dests[d]+i, _mm_add_ps(_mm_loadu_ps(dests[d]+i), v));
+		if(feed)
+			_mm_storeu_ps(feed+i, _mm_mul_ps(v, fg));
+	}
+	_mm_storeu_ps(lanes, acc);
+	sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	_mm_storeu_ps(lanes, mx);
+	top = lanes[0];
+	for(d=1; d<4; d++){
+		if(lanes[d] > top)
+			top = lanes[d];
+	}
+	for(; i<count; i++){
+		x = src[i] * (gain + (float)i * gainStep);
+		sum += x * x;
+		if((x * x) > top)
+			top = x * x;
+		for(d=0; d<setCount; d++)
+			dests[d][i] = x;
+		for(; d<destCount; d++)
+			dests[d][i] += x;
+		if(feed)
+			feed[i] = x * feedGain;
+	}
+	*peak = top;
+	return sum;
+}
+
+/* AVX2 kernels: 8 samples per step, two steps per loop to cover
+ * load latency.  Fused multiply-add is part of every AVX2 CPU we
+ * care about, but it is a separate CPUID bit, so it is checked too. */
+
+__attribute__((target("avx2")))
+static void sum_avx2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count){
+	size_t i, n;
+
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16){
+		_mm256_storeu_ps(dest+i, _mm256_add_ps(_mm256_loadu_ps(dest+i), _mm256_loadu_ps(src+i)));
+		_mm256_storeu_ps(dest+i+8, _mm256_add_ps(_mm256_loadu_ps(dest+i+8), _mm256_loadu_ps(src+i+8)));
+	}
+	for(; i<count; i++)
+		dest[i] += src[i];
+}
+
+__attribute__((target("avx2")))
+static void copy_avx2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count){
+	size_t i, n;
+
+	if(dest == src)
+		return;
+	if((dest < src + count) && (src < dest + count)){
+		/* overlapping: let the library sort out the direction */
+		memmove(dest, src, count * sizeof(jack_default_audio_sample_t));
+		return;
+	}
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16){
+		_mm256_storeu_ps(dest+i, _mm256_loadu_ps(src+i));
+		_mm256_storeu_ps(dest+i+8, _mm256_loadu_ps(src+i+8));
+	}
+	for(; i<count; i++)
+		dest[i] = src[i];
+}
+
+__attribute__((target("avx2")))
+static void scale_avx2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__m256 g;
+
+	g = _mm256_set1_ps(gain);
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16){
+		_mm256_storeu_ps(dest+i, _mm256_mul_ps(_mm256_loadu_ps(src+i), g));
+		_mm256_storeu_ps(dest+i+8, _mm256_mul_ps(_mm256_loadu_ps(src+i+8), g));
+	}
+	for(; i<count; i++)
+		dest[i] = src[i] * gain;
+}
+
+__attribute__((target("avx2,fma")))
+static void scaleSum_avx2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__m256 g;
+
+	g = _mm256_set1_ps(gain);
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16){
+		_mm256_storeu_ps(dest+i, _mm256_fmadd_ps(_mm256_loadu_ps(src+i), g, _mm256_loadu_ps(dest+i)));
+		_mm256_storeu_ps(dest+i+8, _mm256_fmadd_ps(_mm256_loadu_ps(src+i+8), g, _mm256_loadu_ps(dest+i+8)));
+	}
+	for(; i<count; i++)
+		dest[i] += src[i] * gain;
+}
+
+__attribute__((target("avx2")))
+static void sumScale_avx2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__m256 g;
+
+	g = _mm256_set1_ps(gain);
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16){
+		_mm256_storeu_ps(dest+i, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(dest+i), _mm256_loadu_ps(src+i)), g));
+		_mm256_storeu_ps(dest+i+8, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(dest+i+8), _mm256_loadu_ps(src+i+8)), g));
+	}
+	for(; i<count; i++)
+		dest[i] = (dest[i] + src[i]) * gain;
+}
+
+__attribute__((target("avx2")))
+static void scaleRamp_avx2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count){
+	size_t i, n;
+	__m256 g, gs, idx, eight;
+
+	g = _mm256_set1_ps(gain);
+	gs = _mm256_set1_ps(gainStep);
+	idx = _mm256_setr_ps(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+	eight = _mm256_set1_ps(8.0);
+	n = count & ~(size_t)7;
+	for(i=0; i<n; i+=8){
+		_mm256_storeu_ps(dest+i, _mm256_mul_ps(_mm256_loadu_ps(src+i), _mm256_add_ps(g, _mm256_mul_ps(idx, gs))));
+		idx = _mm256_add_ps(idx, eight);
+	}
+	for(; i<count; i++)
+		dest[i] = src[i] * (gain + (float)i * gainStep);
+}
+
+__attribute__((target("avx2")))
+static void scaleGains_avx2(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, const float *gains, size_t count){
+	size_t i, n;
+
+	n = count & ~(size_t)7;
+	for(i=0; i<n; i+=8)
+		_mm256_storeu_ps(dest+i, _mm256_mul_ps(_mm256_loadu_ps(src+i), _mm256_loadu_ps(gains+i)));
+	for(; i<count; i++)
+		dest[i] = src[i] * gains[i];
+}
+
+__attribute__((target("avx2")))
+static void absMax_avx2(float *dest, const jack_default_audio_sample_t *src, size_t count){
+	size_t i, n;
+	__m256 mask;
+
+	mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	n = count & ~(size_t)7;
+	for(i=0; i<n; i+=8)
+		_mm256_storeu_ps(dest+i, _mm256_max_ps(_mm256_loadu_ps(dest+i), _mm256_and_ps(_mm256_loadu_ps(src+i), mask)));
+	for(; i<count; i++)
+		dest[i] = fmaxf(dest[i], fabsf(src[i]));
+}
+
+__attribute__((target("avx2")))
+static float fanout_avx2(jack_default_audio_sample_t *const *dests, unsigned int setCount, 
+				unsigned int destCount, jack_default_audio_sample_t *feed, float feedGain, 
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count, float *peak){
+	float lanes[8], sum, top, x;
+	size_t i, n;
+	unsigned int d;
+	__m256 g, gs, idx, eight, fg, v, sq, acc, mx;
+
+	g = _mm256_set1_ps(gain);
+	gs = _mm256_set1_ps(gainStep);
+	idx = _mm256_setr_ps(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+	eight = _mm256_set1_ps(8.0);
+	fg = _mm256_set1_ps(feedGain);
+	acc = mx = _mm256_setzero_ps();
+	n = count & ~(size_t)7;
+	for(i=0; i<n; i+=8){
+		v = _mm256_mul_ps(_mm256_loadu_ps(src+i), _mm256_add_ps(g, _mm256_mul_ps(idx, gs)));
+		idx = _mm256_add_ps(idx, eight);
+		sq = _mm256_mul_ps(v, v);
+		acc = _mm256_add_ps(acc, sq);
+		mx = _mm256_max_ps(mx, sq);
+		for(d=0; d<setCount; d++)
+			_mm256_storeu_ps(dests[d]+i, v);
+		for(; d<destCount; d++)
+			_mm256_storeu_ps(dests[d]+i, _mm256_add_ps(_mm256_loadu_ps(dests[d]+i), v));
+		if(feed)
+			_mm256_storeu_ps(feed+i, _mm256_mul_ps(v, fg));
+	}
+	_mm256_storeu_ps(lanes, acc);
+	sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+	_mm256_storeu_ps(lanes, mx);
+	top = lanes[0];
+	for(d=1; d<8; d++){
+		if(lanes[d] > top)
+			top = lanes[d];
+	}
+	for(; i<count; i++){
+		x = src[i] * (gain + (float)i * gainStep);
+		sum += x * x;
+		if((x * x) > top)
+			top = x * x;
+		for(d=0; d<setCount; d++)
+			dests[d][i] = x;
+		for(; d<destCount; d++)
+			dests[d][i] += x;
+		if(feed)
+			feed[i] = x * feedGain;
+	}
+	*peak = top;
+	return sum;
+}
+
+/* AVX-512 kernels: 16 samples per step, with the remainder handled
+ * by a single masked step rather than a scalar loop. */
+
+__attribute__((target("avx512f")))
+static void sum_avx512(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count){
+	size_t i, n;
+	__mmask16 m;
+
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16)
+		_mm512_storeu_ps(dest+i, _mm512_add_ps(_mm512_loadu_ps(dest+i), _mm512_loadu_ps(src+i)));
+	if(i < count){
+		m = (__mmask16)((1U << (count - i)) - 1);
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, dest+i),
+											_mm512_maskz_loadu_ps(m, src+i)));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void copy_avx512(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count){
+	size_t i, n;
+	__mmask16 m;
+
+	if(dest == src)
+		return;
+	if((dest < src + count) && (src < dest + count)){
+		memmove(dest, src, count * sizeof(jack_default_audio_sample_t));
+		return;
+	}
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16)
+		_mm512_storeu_ps(dest+i, _mm512_loadu_ps(src+i));
+	if(i < count){
+		m = (__mmask16)((1U << (count - i)) - 1);
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_maskz_loadu_ps(m, src+i));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void scale_avx512(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__mmask16 m;
+	__m512 g;
+
+	g = _mm512_set1_ps(gain);
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16)
+		_mm512_storeu_ps(dest+i, _mm512_mul_ps(_mm512_loadu_ps(src+i), g));
+	if(i < count){
+		m = (__mmask16)((1U << (count - i)) - 1);
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, src+i), g));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void scaleSum_avx512(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__mmask16 m;
+	__m512 g;
+
+	g = _mm512_set1_ps(gain);
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16)
+		_mm512_storeu_ps(dest+i, _mm512_fmadd_ps(_mm512_loadu_ps(src+i), g, _mm512_loadu_ps(dest+i)));
+	if(i < count){
+		m = (__mmask16)((1U << (count - i)) - 1);
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, src+i), g,
+											_mm512_maskz_loadu_ps(m, dest+i)));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void sumScale_avx512(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count){
+	size_t i, n;
+	__mmask16 m;
+	__m512 g;
+
+	g = _mm512_set1_ps(gain);
+	n = count & ~(size_t)15;
+	for(i=0; i<n; i+=16)
+		_mm512_storeu_ps(dest+i, _mm512_mul_ps(_mm512_add_ps(_mm512_loadu_ps(dest+i), _mm512_loadu_ps(src+i)), g));
+	if(i < count){
+		m = (__mmask16)((1U << (count - i)) - 1);
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_mul_ps(_mm512_add_ps(_mm512_maskz_loadu_ps(m, dest+i),
+											_mm512_maskz_loadu_ps(m, src+i)), g));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void scaleRamp_avx512(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count){
+	size_t i;
+	__mmask16 m;
+	__m512 g, gs, idx, sixteen;
+
+	g = _mm512_set1_ps(gain);
+	gs = _mm512_set1_ps(gainStep);
+	idx = _mm512_setr_ps(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0, 13.0, 14.0, 15.0);
+	sixteen = _mm512_set1_ps(16.0);
+	for(i=0; i<count; i+=16){
+		if((count - i) < 16)
+			m = (__mmask16)((1U << (count - i)) - 1);
+		else
+			m = 0xffff;
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, src+i), 
+											_mm512_add_ps(g, _mm512_mul_ps(idx, gs))));
+		idx = _mm512_add_ps(idx, sixteen);
+	}
+}
+
+__attribute__((target("avx512f")))
+static void scaleGains_avx512(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, const float *gains, size_t count){
+	size_t i;
+	__mmask16 m;
+
+	for(i=0; i<count; i+=16){
+		if((count - i) < 16)
+			m = (__mmask16)((1U << (count - i)) - 1);
+		else
+			m = 0xffff;
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, src+i), 
+											_mm512_maskz_loadu_ps(m, gains+i)));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void absMax_avx512(float *dest, const jack_default_audio_sample_t *src, size_t count){
+	size_t i;
+	__mmask16 m;
+
+	for(i=0; i<count; i+=16){
+		if((count - i) < 16)
+			m = (__mmask16)((1U << (count - i)) - 1);
+		else
+			m = 0xffff;
+		_mm512_mask_storeu_ps(dest+i, m, _mm512_max_ps(_mm512_maskz_loadu_ps(m, dest+i), 
+											_mm512_abs_ps(_mm512_maskz_loadu_ps(m, src+i))));
+	}
+}
+
+__attribute__((target("avx512f")))
+static float fanout_avx512(jack_default_audio_sample_t *const *dests, unsigned int setCount, 
+				unsigned int destCount, jack_default_audio_sample_t *feed, float feedGain, 
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count, float *peak){
+	size_t i;
+	unsigned int d;
+	__mmask16 m;
+	__m512 g, gs, idx, sixteen, fg, v, sq, acc, mx;
+
+	g = _mm512_set1_ps(gain);
+	gs = _mm512_set1_ps(gainStep);
+	idx = _mm512_setr_ps(0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0, 13.0, 14.0, 15.0);
+	sixteen = _mm512_set1_ps(16.0);
+	fg = _mm512_set1_ps(feedGain);
+	acc = mx = _mm512_setzero_ps();
+	for(i=0; i<count; i+=16){
+		/* the last step is masked: masked off lanes load as zero, 
+		 * which leaves the sum and peak untouched */
+		if((count - i) < 16)
+			m = (__mmask16)((1U << (count - i)) - 1);
+		else
+			m = 0xffff;
+		v = _mm512_mul_ps(_mm512_maskz_loadu_ps(m, src+i), _mm512_add_ps(g, _mm512_mul_ps(idx, gs)));
+		idx = _mm512_add_ps(idx, sixteen);
+		sq = _mm512_mul_ps(v, v);
+		acc = _mm512_add_ps(acc, sq);
+		mx = _mm512_max_ps(mx, sq);
+		for(d=0; d<setCount; d++)
+			_mm512_mask_storeu_ps(dests[d]+i, m, v);
+		for(; d<destCount; d++)
+			_mm512_mask_storeu_ps(dests[d]+i, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, dests[d]+i), v));
+		if(feed)
+			_mm512_mask_storeu_ps(feed+i, m, _mm512_mul_ps(v, fg));
+	}
+	*peak = _mm512_reduce_max_ps(mx);
+	return _mm512_reduce_add_ps(acc);
+}
+
+#endif
+
+static const mixKernelSet kernelsScalar = {
+	"scalar", sum_scalar, copy_scalar, scale_scalar, scaleSum_scalar, sumScale_scalar, scaleRamp_scalar, fanout_scalar,
+	scaleGains_scalar, absMax_scalar
+};
+
+#ifdef MIXKERNELS_X86
+static const mixKernelSet kernelsSSE2 = {
+	/* copy is memory bound: the library memmove is as good as it gets at this width */
+	"sse2", sum_sse2, copy_scalar, scale_sse2, scaleSum_sse2, sumScale_sse2, scaleRamp_sse2, fanout_sse2,
+	scaleGains_sse2, absMax_sse2
+};
+
+static const mixKernelSet kernelsAVX2 = {
+	"avx2", sum_avx2, copy_avx2, scale_avx2, scaleSum_avx2, sumScale_avx2, scaleRamp_avx2, fanout_avx2,
+	scaleGains_avx2, absMax_avx2
+};
+
+static const mixKernelSet kernelsAVX512 = {
+	"avx512", sum_avx512, copy_avx512, scale_avx512, scaleSum_avx512, sumScale_avx512, scaleRamp_avx512, fanout_avx512,
+	scaleGains_avx512, absMax_avx512
+};
+#endif
+
+/* start with the reference set so the kernels are usable even if
+ * mixkernels_init() has not been called yet */
+mixKernelSet mixKernels = {
+	"scalar", sum_scalar, copy_scalar, scale_scalar, scaleSum_scalar, sumScale_scalar, scaleRamp_scalar, fanout_scalar,
+	scaleGains_scalar, absMax_scalar
+};
+
+const char *mixkernels_init(const char *force){
+	const mixKernelSet *set;
+	unsigned char sse2, avx2, avx512;
+
+	sse2 = avx2 = avx512 = 0;
+#ifdef MIXKERNELS_X86
+	/* CPUID based checks, including OS support for the wider register states */
+	__builtin_cpu_init();
+	sse2 = (__builtin_cpu_supports("sse2") != 0);
+	avx2 = (__builtin_cpu_supports("avx2") != 0) && (__builtin_cpu_supports("fma") != 0);
+	avx512 = (__builtin_cpu_supports("avx512f") != 0);
+#endif
+
+	set = &kernelsScalar;
+#ifdef MIXKERNELS_X86
+	if(force && strlen(force)){
+		if(!strcmp(force, "sse2") && sse2)
+			set = &kernelsSSE2;
+		else if(!strcmp(force, "avx2") && avx2)
+			set = &kernelsAVX2;
+		else if(!strcmp(force, "avx512") && avx512)
+			set = &kernelsAVX512;
+	}else{
+		if(avx512)
+			set = &kernelsAVX512;
+		else if(avx2)
+			set = &kernelsAVX2;
+		else if(sse2)
+			set = &kernelsSSE2;
+	}
+#endif
+	mixKernels = *set;
+	return mixKernels.name;
+}
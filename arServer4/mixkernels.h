@@ -0,0 +1,85 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _MIXKERNELS_H
+#define _MIXKERNELS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <jack/jack.h>
+
+/* Sample block kernels used by the mix engine render thread.  The scalar
+ * versions are the reference implementation; vector versions are selected
+ * once, at start up, by mixkernels_init() based on the CPU features found.
+ * Source and destination pointers need not be aligned, and may be equal
+ * for the scale kernel (in-place scaling). */
+typedef struct{
+	const char *name;
+	/* dest = dest + src */
+	void (*sum)(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count);
+	/* dest = src */
+	void (*copy)(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, size_t count);
+	/* dest = src * gain */
+	void (*scale)(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count);
+	/* dest = dest + (src * gain) */
+	void (*scaleSum)(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count);
+	/* dest = (dest + src) * gain */
+	void (*sumScale)(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, size_t count);
+	/* dest[i] = src[i] * (gain + i * gainStep): a linear gain ramp */
+	void (*scaleRamp)(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, float gain, float gainStep, size_t count);
+	/* one pass over an input channel: s = src * (gain + i * gainStep) is 
+	 * written to the first setCount of the destCount buffers in dests and 
+	 * summed into the rest, and written to feed as s * feedGain if feed is 
+	 * not NULL.  Returns the sum of s squared, with the largest s squared 
+	 * in *peak. */
+	float (*fanout)(jack_default_audio_sample_t *const *dests, unsigned int setCount, 
+				unsigned int destCount, jack_default_audio_sample_t *feed, float feedGain, 
+				const jack_default_audio_sample_t *src, float gain, float gainStep, 
+				size_t count, float *peak);
+	/* dest[i] = src[i] * gains[i] */
+	void (*scaleGains)(jack_default_audio_sample_t *dest,
+				const jack_default_audio_sample_t *src, const float *gains, size_t count);
+	/* dest[i] = the larger of dest[i] and |src[i]| */
+	void (*absMax)(float *dest, const jack_default_audio_sample_t *src, size_t count);
+} mixKernelSet;
+
+extern mixKernelSet mixKernels;
+
+/* Selects the kernel set to use.  If force is NULL or empty, the best set
+ * supported by this CPU is used.  Otherwise, force names the set to use
+ * ("scalar", "sse2", "avx2" or "avx512"), falling back to scalar if the
+ * named set is unknown or not supported.  Returns the name of the set used. */
+const char *mixkernels_init(const char *force);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
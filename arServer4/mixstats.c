@@ -0,0 +1,142 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "mixstats.h"
+
+const char *mixstats_stageName[stageCount] = {
+	"decode", "control", "mix", "status", "mixminus", "outgroups", "busout", "meters", "cycle"
+};
+
+static uint64_t usNow(void){
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+mixStats *mixstats_create(void){
+	mixStats *stats;
+	uint64_t us, ticks;
+	
+	if((stats = (mixStats *)calloc(1, sizeof(mixStats))) == NULL)
+		return NULL;
+	mlock(stats, sizeof(mixStats));
+	
+	/* calibrate the cycle counter against the monotonic clock */
+	us = usNow();
+	ticks = mixstats_now();
+	usleep(20000);
+	us = usNow() - us;
+	ticks = mixstats_now() - ticks;
+	if(us && ticks)
+		stats->ticksPerUS = (double)ticks / us;
+	else
+		stats->ticksPerUS = 1000.0;
+	return stats;
+}
+
+void mixstats_free(mixStats *stats){
+	if(stats){
+		munlock(stats, sizeof(mixStats));
+		free(stats);
+	}
+}
+
+void mixstats_begin(mixStats *stats){
+	if(__atomic_load_n(&stats->resetReq, __ATOMIC_ACQUIRE)){
+		memset(stats->hist, 0, sizeof(stats->hist));
+		memset(stats->max, 0, sizeof(stats->max));
+		__atomic_store_n(&stats->resetReq, 0, __ATOMIC_RELEASE);
+	}
+	memset(stats->cur, 0, sizeof(stats->cur));
+}
+
+void mixstats_end(mixStats *stats){
+	unsigned int s;
+	
+	for(s=0; s<stageCount; s++)
+		__atomic_store_n(&stats->last[s], stats->cur[s], __ATOMIC_RELAXED);
+}
+
+void mixstats_xrun(mixStats *stats, uint64_t frameClock){
+	xrunRecord *rec;
+	unsigned int s;
+	
+	rec = &stats->xruns[__atomic_load_n(&stats->xrunCount, __ATOMIC_RELAXED) % xrunLogSize];
+	gettimeofday(&rec->when, NULL);
+	rec->frameClock = frameClock;
+	for(s=0; s<stageCount; s++)
+		rec->lastTicks[s] = __atomic_load_n(&stats->last[s], __ATOMIC_RELAXED);
+	__atomic_add_fetch(&stats->xrunCount, 1, __ATOMIC_RELEASE);
+}
+
+void mixstats_reset(mixStats *stats){
+	__atomic_store_n(&stats->resetReq, 1, __ATOMIC_RELEASE);
+}
+
+static double bucketUS(mixStats *stats, unsigned int b){
+	/* middle of the bucket's range of tick counts */
+	unsigned int octave;
+	double low, width;
+	
+	if(b < 8)
+		return b / stats->ticksPerUS;
+	octave = (b / 8) + 2;
+	width = (double)((uint64_t)1 << (octave - 3));
+	low = (8 + (b % 8)) * width;
+	return (low + (width / 2.0)) / stats->ticksPerUS;
+}
+
+uint64_t mixstats_count(mixStats *stats, unsigned int stage){
+	uint64_t count;
+	unsigned int b;
+	
+	count = 0;
+	for(b=0; b<statBuckets; b++)
+		count += __atomic_load_n(&stats->hist[stage][b], __ATOMIC_RELAXED);
+	return count;
+}
+
+double mixstats_percentile(mixStats *stats, unsigned int stage, double fraction){
+	uint64_t count, target, sum;
+	unsigned int b;
+	
+	if((count = mixstats_count(stats, stage)) == 0)
+		return -1.0;
+	target = (uint64_t)(fraction * count);
+	if(target >= count)
+		target = count - 1;
+	sum = 0;
+	for(b=0; b<statBuckets; b++){
+		sum += __atomic_load_n(&stats->hist[stage][b], __ATOMIC_RELAXED);
+		if(sum > target)
+			break;
+	}
+	if(b >= statBuckets)
+		b = statBuckets - 1;
+	return bucketUS(stats, b);
+}
+
+double mixstats_max(mixStats *stats, unsigned int stage){
+	return __atomic_load_n(&stats->max[stage], __ATOMIC_RELAXED) / stats->ticksPerUS;
+}
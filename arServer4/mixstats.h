@@ -0,0 +1,140 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+#ifndef _MIXSTATS_H
+#define _MIXSTATS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+
+/* Render thread timing instrumentation.  process() time stamps the 
+ * boundaries of each of its stages with a cheap cycle counter and counts 
+ * each stage's duration into a histogram.  The render thread is the only 
+ * writer; app threads read the histograms without locking, and may see a 
+ * cycle's counts part way through being updated.  xruns reported by JACK 
+ * are logged with the stage times of the last complete cycle. */
+
+enum{
+	stage_decode = 0,	// control packet decode and command queue
+	stage_control,		// input control: events, gains and the active list
+	stage_mix,			// input mixing and input meters
+	stage_status,		// connection status and position
+	stage_mixMinus,		// mix-minus distribution
+	stage_outGroups,	// output groups
+	stage_busOut,		// bus outputs
+	stage_meters,		// bus meters
+	stage_cycle,		// the whole process() call
+	stageCount
+};
+
+#define statBuckets		496		// 8 per octave, over 64 bit tick counts
+#define xrunLogSize		16
+
+typedef struct{
+	struct timeval when;		// wall time the xrun was reported
+	uint64_t frameClock;		// mix engine frame clock at the time
+	uint64_t lastTicks[stageCount];	// stage times of the cycle before
+} xrunRecord;
+
+typedef struct mixStats{
+	double ticksPerUS;		// counter ticks per micro second, calibrated at init
+	uint32_t hist[stageCount][statBuckets];
+	uint64_t max[stageCount];
+	uint64_t last[stageCount];	// atomic: the previous complete cycle's stage times
+	uint64_t cur[stageCount];	// render thread only: this cycle's stage times
+	uint32_t resetReq;		// atomic: set by app threads to clear the histograms
+	uint32_t xrunCount;		// atomic: total xruns; the log holds the last xrunLogSize
+	xrunRecord xruns[xrunLogSize];
+} mixStats;
+
+extern const char *mixstats_stageName[stageCount];
+
+static inline uint64_t mixstats_now(void){
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+static inline unsigned int mixstats_bucket(uint64_t ticks){
+	unsigned int octave;
+	
+	if(ticks < 8)
+		return ticks;
+	octave = 63 - __builtin_clzll(ticks);
+	return ((octave - 2) * 8) + ((ticks >> (octave - 3)) & 7);
+}
+
+/* Render thread: count the time since *mark into stage, and move *mark 
+ * up to now */
+static inline void mixstats_mark(mixStats *stats, unsigned int stage, uint64_t *mark){
+	uint64_t now, ticks;
+	unsigned int b;
+	
+	now = mixstats_now();
+	ticks = now - *mark;
+	*mark = now;
+	stats->cur[stage] += ticks;
+	b = mixstats_bucket(ticks);
+	__atomic_store_n(&stats->hist[stage][b], stats->hist[stage][b] + 1, __ATOMIC_RELAXED);
+	if(ticks > stats->max[stage])
+		__atomic_store_n(&stats->max[stage], ticks, __ATOMIC_RELAXED);
+}
+
+/* Allocate and calibrate a stats record.  Returns NULL on failure. */
+mixStats *mixstats_create(void);
+
+void mixstats_free(mixStats *stats);
+
+/* Render thread: start a cycle, clearing the histograms first if asked */
+void mixstats_begin(mixStats *stats);
+
+/* Render thread: end a cycle, publishing its stage times for xrun logging */
+void mixstats_end(mixStats *stats);
+
+/* JACK xrun callback thread: log an xrun */
+void mixstats_xrun(mixStats *stats, uint64_t frameClock);
+
+/* App threads: ask the render thread to clear the histograms */
+void mixstats_reset(mixStats *stats);
+
+/* App threads: the duration, in micro seconds, below which the fraction 
+ * (0.0 to 1.0) of a stage's counted durations fall.  Returns a negative 
+ * value if nothing has been counted. */
+double mixstats_percentile(mixStats *stats, unsigned int stage, double fraction);
+
+/* App threads: a stage's longest duration, in micro seconds */
+double mixstats_max(mixStats *stats, unsigned int stage);
+
+/* App threads: the number of durations counted for a stage */
+uint64_t mixstats_count(mixStats *stats, unsigned int stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
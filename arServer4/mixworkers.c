@@ -0,0 +1,239 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "mixworkers.h"
+
+/* times a worker polls for the next job before going to sleep */
+#define mixWorkerSpins	4000
+
+static inline void cpuRelax(void){
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+static void futexWait(uint32_t *addr, uint32_t val){
+	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static void futexWakeAll(uint32_t *addr){
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static unsigned char mixNextItem(mixWorkerPool *pool, jack_default_audio_sample_t *partial, 
+										size_t stride, busSet *written){
+	uint64_t claim;
+	uint32_t index, count;
+	
+	claim = __atomic_fetch_add(&pool->claim, 1, __ATOMIC_ACQ_REL);
+	index = claim & 0xffffffff;
+	count = (claim >> 32) & 0xffff;
+	if(index >= count)
+		return 0;
+	/* the render thread waits for this item before starting a new cycle, 
+	 * so the list and nframes are still this item's */
+	pool->engine->mixInputProc(pool->engine, &pool->engine->ins[pool->list[index]], pool->nframes, 
+										partial, stride, written);
+	__atomic_add_fetch(&pool->done, 1, __ATOMIC_RELEASE);
+	return 1;
+}
+
+static void *mixWorkerThread(void *refCon){
+	mixWorker *worker = (mixWorker *)refCon;
+	mixWorkerPool *pool = worker->pool;
+	uint32_t seq;
+	unsigned int spin;
+	
+	seq = __atomic_load_n(&pool->wakeSeq, __ATOMIC_ACQUIRE);
+	while(__atomic_load_n(&pool->run, __ATOMIC_ACQUIRE)){
+		while(mixNextItem(pool, worker->partial, pool->maxFrames, &worker->written));
+		
+		/* wait for the next job: poll for a while, then sleep */
+		for(spin=0; spin<mixWorkerSpins; spin++){
+			if(__atomic_load_n(&pool->wakeSeq, __ATOMIC_ACQUIRE) != seq)
+				break;
+			cpuRelax();
+		}
+		if(spin == mixWorkerSpins){
+			__atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+			/* re-check after counting ourselves as a sleeper, so a wake up 
+			 * between the poll and the wait isn't missed */
+			if(__atomic_load_n(&pool->wakeSeq, __ATOMIC_SEQ_CST) == seq)
+				futexWait(&pool->wakeSeq, seq);
+			__atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+		}
+		seq = __atomic_load_n(&pool->wakeSeq, __ATOMIC_ACQUIRE);
+	}
+	return NULL;
+}
+
+unsigned char mixworkers_run(mixWorkerPool *pool, const unsigned int *list, 
+				unsigned int count, jack_nframes_t nframes, busSet *written){
+	unsigned int w, i, b, c, ccount, bcount;
+	mixWorker *worker;
+	jack_default_audio_sample_t *partial;
+	mixbuffer_t *mb;
+	
+	if((nframes > pool->maxFrames) || (count > 0xffff))
+		return 0;
+	
+	/* publish the job */
+	pool->list = list;
+	pool->nframes = nframes;
+	pool->seq++;
+	__atomic_store_n(&pool->done, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&pool->claim, ((uint64_t)(pool->seq & 0xffff) << 48) | ((uint64_t)count << 32), __ATOMIC_RELEASE);
+	__atomic_store_n(&pool->wakeSeq, pool->seq, __ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST))
+		futexWakeAll(&pool->wakeSeq);
+	
+	/* do our share, directly into the mixbus ring-buffers */
+	while(mixNextItem(pool, NULL, 0, written));
+	
+	/* wait for the items still being mixed by workers */
+	while(__atomic_load_n(&pool->done, __ATOMIC_ACQUIRE) < count)
+		cpuRelax();
+	
+	/* sum the worker partial buses into the ring-buffers */
+	mb = pool->engine->mixbuses;
+	ccount = pool->engine->chanCount;
+	bcount = pool->engine->busCount;
+	worker = pool->workers;
+	for(w=0; w<pool->count; w++){
+		if(busset_any(&worker->written)){
+			for(b = busset_next(&worker->written, 0); b < bcount; b = busset_next(&worker->written, b + 1)){
+				partial = worker->partial + (pool->maxFrames * ccount * b);
+				for(c=0; c<ccount; c++){
+					if(busset_has(written, b))
+						mixbuffer_sum(mb, nframes, partial, c, b, 0);
+					else
+						mixbuffer_write(mb, nframes, partial, 1.0, c, b);
+					partial = partial + pool->maxFrames;
+				}
+			}
+			for(i=0; i<busSetWords; i++)
+				written->w[i] = written->w[i] | worker->written.w[i];
+			busset_zero(&worker->written);
+		}
+		worker++;
+	}
+	return 1;
+}
+
+const char *mixworkers_init(mixEngineRecPtr mixEngineRef, unsigned int count, jack_nframes_t maxFrames){
+	mixWorkerPool *pool;
+	mixWorker *worker;
+	unsigned int w;
+	int cpus;
+	cpu_set_t cpuset;
+	
+	if(!count || !maxFrames)
+		return "no worker threads or no frames requested";
+	if((pool = (mixWorkerPool *)calloc(1, sizeof(mixWorkerPool))) == NULL)
+		return "memory allocation for mix worker pool failed";
+	mlock(pool, sizeof(mixWorkerPool));
+	pool->engine = mixEngineRef;
+	pool->count = count;
+	pool->maxFrames = maxFrames;
+	pool->run = 1;
+	if((pool->workers = (mixWorker *)calloc(count, sizeof(mixWorker))) == NULL){
+		mixworkers_free(pool);
+		return "memory allocation for mix workers failed";
+	}
+	mlock(pool->workers, sizeof(mixWorker) * count);
+	
+	pool->partialSize = sizeof(jack_default_audio_sample_t) * maxFrames 
+								* mixEngineRef->chanCount * mixEngineRef->busCount;
+	worker = pool->workers;
+	for(w=0; w<count; w++){
+		worker->pool = pool;
+		worker->number = w;
+		if(posix_memalign((void **)&worker->partial, 64, pool->partialSize)){
+			worker->partial = NULL;
+			mixworkers_free(pool);
+			return "memory allocation for mix worker partial buses failed";
+		}
+		mlock(worker->partial, pool->partialSize);
+		worker++;
+	}
+	
+	/* start the threads at the JACK real-time priority, one per core, 
+	 * leaving the first core for the JACK thread and interupts */
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	worker = pool->workers;
+	for(w=0; w<count; w++){
+		if(jack_client_create_thread(mixEngineRef->client, &worker->thread, 
+					jack_client_real_time_priority(mixEngineRef->client), 
+					jack_is_realtime(mixEngineRef->client), mixWorkerThread, worker)){
+			mixworkers_free(pool);
+			return "failed to create mix worker thread";
+		}
+		worker->started = 1;
+		if(cpus > 1){
+			CPU_ZERO(&cpuset);
+			CPU_SET((w + 1) % cpus, &cpuset);
+			pthread_setaffinity_np(worker->thread, sizeof(cpu_set_t), &cpuset);
+		}
+		worker++;
+	}
+	
+	/* hand the pool to the render thread */
+	__atomic_store_n(&mixEngineRef->workers, pool, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+void mixworkers_free(mixWorkerPool *pool){
+	unsigned int w;
+	mixWorker *worker;
+	
+	if(pool == NULL)
+		return;
+	if(pool->engine->workers == pool)
+		pool->engine->workers = NULL;
+	if(pool->workers){
+		/* tell the threads to quit, and wake them */
+		__atomic_store_n(&pool->run, 0, __ATOMIC_RELEASE);
+		__atomic_add_fetch(&pool->wakeSeq, 1, __ATOMIC_SEQ_CST);
+		futexWakeAll(&pool->wakeSeq);
+		worker = pool->workers;
+		for(w=0; w<pool->count; w++){
+			if(worker->started)
+				jack_client_stop_thread(pool->engine->client, worker->thread);
+			if(worker->partial){
+				munlock(worker->partial, pool->partialSize);
+				free(worker->partial);
+			}
+			worker++;
+		}
+		munlock(pool->workers, sizeof(mixWorker) * pool->count);
+		free(pool->workers);
+	}
+	munlock(pool, sizeof(mixWorkerPool));
+	free(pool);
+}
@@ -0,0 +1,90 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _MIXWORKERS_H
+#define _MIXWORKERS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <jack/jack.h>
+
+#include "mix_engine.h"
+
+/* Optional pool of threads to share the per-input mixing work of the
+ * render thread.  Each cycle, the render thread publishes the list of
+ * active inputs; the workers and the render thread claim inputs from it
+ * one at a time.  Workers mix into their own partial bus accumulators,
+ * which the render thread then sums into the mixbus ring-buffers.  No
+ * locks are taken: inputs are claimed with an atomic counter, and idle
+ * workers sleep on a futex. */
+
+typedef struct mixWorker{
+	struct mixWorkerPool *pool;
+	jack_native_thread_t thread;
+	unsigned int number;
+	unsigned char started;
+	jack_default_audio_sample_t *partial;	// busCount * chanCount array of maxFrames sample buffers
+	busSet written;			// the partial buses written to this cycle
+} mixWorker;
+
+typedef struct mixWorkerPool{
+	mixEngineRecPtr engine;
+	unsigned int count;
+	jack_nframes_t maxFrames;
+	size_t partialSize;
+	mixWorker *workers;
+	
+	/* current cycle's job, set by the render thread */
+	const unsigned int *list;
+	jack_nframes_t nframes;
+	uint32_t seq;
+	
+	uint64_t claim;		// atomic: sequence << 48 | list count << 32 | next list index
+	uint32_t done;		// atomic: list items mixed this cycle
+	uint32_t wakeSeq;	// atomic futex word: changes when there is a new job
+	uint32_t sleepers;	// atomic: workers waiting on wakeSeq
+	uint32_t run;		// atomic: zero to tell the workers to quit
+} mixWorkerPool;
+
+/* Start count worker threads for the mix engine, with partial bus 
+ * accumulators big enough for maxFrames per cycle.  Returns an error 
+ * string on failure, NULL on success. */
+const char *mixworkers_init(mixEngineRecPtr mixEngineRef, unsigned int count, jack_nframes_t maxFrames);
+
+/* Render thread: mix the count inputs in list, with the help of the 
+ * workers.  written is as for mixInput().  Returns zero, having done 
+ * nothing, if the pool can not handle this cycle; the caller must then 
+ * mix the list itself. */
+unsigned char mixworkers_run(mixWorkerPool *pool, const unsigned int *list, 
+				unsigned int count, jack_nframes_t nframes, busSet *written);
+
+/* Stop the worker threads and free the pool.  The render thread must 
+ * not be running. */
+void mixworkers_free(mixWorkerPool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,6 +22,8 @@
 #include "tasks.h"
 #include "database.h"
 #include "automate.h"
+#include "mixstats.h"
+#include "sessionio.h"
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
@@ -36,10 +38,6 @@
 #include <gst/pbutils/pbutils.h>
 
 short listenSocket;
-pthread_mutex_t sMutex;
-ctl_session *sessionList;
-pthread_t listen_thread;
-unsigned int sessionListSize;
 const char *constPrompt = "ars>";
 
 // local function prototypes
@@ -58,6 +56,7 @@ unsigned char handle_play(ctl_session *session);
 unsigned char handle_stop(ctl_session *session);
 unsigned char handle_pstat(ctl_session *session);
 unsigned char handle_meters(ctl_session *session);
+unsigned char handle_mixstats(ctl_session *session);
 unsigned char handle_fade(ctl_session *session);
 unsigned char handle_vol(ctl_session *session);
 unsigned char handle_sender(ctl_session *session);
@@ -96,6 +95,9 @@ unsigned char handle_saveout(ctl_session *session);
 unsigned char handle_dumpout(ctl_session *session);
 unsigned char handle_outvol(ctl_session *session);
 unsigned char handle_outbus(ctl_session *session);
+unsigned char handle_busfeed(ctl_session *session);
+unsigned char handle_outdsp(ctl_session *session);
+unsigned char handle_busdsp(ctl_session *session);
 unsigned char handle_setdly(ctl_session *session);
 unsigned char handle_getdly(ctl_session *session);
 unsigned char handle_dump(void);
@@ -155,12 +157,14 @@ uint32_t getSenderID(void){
 	
 	sender = 0;
 	thisThread = pthread_self();
+	pthread_mutex_lock(&sMutex);
 	for(i=0; i<sessionListSize;i++){
-		if(pthread_equal(sessionList[i].sessionThread, thisThread))
+		if(sessionList[i] && pthread_equal(sessionList[i]->sessionThread, thisThread)){
+			sender = sessionList[i]->sender;
 			break;
+		}
 	}
-	if(i < sessionListSize)
-		sender = sessionList[i].sender;
+	pthread_mutex_unlock(&sMutex);
 	/* convert to network byte order */
 	return htonl(sender);
 }
@@ -186,14 +190,15 @@ int noticeSend(const char *buf, int tx_length, unsigned char isVU){
 
 	count = 0;
 	// send to all registered for noticies
+	pthread_mutex_lock(&sMutex);
 	for(i=0; i<sessionListSize;i++){
-		recPtr = &sessionList[i];
-		if(recPtr->cs){
+		if(recPtr = sessionList[i]){
 			if((!isVU && recPtr->use_tcp) || (isVU && recPtr->notify_meters))
-				// set the non-block flag, so the send is skipped if there isn't room in the send buffer.
-				count = my_send(recPtr, buf, tx_length, 0, MSG_DONTWAIT);
+				// buffered without waiting: dropped if the client is too far behind
+				count = sessionio_notice(recPtr, buf, tx_length);
 		}
 	}
+	pthread_mutex_unlock(&sMutex);
 	return count;
 }
 
@@ -201,11 +206,20 @@ int my_send(ctl_session *session, const char *buf, int tx_length, unsigned char
 	int count = 0;
 
 	if(!silent){
-		if(session->cs == 0){
+		if(session->extFD > 0){
+			// handle_external is running: output goes to the external program
+			count = send(session->extFD, buf, tx_length, flags);
+			return count;
+		}
+		else if(session->cs == 0){
 			count = fprintf(stdout, "%s", buf);
 			fflush(stdout);
 			return count;
 		}
+		else if(session->conn){
+			count = sessionio_send(session, buf, tx_length);
+			return count;
+		}
 		else if(session->cs > 0){
 			count = send(session->cs, buf, tx_length, flags);
 			return count;
@@ -214,13 +228,6 @@ int my_send(ctl_session *session, const char *buf, int tx_length, unsigned char
 	return 0;
 }
 
-int my_recv(ctl_session *session, char *buf, int buf_length){
-	if(session->cs > 0){
-		return recv(session->cs, buf, buf_length, 0);
-	}
-	return -1;
-}
-
 unsigned char processCommand(ctl_session *session, char *command, unsigned char *passResult){
 	char buf[256]; /* send data buffer */
 	int tx_length;
@@ -242,16 +249,8 @@ unsigned char processCommand(ctl_session *session, char *command, unsigned char
 	if(!strcmp(arg, "close")){
 		// first parameter, connection number is in save_pointer
 		i = atoi(session->save_pointer) - 1;
-		// cancel the specified TCP thread
-		if((i >= 0) && (i < sessionListSize)){
-			pthread_mutex_lock(&sMutex);
-			if(sessionList[i].cs > 0){
-				shutdown(sessionList[i].cs, SHUT_RDWR); 
-				close(sessionList[i].cs);
-				/* just incase the thread has become cancelable */
-				pthread_cancel(sessionList[i].sessionThread);
-			}
-			pthread_mutex_unlock(&sMutex);
+		// close the specified TCP session, once any command it is running returns
+		if((i >= 0) && sessionio_close(i)){
 			result = rOK;
 		}else{
 			session->errMSG = "bad client number.\n";
@@ -335,6 +334,10 @@ unsigned char processCommand(ctl_session *session, char *command, unsigned char
 		result = handle_meters(session);
 		goto finish;
 	}
+	if(!strcmp(arg, "mixstats")) {
+		result = handle_mixstats(session);
+		goto finish;
+	}
 	if(!strcmp(arg, "fade")) {
 		result = handle_fade(session);
 		goto finish;
@@ -499,6 +502,18 @@ unsigned char processCommand(ctl_session *session, char *command, unsigned char
 		result = handle_outbus(session);
 		goto finish;
 	}
+	if (!strcmp(arg, "busfeed")) {
+		result = handle_busfeed(session);
+		goto finish;
+	}
+	if (!strcmp(arg, "outdsp")) {
+		result = handle_outdsp(session);
+		goto finish;
+	}
+	if (!strcmp(arg, "busdsp")) {
+		result = handle_busdsp(session);
+		goto finish;
+	}
 	if (!strcmp(arg, "setdly")) {
 		result = handle_setdly(session);
 		goto finish;
@@ -960,186 +975,88 @@ unsigned char loadConfiguration(ctl_session *session, char *file_path){
 	return 1;
 }
 
-void* sessionThread(ctl_session *session){
-	char command[4096]; /* receive data buffer */
-	char block[1024]; /* receive data buffer */
-	char *fragment, *save_pointer;
-	int rx_length, tx_length;
-	int i, old;
-	ctl_session *recPtr;
-	
-	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
-	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+void sessionWelcome(ctl_session *session){
+	char line[256];
+	int tx_length;
 	
+	session->silent = 0;
 	// display version
-	tx_length = snprintf(command, sizeof command, "AudioRack Server, version %s\n", versionStr);
-
-	if(my_send(session, command, tx_length, 0, 0) < 0) goto finish;
-	tx_length = snprintf(command, sizeof command, "Copyright (C) %s\n\n", versionCR);
-	if(my_send(session, command, tx_length, 0, 0) < 0)goto finish;
-	tx_length = snprintf(command, sizeof command, "AudioRack Server comes with ABSOLUTELY NO WARRANTY; for details\n");
-	if(my_send(session, command, tx_length, 0, 0) < 0) goto finish;
-	tx_length = snprintf(command, sizeof command, "type `info'.  This is free software, and you are welcome\n");
-	if(my_send(session, command, tx_length, 0, 0) < 0) goto finish;
-	tx_length = snprintf(command, sizeof command, "to redistribute it under certain conditions; See the\n");
-	if(my_send(session, command, tx_length, 0, 0) < 0) goto finish;
-	tx_length = snprintf(command, sizeof command, "GNU General Public License included with this program for details.\n\n");
-	if(my_send(session, command, tx_length, 0, 0) < 0) goto finish;
-	tx_length = snprintf(command, sizeof command, "==================================================================\n");
-	if(my_send(session, command, tx_length, 0, 0) < 0) goto finish;
+	tx_length = snprintf(line, sizeof line, "AudioRack Server, version %s\n", versionStr);
+	my_send(session, line, tx_length, 0, 0);
+	tx_length = snprintf(line, sizeof line, "Copyright (C) %s\n\n", versionCR);
+	my_send(session, line, tx_length, 0, 0);
+	tx_length = snprintf(line, sizeof line, "AudioRack Server comes with ABSOLUTELY NO WARRANTY; for details\n");
+	my_send(session, line, tx_length, 0, 0);
+	tx_length = snprintf(line, sizeof line, "type `info'.  This is free software, and you are welcome\n");
+	my_send(session, line, tx_length, 0, 0);
+	tx_length = snprintf(line, sizeof line, "to redistribute it under certain conditions; See the\n");
+	my_send(session, line, tx_length, 0, 0);
+	tx_length = snprintf(line, sizeof line, "GNU General Public License included with this program for details.\n\n");
+	my_send(session, line, tx_length, 0, 0);
+	tx_length = snprintf(line, sizeof line, "==================================================================\n");
+	my_send(session, line, tx_length, 0, 0);
 
 	// send prompt
 	tx_length = strlen(constPrompt);
-	if(my_send(session, constPrompt, tx_length, 0, 0) < 0) goto finish;
-	*command = 0;
-	
-	// wait for a client command to arrive
-	rx_length = my_recv(session, block, sizeof(block) - 1);
-	if(rx_length >= 0)
-		block[rx_length] = 0; // null at end of segment to make it a c-string
-	else 
-		block[0] = 0;
-	
-	session->silent = 0;
-	while(rx_length > 0){
-		// "\n" is our command delimitor, but we need to handle \r too.
-		save_pointer = block;
-		while(fragment = strpbrk(save_pointer, "\n\r")){
-			// replace found /n or /r with null string termination
-			*fragment = 0;
-			strncat(command, save_pointer, sizeof(command) - (strlen(command) + 1));
-			char nxt = *(fragment+1);
-			// It's possible that a /r/n set will be broken across a recvd block, and
-			// then we wont catch is as a pair.  Oh well.  Not likely, and would
-			// only result in a double prompt being sent the client.
-			if((nxt == '\n') || (nxt == '\r'))
-				// next char is also a \r or \n... move past it too
-				save_pointer = fragment+2;
-			else
-				// next char is not a \r or \n... just move past the first one
-				save_pointer = fragment+1;
+	my_send(session, constPrompt, tx_length, 0, 0);
+}
 
-			if(strlen(command)){
-				if(processCommand(session, command, NULL))
-					goto finish;
-			}else{
-				// send \n
-				if(my_send(session, "\n", 1, 0, 0) < 0) 
-					goto finish;
-			}
-			// send prompt
-			tx_length = strlen(constPrompt);
-			if(my_send(session, constPrompt, tx_length, 0, 0) < 0) 
-				goto finish;
-			*command = 0;
-		}
-		// no delimitor left in the string... save whats left, the delimitor my show up in the next round
-		if(strlen(save_pointer))
-			strncat(command, save_pointer, sizeof(command) - (strlen(command) + 1));
-		// wait for a client command to arrive
-		rx_length = my_recv(session, block, sizeof(block) - 1);
-		if(rx_length >= 0)
-			block[rx_length] = 0; // null at end of segment to make it a c-string
+unsigned char sessionInput(ctl_session *session, char *block){
+	char *command = session->conn->command;
+	size_t size = sizeof(session->conn->command);
+	char *fragment, *save_pointer;
+	int tx_length;
+	
+	// "\n" is our command delimitor, but we need to handle \r too.
+	save_pointer = block;
+	while(fragment = strpbrk(save_pointer, "\n\r")){
+		// replace found /n or /r with null string termination
+		*fragment = 0;
+		strncat(command, save_pointer, size - (strlen(command) + 1));
+		char nxt = *(fragment+1);
+		// It's possible that a /r/n set will be broken across a recvd block, and
+		// then we wont catch is as a pair.  Oh well.  Not likely, and would
+		// only result in a double prompt being sent the client.
+		if((nxt == '\n') || (nxt == '\r'))
+			// next char is also a \r or \n... move past it too
+			save_pointer = fragment+2;
 		else
-			block[0] = 0;
-	}
-finish:
-	pthread_mutex_lock(&sMutex);
-	if(session->cs > 0){
-		shutdown(session->cs, SHUT_RDWR);
-		close(session->cs); /* close client socket connection */
-	}
-	session->cs = 0;
-	session->sessionThread = 0;
-	pthread_mutex_unlock(&sMutex);
+			// next char is not a \r or \n... just move past the first one
+			save_pointer = fragment+1;
 
-	if(GetMetaInt(0,"sys_autoexit", NULL)){
-		// check for auto exit on loss of last control connection
-		pthread_mutex_lock(&sMutex);
-		recPtr = &sessionList[i];
-		for(i=0; i<sessionListSize; i++){
-				if(recPtr->cs)
-					break;
-				recPtr++;
-		}
-		pthread_mutex_unlock(&sMutex);
-		if(i == sessionListSize){
-			restart = 0;
-			quit = 1;
-		}
-	}
-	return NULL;
-}
-
-void* TCPListener(void *refCon){
-	ctl_session *recPtr;
-	socklen_t namelen; /* length of client name */
-	int ns; /* client socket */
-	int i;
-	struct sockaddr_in6 client; /* client address information */
-
-	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
-	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-
-	/* when listenSocket is closed, ns will be negative (error),
-	 * and function loop will exit */
-	do{
-		namelen = sizeof(client); 
-		ns = accept(listenSocket, (struct sockaddr *)&client, &namelen); /* wait for connection request */
-		if(ns > 0) {
-			// Set new socket options -- keep-alive for broken connection detection
-			int trueval = 1;
-			setsockopt(ns, SOL_SOCKET, SO_KEEPALIVE, &trueval, sizeof(trueval)); // if this fails, not much can be done
-			pthread_mutex_lock(&sMutex);
-			for(i=0; i<sessionListSize;i++){
-				recPtr = &sessionList[i];
-				if(recPtr->cs == 0){
-					recPtr->cs = ns;
-					recPtr->client = client;
-					recPtr->use_tcp = 0;
-					recPtr->notify_meters = 0;
-					recPtr->sender = 0;
-					recPtr->lastUID = 0;
-					recPtr->lastPlayer = -1;
-					recPtr->lastAID = 0;
-					pthread_create(&recPtr->sessionThread, NULL, (void*(*)(void*))&sessionThread, recPtr);
-					pthread_detach(recPtr->sessionThread);
-					break;
-				}
-			}
-			pthread_mutex_unlock(&sMutex);
-			
-			if(i == sessionListSize){
-				serverLogMakeEntry("[session] TCPListener-new connections: requests exceed max number of allowed connections");
-				send( ns, "maximum number of connection exceeded. Try again later.\n", 57, 0);
-				close(ns);
-			}
+		if(strlen(command)){
+			if(processCommand(session, command, NULL))
+				return 1;
+		}else{
+			// send \n
+			if(my_send(session, "\n", 1, 0, 0) < 0) 
+				return 1;
 		}
-	}while(ns > 0);
-	return NULL;
+		// send prompt
+		tx_length = strlen(constPrompt);
+		if(my_send(session, constPrompt, tx_length, 0, 0) < 0) 
+			return 1;
+		*command = 0;
+	}
+	// no delimitor left in the string... save whats left, the delimitor my show up in the next round
+	if(strlen(save_pointer))
+		strncat(command, save_pointer, size - (strlen(command) + 1));
+	return 0;
 }
 
 char *initSessions(unsigned int maxSessions, short *tcpPort){
 	short s;
 	struct sockaddr_in6 server; /* server address information */
 	socklen_t namelen; /* length of client name */
+	struct rlimit rl;
+	char *err;
 	int trueVal = 1;
 	
-	/* create a session list mutex */
-	pthread_mutex_init(&sMutex, NULL);  
-
-	listen_thread = 0;
 	listenSocket = -1;
-	sessionList = (ctl_session *)calloc(maxSessions, sizeof(ctl_session));
-	if(sessionList == NULL)
-		return "failed to allocate memory for session list.";
-	sessionListSize = maxSessions;
 	
 	s = socket(AF_INET6, SOCK_STREAM, 0); /* create stream socket using TCP */
-	if(s == -1) {
-		free(sessionList);
+	if(s == -1)
 		return "TCP listen socket creation failed";
-	}
 
 	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &trueVal, sizeof(trueVal));
 	memset(&server, 0, sizeof(server));
@@ -1148,7 +1065,6 @@ char *initSessions(unsigned int maxSessions, short *tcpPort){
 	server.sin6_addr = in6addr_any;
 
 	if(bind(s, (struct sockaddr *) &server, sizeof( server )) < 0 ) { /* bind server address to socket */
-		free(sessionList);
 		close(s);
 		return  "bind() Error binding server to port. arServer maybe already running.";
 	}
@@ -1156,61 +1072,41 @@ char *initSessions(unsigned int maxSessions, short *tcpPort){
 	/* find out what port was assigned */
 	namelen = sizeof(server);
 	if(getsockname(s, (struct sockaddr*) &server, &namelen) < 0 ) {
-		free(sessionList);
 		close(s);
 		return "getsockname() failed to get port number";
 	}
 	*tcpPort = ntohs(server.sin6_port);
 
-	if(listen(s, 1) != 0 ) { /* listen for a connection */
-		free(sessionList);
+	if(listen(s, SOMAXCONN) != 0 ) { /* listen for connections */
 		close(s);
 		return "listen() failed";
 	}
+	
+	/* each session holds a descriptor: allow as many as the system will */
+	if((getrlimit(RLIMIT_NOFILE, &rl) == 0) && (rl.rlim_cur < rl.rlim_max)){
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
 
+	/* start the event loop that accepts TCP connections and 
+	 * services those sessions */
+	if(err = sessionio_start(s, maxSessions)){
+		close(s);
+		return err;
+	}
 	listenSocket = s;
-
-	/* create a listener thread to listen for TCP connection requests 
-	 * and spaun off additional threads for those sessions */
-	pthread_create(&listen_thread, NULL, &TCPListener, NULL);
 	/* sucess! */
 	return NULL;
 }
 
 void shutdownSessions(void){
-	int i;
-			
 	if(listenSocket > -1){
-		/* closing the socket will cause the the listen thread to finish */
+		/* closes all sessions, waiting for any command running to return */
+		sessionio_stop();
 		shutdown(listenSocket, SHUT_RDWR);
 		close(listenSocket); 
-	}			
-	if(sessionList){
-		for(i=0; i<sessionListSize; i++){
-			pthread_mutex_lock(&sMutex);
-			if(sessionList[i].cs > 0){
-				shutdown(sessionList[i].cs, SHUT_RDWR);
-				close(sessionList[i].cs);
-			}
-			if(sessionList[i].sessionThread){
-				/* just incase the thread has become cancelable */
-				pthread_cancel(sessionList[i].sessionThread);
-				while(sessionList[i].sessionThread){
-					pthread_mutex_unlock(&sMutex);
-					sched_yield();	// give thread time to end from cancel or socket closure
-					pthread_mutex_lock(&sMutex);
-				}
-			}
-			pthread_mutex_unlock(&sMutex);
-			
-		}			
-		free(sessionList);
+		listenSocket = -1;
 	}
-
-	if(listen_thread)
-		pthread_join(listen_thread, NULL);
-			
-	pthread_mutex_destroy(&sMutex);
 }
 
 unsigned char handle_lastuid(ctl_session *session){
@@ -1264,22 +1160,35 @@ unsigned char handle_help(ctl_session *session){
 }
 
 unsigned char handle_clients(ctl_session *session){
-	char buf[4096]; /* send data buffer */
-	char str[256];
+	char *list;
+	char str[INET6_ADDRSTRLEN];
+	size_t size;
 	int tx_length;
 
 	// list the current connected clients
-	tx_length = snprintf(buf, sizeof buf - 1, "Connected clients\n");
-	my_send(session, buf, tx_length, session->silent, 0);
+	tx_length = snprintf(str, sizeof str, "Connected clients\n");
+	my_send(session, str, tx_length, session->silent, 0);
+	
+	// the list is made under sMutex and sent after: a slow client must 
+	// not hold up the event loop, notices and other sessions
 	pthread_mutex_lock(&sMutex);
+	size = (sessionListSize * (sizeof str + 24)) + 1;
+	if((list = (char *)malloc(size)) == NULL){
+		pthread_mutex_unlock(&sMutex);
+		session->errMSG = "Memory allocation failure.\n";
+		return rError;
+	}
+	tx_length = 0;
 	for(int cn=0; cn<sessionListSize; cn++){
-		if(sessionList[cn].cs > 0){
-			if(inet_ntop(AF_INET6, &sessionList[cn].client.sin6_addr, str, sizeof(str)))
-			tx_length = snprintf(buf, sizeof buf - 1, "#%d from %s\n", cn+1, str);
-			my_send(session, buf, tx_length, session->silent, 0);
+		if(sessionList[cn]){
+			if(inet_ntop(AF_INET6, &sessionList[cn]->client.sin6_addr, str, sizeof(str)))
+				tx_length += snprintf(list + tx_length, size - tx_length, "#%d from %s\n", cn+1, str);
 		}
 	}
 	pthread_mutex_unlock( &sMutex );
+	if(tx_length)
+		my_send(session, list, tx_length, session->silent, 0);
+	free(list);
 	return rNone;
 }
 
@@ -1374,7 +1283,7 @@ unsigned char handle_attach(ctl_session *session){
 	int i, sockpair[2];
 	
 	// input error checking
-	if(session->cs == 0){
+	if((session->cs == 0) && (session->extFD <= 0)){
 		session->errMSG = "This commandcan can not be used on stdin/out connection.\n";
 		return rError;
 	}
@@ -1461,7 +1370,14 @@ unsigned char handle_attach(ctl_session *session){
 		fd_set read_fds, exc_fds;
 		struct timeval tv;
 		int h = 0;
+		int cs;
 		
+		// the client, or the external program this session is running for
+		cs = session->cs;
+		if(session->extFD > 0)
+			cs = session->extFD;
+		// may be attached indefinitely: don't hold a session worker
+		sessionio_blocking(session);
 		do{
 			/* Wait up to one second. */
 			tv.tv_sec = 1;
@@ -1471,21 +1387,21 @@ unsigned char handle_attach(ctl_session *session){
 			FD_ZERO(&exc_fds);
 			FD_SET(sockpair[1], &read_fds);
 			if(sockpair[1] > h) h = sockpair[1];
-			FD_SET(session->cs, &read_fds);
-			FD_SET(session->cs, &exc_fds);
-			if(session->cs > h) h = session->cs;
+			FD_SET(cs, &read_fds);
+			FD_SET(cs, &exc_fds);
+			if(cs > h) h = cs;
 			if(select(h+1, &read_fds, NULL, &exc_fds, &tv) > 0){
-				if(FD_ISSET(session->cs, &exc_fds))
+				if(FD_ISSET(cs, &exc_fds))
 					// control socket error (closed?) Kill attached process
 					kill(recPtr->child, 9);
 				if(FD_ISSET(sockpair[1], &read_fds)) {
 					if(i = read(sockpair[1], buff, sizeof(buff)))
-						write(session->cs, buff, i);
+						my_send(session, buff, i, 0, 0);
 				}
-				if(FD_ISSET(session->cs, &read_fds)){
-					if((i = read(session->cs, buff, sizeof(buff))) > 0)
+				if(FD_ISSET(cs, &read_fds)){
+					if((i = read(cs, buff, sizeof(buff))) > 0)
 						write(sockpair[1], buff, i);
-					else
+					else if((i == 0) || (errno != EAGAIN))
 						// control socket error (closed?) Kill attached process
 						kill(recPtr->child, 9);
 				}
@@ -1594,27 +1510,31 @@ unsigned char handle_external(ctl_session *session){
 		char command[4096];
 		struct timeval tv;
 		unsigned char was_silent;
-		int was_cs;
+		int was_fd, fd;
 		
-		was_cs = session->cs;
+		// command output goes to the program, the client still gets notices
+		fd = sockpair[1];
+		was_fd = session->extFD;
 		was_silent = session->silent;
-		session->cs = sockpair[1];
+		session->extFD = fd;
 		session->silent = 0;
+		// runs as long as the program does: don't hold a session worker
+		sessionio_blocking(session);
 		
 		// set up socket timeout for periodic polling of run status and dead child	
 		tv.tv_sec = 1;		// seconds
 		tv.tv_usec = 0;		// and microseconds
-		setsockopt(session->cs, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));	
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));	
 		
 		// send prompt
 		i = snprintf(buff, (sizeof buff) - 1, "%s", constPrompt);
 		strcat(buff, "\n");
-		send(session->cs, buff, i+1, 0);
+		send(fd, buff, i+1, 0);
 		
 		command[0] = 0;
 		while(waitpid(recPtr->child, NULL, WNOHANG) == 0){
 			// wait for a client command to arrive or a socket error
-			while((i = read(session->cs, buff, sizeof(buff)-1)) > 0){
+			while((i = read(fd, buff, sizeof(buff)-1)) > 0){
 				// null at end of segment to make it a c-string
 				buff[i] = 0;
 				// "\n" is our command delimitor
@@ -1629,7 +1549,7 @@ unsigned char handle_external(ctl_session *session){
 					// send prompt
 					i = snprintf(command, (sizeof command) - 1, "%s", constPrompt);
 					strcat(command, "\n");
-					send(session->cs, command, i+1, 0);
+					send(fd, command, i+1, 0);
 					*command = 0;
 				}
 				// no delimitor left in the string... save whats left, the delimitor my show up in the next round
@@ -1647,7 +1567,7 @@ unsigned char handle_external(ctl_session *session){
 		free(recPtr->argv);
 		free(recPtr);
 		// restore session setting
-		session->cs = was_cs;
+		session->extFD = was_fd;
 		session->silent = was_silent;
 		return rOK;
 	}
@@ -1671,8 +1591,7 @@ unsigned char handle_play(ctl_session *session){
 			return rError;            
 		}
 		session->lastPlayer = aInt;
-		instance = &mixEngine->ins[aInt];
-		instance->requested = instance->requested | change_play;
+		sendMixCommand(mixEngine, cmd_inPlay, aInt, 0, 0.0);
 		return rOK;
 	}
 	session->errMSG = "Missing parameter player number.\n";
@@ -1692,7 +1611,7 @@ unsigned char handle_tbon(ctl_session *session){
 			session->errMSG = "Bad talkback number.\n";
 			return rError;            
 		}
-		mixEngine->reqTalkBackBits = mixEngine->reqTalkBackBits | (1<<aInt);
+		sendMixCommand(mixEngine, cmd_talkbackOn, 0, 1<<aInt, 0.0);
 		return rOK;
 	}
 	session->errMSG = "Missing parameter talkback number.\n";
@@ -1712,7 +1631,7 @@ unsigned char handle_tboff(ctl_session *session){
 			session->errMSG = "Bad talkback number.\n";
 			return rError;            
 		}
-		mixEngine->reqTalkBackBits = mixEngine->reqTalkBackBits & ~(1<<aInt);
+		sendMixCommand(mixEngine, cmd_talkbackOff, 0, 1<<aInt, 0.0);
 		return rOK;
 	}
 	session->errMSG = "Missing parameter talkback number.\n";
@@ -1736,8 +1655,7 @@ unsigned char handle_stop(ctl_session *session){
 			return rError;            
 		}
 		session->lastPlayer = aInt;
-		instance = &mixEngine->ins[aInt];
-		instance->requested = instance->requested | change_stop;
+		sendMixCommand(mixEngine, cmd_inStop, aInt, 0, 0.0);
 		return rOK;
 	}
 	session->errMSG = "Missing parameter player number.\n";
@@ -1827,6 +1745,86 @@ unsigned char handle_meters(ctl_session *session){
 	return rNone;
 }
 
+unsigned char handle_mixstats(ctl_session *session){
+	char buf[4096]; /* send data buffer */
+	int tx_length;
+	unsigned int i, s, count, worst;
+	char *param;
+	mixStats *stats;
+	xrunRecord *rec;
+	struct tm tm;
+
+	stats = mixEngine->stats;
+	// optional parameter, reset
+	param = strtok_r(NULL, " ", &session->save_pointer);
+	if(param != NULL){
+		if(strcmp(param, "reset")){
+			session->errMSG = "Unknown mixstats option.\n";
+			return rError;
+		}
+		mixstats_reset(stats);
+		__atomic_store_n(&mixEngine->ctlOutStats.high, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&mixEngine->ctlOutStats.sent, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&mixEngine->ctlOutStats.deferred, 0, __ATOMIC_RELAXED);
+		pthread_mutex_lock(&mixEngine->ctlOutQueueMutex);
+		mixEngine->ctlOutDropped = 0;
+		pthread_mutex_unlock(&mixEngine->ctlOutQueueMutex);
+		__atomic_store_n(&notifyStats.high, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&notifyStats.sent, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&notifyStats.dropped, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&notifyStats.oversize, 0, __ATOMIC_RELAXED);
+		return rOK;
+	}
+	
+	tx_length = snprintf(buf, sizeof buf, "stage\tcount\tp50\tp99\tmax (us)\n");
+	my_send(session, buf, tx_length, session->silent, 0);
+	for(s=0; s<stageCount; s++){
+		tx_length = snprintf(buf, sizeof buf, "%s\t%lu\t%.1f\t%.1f\t%.1f\n", 
+				mixstats_stageName[s], (unsigned long)mixstats_count(stats, s), 
+				mixstats_percentile(stats, s, 0.5), mixstats_percentile(stats, s, 0.99), 
+				mixstats_max(stats, s));
+		my_send(session, buf, tx_length, session->silent, 0);
+	}
+	
+	pthread_mutex_lock(&mixEngine->ctlOutQueueMutex);
+	count = mixEngine->ctlOutDropped;
+	pthread_mutex_unlock(&mixEngine->ctlOutQueueMutex);
+	tx_length = snprintf(buf, sizeof buf, "\ncontrol out\tqueued %lu\thigh water %u (bytes)\tsent %u\tdeferred cycles %u\tdropped %u\n", 
+			(unsigned long)jack_ringbuffer_read_space(mixEngine->ctlOutQueue), 
+			__atomic_load_n(&mixEngine->ctlOutStats.high, __ATOMIC_RELAXED), 
+			__atomic_load_n(&mixEngine->ctlOutStats.sent, __ATOMIC_RELAXED), 
+			__atomic_load_n(&mixEngine->ctlOutStats.deferred, __ATOMIC_RELAXED), count);
+	my_send(session, buf, tx_length, session->silent, 0);
+	tx_length = snprintf(buf, sizeof buf, "notices\thigh water %u\tsent %u\tdropped %u\ttoo large %u\n", 
+			__atomic_load_n(&notifyStats.high, __ATOMIC_RELAXED), 
+			__atomic_load_n(&notifyStats.sent, __ATOMIC_RELAXED), 
+			__atomic_load_n(&notifyStats.dropped, __ATOMIC_RELAXED), 
+			__atomic_load_n(&notifyStats.oversize, __ATOMIC_RELAXED));
+	my_send(session, buf, tx_length, session->silent, 0);
+	
+	count = __atomic_load_n(&stats->xrunCount, __ATOMIC_ACQUIRE);
+	tx_length = snprintf(buf, sizeof buf, "\nxruns %u\ntime\tframe\tcycle\tlongest stage (us)\n", count);
+	my_send(session, buf, tx_length, session->silent, 0);
+	i = 0;
+	if(count > xrunLogSize)
+		i = count - xrunLogSize;
+	for(; i<count; i++){
+		rec = &stats->xruns[i % xrunLogSize];
+		worst = 0;
+		for(s=1; s<stage_cycle; s++){
+			if(rec->lastTicks[s] > rec->lastTicks[worst])
+				worst = s;
+		}
+		localtime_r(&rec->when.tv_sec, &tm);
+		tx_length = snprintf(buf, sizeof buf, "%02d:%02d:%02d.%03ld\t%lu\t%.1f\t%s %.1f\n", 
+				tm.tm_hour, tm.tm_min, tm.tm_sec, (long)rec->when.tv_usec / 1000,
+				(unsigned long)rec->frameClock, rec->lastTicks[stage_cycle] / stats->ticksPerUS,
+				mixstats_stageName[worst], rec->lastTicks[worst] / stats->ticksPerUS);
+		my_send(session, buf, tx_length, session->silent, 0);
+	}
+	return rNone;
+}
+
 unsigned char handle_fade(ctl_session *session){
 	char *param;
 	uint32_t aInt;
@@ -1852,6 +1850,7 @@ unsigned char handle_fade(ctl_session *session){
 			instance = &mixEngine->ins[aInt];
 			if(instance->status & status_standby){
 				instance->fadePos = aFloat;
+				scheduleInChanEvents(mixEngine, instance, event_fade);
 				return rOK;
 			}else{
 				session->errMSG = "Specified player is empty.\n";
@@ -1895,8 +1894,7 @@ unsigned char handle_vol(ctl_session *session){
 				aFloat = atof(param);
 			session->lastPlayer = aInt;
 			if(instance->status & status_standby){
-				instance->reqVol = aFloat;
-				instance->requested = instance->requested | change_vol;
+				sendMixCommand(mixEngine, cmd_inVol, aInt, 0, aFloat);
 				return rOK;
 			}else{
 				session->errMSG = "Specified player is empty.\n";
@@ -1927,13 +1925,15 @@ unsigned char handle_sender(ctl_session *session){
 		sender = strtoul(param, &end, 16);	
 		thisThread = pthread_self();
 		
+		pthread_mutex_lock(&sMutex);
 		for(i=0; i<sessionListSize; i++){
-			if(pthread_equal(sessionList[i].sessionThread, thisThread))
+			if(sessionList[i] && pthread_equal(sessionList[i]->sessionThread, thisThread)){
+				sessionList[i]->sender = sender;
 				break;
+			}
 		}
-		if(i < sessionListSize)
-			sessionList[i].sender = sender;
-		else{
+		pthread_mutex_unlock(&sMutex);
+		if(i == sessionListSize){
 			session->errMSG = "Invalid session?\n";
 			return rError;
 		}
@@ -1992,6 +1992,7 @@ unsigned char handle_next(ctl_session *session){
 					instance->segNext = 0;
 					instance->posSeg = aFloat;
 					instance->segNext = bInt;
+					scheduleInChanEvents(mixEngine, instance, event_segue);
 					return rOK;
 				}else{
 					session->errMSG = "Specified player is empty.\n";
@@ -2007,8 +2008,12 @@ unsigned char handle_next(ctl_session *session){
 unsigned char handle_bus(ctl_session *session){
 	char *param;
 	char *end;
+	char word[9];
 	uint32_t aInt;
 	uint32_t aLong;
+	size_t len;
+	unsigned int w;
+	busSet routes;
 	inChannel *instance;
 				
 	// first parameter, input (player) number
@@ -2025,11 +2030,28 @@ unsigned char handle_bus(ctl_session *session){
 		// second parameter, output bus enable word (0 = disable, 1 = enable on bus corrisponding to bit number in word)
 		param = strtok_r(NULL, " ", &session->save_pointer);
 		if(param != NULL){
-			aLong = strtoul(param, &end, 16);
 			session->lastPlayer = aInt;
-			instance = &mixEngine->ins[aInt];
-			instance->reqBusses = (instance->reqBusses & 0xff000000) | (aLong & 0x00ffffff);
-			instance->requested = instance->requested | change_bus;
+			len = strlen(param);
+			if(len <= 8){
+				aLong = strtoul(param, &end, 16);
+				sendMixCommand(mixEngine, cmd_inBus, aInt, aLong, 0.0);
+				return rOK;
+			}
+			// more than 8 hex digits: all buses, bit n for bus n, replacing the current set
+			busset_zero(&routes);
+			for(w=0; (w<(busSetWords * 2)) && len; w++){
+				if(len > 8){
+					len = len - 8;
+					strncpy(word, param + len, 8);
+					word[8] = 0;
+				}else{
+					strncpy(word, param, len);
+					word[len] = 0;
+					len = 0;
+				}
+				busset_setWord(&routes, w, strtoul(word, &end, 16));
+			}
+			setInChanRoutes(mixEngine, aInt, &routes);
 			return rOK;
 		}
 	}
@@ -2038,8 +2060,8 @@ unsigned char handle_bus(ctl_session *session){
 }
 
 unsigned char handle_showbus(ctl_session *session){
-	char buf[16]; /* send data buffer */
-	int tx_length;
+	char buf[16 + (busSetWords * 16)]; /* send data buffer */
+	int tx_length, w;
 	char *param;
 	uint32_t aInt;
 	inChannel *instance;
@@ -2057,7 +2079,15 @@ unsigned char handle_showbus(ctl_session *session){
 		}
 		session->lastPlayer = aInt;
 		instance = &mixEngine->ins[aInt];
-		tx_length = snprintf(buf, sizeof buf, "%08x\n", instance->busses);
+		tx_length = snprintf(buf, sizeof buf, "%08x", instance->busses);
+		if(mixEngine->busCount > 24){
+			// followed by all the buses, bit n for bus n
+			tx_length += snprintf(buf + tx_length, sizeof(buf) - tx_length, " ");
+			for(w=((mixEngine->busCount + 31) / 32) - 1; w>=0; w--)
+				tx_length += snprintf(buf + tx_length, sizeof(buf) - tx_length, "%08x", 
+												busset_word(&instance->routes, w));
+		}
+		tx_length += snprintf(buf + tx_length, sizeof(buf) - tx_length, "\n");
 		my_send(session, buf, tx_length, session->silent, 0);
 		return rNone;
 	}
@@ -2088,9 +2118,7 @@ unsigned char handle_mutes(ctl_session *session){
 		if(param != NULL){
 			aLong = strtoul(param, &end, 16);
 			session->lastPlayer = aInt;
-			instance = &mixEngine->ins[aInt];
-			instance->reqBusses = (instance->reqBusses & 0x00ffffff) | (aLong & 0xff000000);
-			instance->requested = instance->requested | change_mutes;
+			sendMixCommand(mixEngine, cmd_inMutes, aInt, aLong, 0.0);
 			return rOK;
 		}
 	}
@@ -2122,12 +2150,11 @@ unsigned char handle_mmbus(ctl_session *session){
 		param = strtok_r(NULL, " ", &session->save_pointer);
 		if(param != NULL){
 			bus = atol(param);
-			bus = (bus & 0xff00003f);		// limit range to 0-32 plus upper byte
+			bus = (bus & 0xff0000ff);		// limit range to 0-255 plus upper byte
 			session->lastPlayer = aInt;
 			instance = &mixEngine->ins[aInt];
 			if(instance->status & status_standby){
-				instance->reqFeedBus = bus;
-				instance->requested = instance->requested | change_feedbus;
+				sendMixCommand(mixEngine, cmd_inFeedBus, aInt, bus, 0.0);
 				return rOK;
 			}else{
 				session->errMSG = "Specified player is empty.\n";
@@ -2164,8 +2191,7 @@ unsigned char handle_mmvol(ctl_session *session){
 			instance = &mixEngine->ins[aInt];
 			session->lastPlayer = aInt;
 			if(instance->status & status_standby){
-				instance->reqFeedVol = aFloat;
-				instance->requested = instance->requested | change_feedvol;
+				sendMixCommand(mixEngine, cmd_inFeedVol, aInt, 0, aFloat);
 				return rOK;
 			}else{
 				session->errMSG = "Specified player is empty.\n";
@@ -2205,8 +2231,7 @@ unsigned char handle_bal(ctl_session *session){
 			instance = &mixEngine->ins[aInt];
 			session->lastPlayer = aInt;
 			if(instance->status & status_standby){
-				instance->reqBal = aFloat;
-				instance->requested = instance->requested | change_bal;
+				sendMixCommand(mixEngine, cmd_inBal, aInt, 0, aFloat);
 				return rOK;
 			}else{
 				session->errMSG = "Specified player is empty.\n";
@@ -2292,8 +2317,7 @@ unsigned char handle_pos(ctl_session *session){
 			instance = &mixEngine->ins[aInt];
 			session->lastPlayer = aInt;
 			if(instance->status & status_standby){
-				instance->reqPos = aFloat;
-				instance->requested = instance->requested | change_pos;
+				sendMixCommand(mixEngine, cmd_inPos, aInt, 0, aFloat);
 				return rOK;
 			}else{
 				session->errMSG = "Specified player is empty.\n";
@@ -2307,9 +2331,8 @@ unsigned char handle_pos(ctl_session *session){
 
 unsigned char handle_unload(ctl_session *session){
 	char *param;
-	uint32_t aInt, c, cmax;
+	uint32_t aInt;
 	inChannel *instance;
-	jack_port_t **port;
 	char *xfr, *name, *type, *req, *tmp;
 	
 	// first parameter, player number
@@ -2371,14 +2394,7 @@ unsigned char handle_unload(ctl_session *session){
 			instance->persist = persistOff;
 			instance->status = status_delete;
 		}
-		port = instance->in_jPorts;
-		cmax = mixEngine->chanCount;
-		pthread_mutex_lock(&mixEngine->jackMutex);
-		for(c=0; c<cmax; c++){
-			jack_port_disconnect(mixEngine->client, *port);
-			port++;
-		}
-		pthread_mutex_unlock(&mixEngine->jackMutex);
+		unloadInChan(mixEngine, aInt);
 		return rOK;
 /*		
 		if(pLocks[aInt]->readLock(false)){
@@ -2532,6 +2548,9 @@ unsigned char handle_set(ctl_session *session){
 			// value specified... set key to new value
 			if(strcmp(key,"Version")){
 				if(SetMetaData(0, key, val)){
+					if(!strcmp(key, "ctl_out_bytes") || !strcmp(key, "ctl_out_events"))
+						setCtlOutBudget(mixEngine, GetMetaInt(0, "ctl_out_bytes", NULL), 
+											GetMetaInt(0, "ctl_out_events", NULL));
 					// send out notifications
 					notifyData	data;
 					data.reference = 0;
@@ -3024,10 +3043,8 @@ unsigned char handle_setout(ctl_session *session){
 										(!strcmp(name, instance->name))){
 									// found existing record... update
 									instance->muteLevels = mg;
-									if(instance->bus != bus){
-										instance->reqBus = bus;
-										instance->requested = instance->requested | change_bus;
-									}
+									if(instance->bus != bus)
+										sendMixCommand(mixEngine, cmd_outBus, i, bus, 0.0);
 									instance->showUI = showUI;
 									updateOutputConnections(mixEngine, instance, 1, session->save_pointer, NULL);
 
@@ -3054,11 +3071,10 @@ unsigned char handle_setout(ctl_session *session){
 								instance->name = strdup(name);
 								instance->nameHash = nameHash;
 								instance->muteLevels = mg;
-								instance->reqBus = bus;
-								instance->reqVol = 1.0;
-								instance->reqDelay = 0.0;
 								instance->showUI = showUI;
-								instance->requested = instance->requested | (change_vol | change_bus | change_delay);
+								sendMixCommand(mixEngine, cmd_outBus, firstFree, bus, 0.0);
+								sendMixCommand(mixEngine, cmd_outVol, firstFree, 0, 1.0);
+								setOutputDelay(mixEngine, firstFree, 0.0);
 
 								port = instance->jPorts;
 								max = mixEngine->chanCount;
@@ -3107,9 +3123,15 @@ unsigned char handle_saveout(ctl_session *session){
 					fprintf(fp, "setout %s %08x %d %d %s\n", instance->name, instance->muteLevels, instance->bus, instance->showUI, instance->portList);
 					if(instance->vol != 1.0)
 						fprintf(fp, "outvol %s %f\n", instance->name, instance->vol);
+					if(instance->dspSpec)
+						fprintf(fp, "outdsp %s %s\n", instance->name, instance->dspSpec);
 				}
 				instance++;
 			}
+			for(i=0; i<mixEngine->busCount; i++){
+				if(mixEngine->busDspSpecs[i])
+					fprintf(fp, "busdsp %d %s\n", i, mixEngine->busDspSpecs[i]);
+			}
 			pthread_rwlock_unlock(&mixEngine->outGrpLock);
 			free(fPath);
 			fclose(fp);
@@ -3171,8 +3193,7 @@ unsigned char handle_outvol(ctl_session *session){
 						   aFloat = 0.001;
 					}else
 						aFloat = atof(session->save_pointer);
-					instance->reqVol = aFloat;
-					instance->requested = instance->requested | change_vol;
+					sendMixCommand(mixEngine, cmd_outVol, i, 0, aFloat);
 					
 					pthread_rwlock_unlock(&mixEngine->outGrpLock);
 					free(name);
@@ -3208,8 +3229,7 @@ unsigned char handle_outbus(ctl_session *session){
 										(!strcmp(name, instance->name))){
 					// found the record... set bus
 					bus = atoi(session->save_pointer);
-					instance->reqBus = bus;
-					instance->requested = instance->requested | change_bus;
+					sendMixCommand(mixEngine, cmd_outBus, i, bus, 0.0);
 					
 					pthread_rwlock_unlock(&mixEngine->outGrpLock);
 					free(name);
@@ -3225,6 +3245,102 @@ unsigned char handle_outbus(ctl_session *session){
 	return rError;
 }
 
+unsigned char handle_busfeed(ctl_session *session){
+	char *param;
+	uint32_t src, dst;
+	float aFloat;
+	
+	// first parameter, bus to feed from
+	param = strtok_r(NULL, " ", &session->save_pointer);
+	if(param != NULL){
+		src = atoi(param);
+		// second parameter, bus to feed into
+		param = strtok_r(NULL, " ", &session->save_pointer);
+		if(param != NULL){
+			dst = atoi(param);
+			if((src >= mixEngine->busCount) || (dst >= mixEngine->busCount) || (src == dst)){
+				session->errMSG = "Bad bus number.\n";
+				return rError;
+			}
+			// third parameter, gain, zero to remove the feed
+			param = strtok_r(NULL, " ", &session->save_pointer);
+			if(param != NULL){
+				aFloat = atof(param);
+				sendMixCommand(mixEngine, cmd_busFeed, src, dst, aFloat);
+				return rOK;
+			}
+		}
+	}
+	session->errMSG = "Missing parameter.\n";
+	return rError;
+}
+
+unsigned char handle_outdsp(ctl_session *session){
+	char *param, *name;
+	outChannel *instance;
+	uint32_t nameHash;
+	const char *err;
+	int i;
+	
+	param = strtok_r(NULL, " ", &session->save_pointer);
+	if(param && strlen(param)){
+		// first parameter, output name
+		name = strdup(param);
+		nameHash = ELFHash(0, name, strlen(name));
+		instance = mixEngine->outs;
+		pthread_rwlock_wrlock(&mixEngine->outGrpLock);
+		for(i=0; i<mixEngine->outCount; i++){
+			if(instance->name){
+				if((instance->nameHash == nameHash) &&
+										(!strcmp(name, instance->name))){
+					// found the record... the rest of the line is the dsp spec, none to remove it
+					err = setOutputDsp(mixEngine, i, session->save_pointer);
+					
+					pthread_rwlock_unlock(&mixEngine->outGrpLock);
+					free(name);
+					if(err){
+						session->errMSG = "Bad dsp spec or dsp setting failed.\n";
+						return rError;
+					}
+					return rOK;
+				}
+			}
+			instance++;
+		}
+		pthread_rwlock_unlock(&mixEngine->outGrpLock);
+		free(name);
+	}
+	session->errMSG = "Missing or bad output group name.\n";
+	return rError;
+}
+
+unsigned char handle_busdsp(ctl_session *session){
+	char *param;
+	uint32_t bus;
+	const char *err;
+	
+	// first parameter, bus number
+	param = strtok_r(NULL, " ", &session->save_pointer);
+	if(param != NULL){
+		bus = atoi(param);
+		if(bus >= mixEngine->busCount){
+			session->errMSG = "Bad bus number.\n";
+			return rError;
+		}
+		// the rest of the line is the dsp spec, none to remove it
+		pthread_rwlock_wrlock(&mixEngine->outGrpLock);
+		err = setBusDsp(mixEngine, bus, session->save_pointer);
+		pthread_rwlock_unlock(&mixEngine->outGrpLock);
+		if(err){
+			session->errMSG = "Bad dsp spec or dsp setting failed.\n";
+			return rError;
+		}
+		return rOK;
+	}
+	session->errMSG = "Missing parameter.\n";
+	return rError;
+}
+
 unsigned char handle_setdly(ctl_session *session){
 	char *param, *name;
 	outChannel *instance;
@@ -3245,8 +3361,7 @@ unsigned char handle_setdly(ctl_session *session){
 										(!strcmp(name, instance->name))){
 					// found the record... set volume
 					aFloat = atof(session->save_pointer);
-					instance->reqDelay = aFloat;
-					instance->requested = instance->requested | change_delay;
+					setOutputDelay(mixEngine, i, aFloat);
 					
 					pthread_rwlock_unlock(&mixEngine->outGrpLock);
 					free(name);
@@ -3293,8 +3408,7 @@ unsigned char handle_dump(void){
 	pthread_rwlock_wrlock(&mixEngine->outGrpLock);
 	for(i=0; i<mixEngine->outCount; i++){
 		if(instance->name){
-			instance->reqDelay = 0.0;
-			instance->requested = instance->requested | change_delay;
+			setOutputDelay(mixEngine, i, 0.0);
 		}
 		instance++;
 	}
@@ -3334,6 +3448,7 @@ unsigned char handle_delout(ctl_session *session){
 					}
 					pthread_mutex_unlock(&mixEngine->jackMutex);
 					updateOutputConnections(mixEngine, instance, 1, NULL, NULL);
+					setOutputDsp(mixEngine, i, NULL);
 					
 					pthread_rwlock_unlock(&mixEngine->outGrpLock);
 					free(name);
@@ -3741,8 +3856,7 @@ unsigned char handle_cue(ctl_session *session){
 			aLong = 0;
 			instance = &mixEngine->ins[sInt];
 			// loaded:  now put it in cue
-			instance->reqBusses = instance->busses | 2L;
-			instance->requested = instance->requested | change_bus;
+			sendMixCommand(mixEngine, cmd_inBus, sInt, instance->busses | 2L, 0.0);
 									
 			// and return the result info to the client
 			aLong = instance->UID;
@@ -3812,7 +3926,7 @@ unsigned char handle_playnow(ctl_session *session){
 			session->lastUID = newUID;
 			session->lastPlayer = sInt;
 			instance->status = instance->status | status_deleteWhenDone;
-			instance->requested = instance->requested | change_play;
+			sendMixCommand(mixEngine, cmd_inPlay, sInt, 0, 0.0);
 			return rOK;
 		}else{
 			// Not a UID.  Handle as a URL
@@ -3844,7 +3958,7 @@ unsigned char handle_playnow(ctl_session *session){
 				session->lastUID = newUID;
 				session->lastPlayer = sInt;
 				instance->status = instance->status | status_deleteWhenDone;
-				instance->requested = instance->requested | change_play;
+				sendMixCommand(mixEngine, cmd_inPlay, sInt, 0, 0.0);
 				return rOK;
 
 			}else{
@@ -4405,6 +4519,8 @@ unsigned char handle_waitseg(ctl_session *session){
 			}
 		}
 	
+		// may wait indefinitely: don't hold a session worker
+		sessionio_blocking(session);
 		pthread_mutex_lock(&lastsegMutex);
 		while(run){
 			pthread_cond_wait(&lastsegSemaphore, &lastsegMutex );
@@ -4432,6 +4548,7 @@ unsigned char handle_segnow(ctl_session *session){
 		instance = &mixEngine->ins[thisPlayer];
 		if(instance->status & status_standby){
 			instance->fadePos = instance->pos;
+			scheduleInChanEvents(mixEngine, instance, event_fade);
 			return rOK;
 		}
 	}
@@ -4449,6 +4566,7 @@ unsigned char handle_segall(ctl_session *session){
 		if((instance->status & status_playing) && ((instance->status & status_cueing) == 0)){
 			// currently playing and not in cue... fade it!
 			instance->fadePos = instance->pos;
+			scheduleInChanEvents(mixEngine, instance, event_fade);
 		}
 	}	
 	return rOK;
@@ -4477,6 +4595,7 @@ unsigned char handle_fadeprior(ctl_session *session){
 							// currently playing and not in cue... fade it!
 							instance->segNext = 0;
 							instance->fadePos = instance->pos;
+							scheduleInChanEvents(mixEngine, instance, event_segue | event_fade);
 						}
 					}
 				}
@@ -48,8 +48,10 @@ extern "C"
 #define		rNone	2
 
 typedef struct {
-	pthread_t sessionThread;
+	pthread_t sessionThread;	// worker running the session's command, or 0
+	struct sessionConn *conn;	// socket buffers and state: NULL for stdin/out, config and task sessions
 	int cs;						// client socket
+	int extFD;					// while handle_external runs, its socket pair end: my_send sends there. 0 otherwise
 	unsigned char silent;
 	char *save_pointer;
 	char *errMSG;
@@ -65,6 +67,8 @@ typedef struct {
 char *initSessions(unsigned int maxSessions, short *tcpPort);
 void shutdownSessions(void);
 int my_send(ctl_session *session, const char *buf, int tx_length, unsigned char silent, int flags);
+void sessionWelcome(ctl_session *session);
+unsigned char sessionInput(ctl_session *session, char *block);
 unsigned char processCommand(ctl_session *session, char *command, unsigned char *passResult);
 unsigned char loadConfiguration(ctl_session *session, char *file_path);
 int noticeSend(const char *buf, int tx_length, unsigned char isVU);
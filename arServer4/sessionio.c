@@ -0,0 +1,615 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#define _GNU_SOURCE		// needed for accept4()
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+
+#include "sessionio.h"
+#include "dispatch.h"
+#include "data.h"
+#include "mix_engine.h"
+
+#define sessionio_events	64		// epoll events taken per wait
+#define sessionio_keep_out	(64 * 1024)	// output buffer kept allocated once emptied
+
+pthread_mutex_t sMutex;
+ctl_session **sessionList = NULL;
+unsigned int sessionListSize = 0;
+
+static unsigned int sessionMax;
+static int listenFD = -1;
+static int epollFD = -1;
+static int wakeFD = -1;
+static pthread_t loopThread;
+static unsigned char loopRun;
+
+static pthread_mutex_t poolMutex;
+static pthread_cond_t poolSemaphore;	// a job was queued, or the pool is stopping
+static pthread_cond_t poolDone;			// a worker ended
+static sessionConn *jobHead;
+static sessionConn *jobTail;
+static unsigned int jobCount;
+static unsigned int workers;			// in the pool
+static unsigned int idleWorkers;
+static unsigned int blockedWorkers;		// out of the pool, running a blocking command
+static unsigned char poolRun;
+
+static void *sessionio_worker(void *refCon);
+
+/* set the session socket's epoll interest from its state: input only 
+ * while no worker has the session, output while any is buffered.  
+ * conn->lock held. */
+static void sessionio_arm(sessionConn *conn){
+	struct epoll_event ev;
+	
+	ev.events = EPOLLONESHOT;
+	if(!conn->busy && !conn->dead && !conn->eof && (conn->inLen < sizeof(conn->in)))
+		ev.events = ev.events | EPOLLIN;
+	if(!conn->dead && (conn->outLen > conn->outStart))
+		ev.events = ev.events | EPOLLOUT;
+	ev.data.ptr = conn;
+	epoll_ctl(epollFD, EPOLL_CTL_MOD, conn->session->cs, &ev);
+}
+
+/* send as much buffered output as the socket will take now.  conn->lock 
+ * held. */
+static void sessionio_flush(sessionConn *conn){
+	ssize_t n;
+	
+	while(conn->outLen > conn->outStart){
+		n = send(conn->session->cs, conn->out + conn->outStart, conn->outLen - conn->outStart, 
+					MSG_DONTWAIT | MSG_NOSIGNAL);
+		if(n > 0)
+			conn->outStart = conn->outStart + n;
+		else if((n < 0) && (errno == EINTR))
+			continue;
+		else if((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+			return;
+		else{
+			// the hang up has the event loop end the session
+			conn->dead = 1;
+			shutdown(conn->session->cs, SHUT_RDWR);
+			break;
+		}
+	}
+	conn->outStart = 0;
+	conn->outLen = 0;
+	if(conn->outSize > sessionio_keep_out){
+		// a large command result has gone: don't hold on to its buffer
+		free(conn->out);
+		conn->out = NULL;
+		conn->outSize = 0;
+	}
+}
+
+/* add len bytes to the output buffer, unless that would put more than max 
+ * bytes in it, with max non-zero.  Returns zero if not added.  conn->lock 
+ * held. */
+static unsigned char sessionio_queue(sessionConn *conn, const char *buf, size_t len, size_t max){
+	size_t size;
+	char *out;
+	
+	if(max && ((conn->outLen - conn->outStart + len) > max))
+		return 0;
+	if(conn->outStart && ((conn->outLen + len) > conn->outSize)){
+		// reclaim the sent bytes at the front before growing
+		memmove(conn->out, conn->out + conn->outStart, conn->outLen - conn->outStart);
+		conn->outLen = conn->outLen - conn->outStart;
+		conn->outStart = 0;
+	}
+	if((conn->outLen + len) > conn->outSize){
+		size = conn->outSize;
+		if(size == 0)
+			size = 4096;
+		while(size < (conn->outLen + len))
+			size = size * 2;
+		if((out = (char *)realloc(conn->out, size)) == NULL)
+			return 0;
+		conn->out = out;
+		conn->outSize = size;
+	}
+	memcpy(conn->out + conn->outLen, buf, len);
+	conn->outLen = conn->outLen + len;
+	return 1;
+}
+
+int sessionio_send(ctl_session *session, const char *buf, int len){
+	sessionConn *conn = session->conn;
+	struct pollfd pfd;
+	int result;
+	
+	pthread_mutex_lock(&conn->lock);
+	if(!conn->dead && (len > 0) && !sessionio_queue(conn, buf, len, 0))
+		conn->dead = 1;
+	if(!conn->dead)
+		sessionio_flush(conn);
+	if(conn->busy && pthread_equal(session->sessionThread, pthread_self())){
+		// the command's worker waits for a slow client, as it did on a blocking socket
+		while(!conn->dead && ((conn->outLen - conn->outStart) > sessionio_out_max)){
+			pthread_mutex_unlock(&conn->lock);
+			pfd.fd = session->cs;
+			pfd.events = POLLOUT;
+			poll(&pfd, 1, 1000);
+			pthread_mutex_lock(&conn->lock);
+			sessionio_flush(conn);
+		}
+	}
+	result = len;
+	if(conn->dead)
+		result = -1;
+	else if(conn->outLen > conn->outStart)
+		sessionio_arm(conn);
+	pthread_mutex_unlock(&conn->lock);
+	return result;
+}
+
+int sessionio_notice(ctl_session *session, const char *buf, int len){
+	sessionConn *conn = session->conn;
+	int result;
+	
+	pthread_mutex_lock(&conn->lock);
+	result = -1;
+	if(!conn->dead){
+		result = 0;
+		if(sessionio_queue(conn, buf, len, sessionio_notice_max)){
+			result = len;
+			sessionio_flush(conn);
+			if(!conn->dead && (conn->outLen > conn->outStart))
+				sessionio_arm(conn);
+		}
+	}
+	pthread_mutex_unlock(&conn->lock);
+	return result;
+}
+
+unsigned char sessionio_close(unsigned int slot){
+	sessionConn *conn;
+	unsigned char result;
+	
+	result = 0;
+	pthread_mutex_lock(&sMutex);
+	if((slot < sessionListSize) && sessionList[slot]){
+		conn = sessionList[slot]->conn;
+		pthread_mutex_lock(&conn->lock);
+		// the hang up wakes the event loop, or fails the worker's sends
+		conn->dead = 1;
+		shutdown(conn->session->cs, SHUT_RDWR);
+		pthread_mutex_unlock(&conn->lock);
+		result = 1;
+	}
+	pthread_mutex_unlock(&sMutex);
+	return result;
+}
+
+/* start a worker.  poolMutex held. */
+static void sessionio_spawn(void){
+	pthread_attr_t attr;
+	pthread_t thread;
+	
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if(pthread_create(&thread, &attr, &sessionio_worker, NULL) == 0){
+		workers++;
+		idleWorkers++;
+	}
+	pthread_attr_destroy(&attr);
+}
+
+/* hand conn to a worker, starting another if all are busy */
+static void sessionio_queueJob(sessionConn *conn){
+	pthread_mutex_lock(&poolMutex);
+	conn->next = NULL;
+	if(jobTail)
+		jobTail->next = conn;
+	else
+		jobHead = conn;
+	jobTail = conn;
+	jobCount++;
+	if((jobCount > idleWorkers) && (workers < sessionio_workers_max))
+		sessionio_spawn();
+	pthread_cond_signal(&poolSemaphore);
+	pthread_mutex_unlock(&poolMutex);
+}
+
+void sessionio_blocking(ctl_session *session){
+	sessionConn *conn = session->conn;
+	
+	if(!conn || !pthread_equal(session->sessionThread, pthread_self()) || conn->detached)
+		return;
+	// only this worker has the session: the flag needs no lock
+	conn->detached = 1;
+	pthread_mutex_lock(&poolMutex);
+	workers--;
+	blockedWorkers++;
+	if(poolRun && ((jobCount > idleWorkers) || (workers < sessionio_workers)))
+		sessionio_spawn();
+	pthread_mutex_unlock(&poolMutex);
+}
+
+static void sessionio_free(ctl_session *session){
+	sessionConn *conn = session->conn;
+	
+	epoll_ctl(epollFD, EPOLL_CTL_DEL, session->cs, NULL);
+	shutdown(session->cs, SHUT_RDWR);
+	close(session->cs);
+	if(conn->out)
+		free(conn->out);
+	pthread_mutex_destroy(&conn->lock);
+	free(conn);
+	free(session);
+}
+
+/* take a session no worker has out of the list and free it.  Event loop 
+ * thread only. */
+static void sessionio_end(sessionConn *conn){
+	unsigned int i;
+	
+	pthread_mutex_lock(&sMutex);
+	sessionList[conn->slot] = NULL;
+	for(i=0; i<sessionListSize; i++){
+		if(sessionList[i])
+			break;
+	}
+	pthread_mutex_unlock(&sMutex);
+	// with sMutex let go, nothing else can be holding the session
+	sessionio_free(conn->session);
+	
+	if((i == sessionListSize) && GetMetaInt(0, "sys_autoexit", NULL)){
+		// auto exit on loss of last control connection
+		restart = 0;
+		quit = 1;
+	}
+}
+
+static void sessionio_open(int ns, struct sockaddr_in6 *client){
+	ctl_session *session, **list;
+	sessionConn *conn;
+	struct epoll_event ev;
+	unsigned int i, size;
+	int trueval = 1;
+	
+	// keep-alive for broken connection detection: if this fails, not much can be done
+	setsockopt(ns, SOL_SOCKET, SO_KEEPALIVE, &trueval, sizeof(trueval));
+	session = (ctl_session *)calloc(1, sizeof(ctl_session));
+	conn = (sessionConn *)calloc(1, sizeof(sessionConn));
+	pthread_mutex_lock(&sMutex);
+	for(i=0; i<sessionListSize; i++){
+		if(sessionList[i] == NULL)
+			break;
+	}
+	if((i == sessionListSize) && (!sessionMax || (sessionListSize < sessionMax))){
+		// grow the list
+		size = sessionListSize * 2;
+		if(size == 0)
+			size = 32;
+		if(sessionMax && (size > sessionMax))
+			size = sessionMax;
+		if(list = (ctl_session **)realloc(sessionList, size * sizeof(ctl_session *))){
+			memset(list + sessionListSize, 0, (size - sessionListSize) * sizeof(ctl_session *));
+			sessionList = list;
+			sessionListSize = size;
+		}
+	}
+	if(!session || !conn || (i == sessionListSize)){
+		pthread_mutex_unlock(&sMutex);
+		serverLogMakeEntry("[session] sessionio_open-new connections: requests exceed max number of allowed connections");
+		send(ns, "maximum number of connection exceeded. Try again later.\n", 57, MSG_DONTWAIT | MSG_NOSIGNAL);
+		close(ns);
+		if(session)
+			free(session);
+		if(conn)
+			free(conn);
+		return;
+	}
+	session->cs = ns;
+	session->client = *client;
+	session->lastPlayer = -1;
+	session->conn = conn;
+	conn->session = session;
+	conn->slot = i;
+	pthread_mutex_init(&conn->lock, NULL);
+	sessionList[i] = session;
+	pthread_mutex_unlock(&sMutex);
+	
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.ptr = conn;
+	if(epoll_ctl(epollFD, EPOLL_CTL_ADD, ns, &ev) < 0){
+		sessionio_end(conn);
+		return;
+	}
+	sessionWelcome(session);
+}
+
+/* epoll reported events on a session socket: send, read, hand the session 
+ * to a worker once a command line is in, or end it.  Event loop thread 
+ * only. */
+static void sessionio_event(sessionConn *conn, uint32_t events){
+	ctl_session *session = conn->session;
+	ssize_t n;
+	
+	pthread_mutex_lock(&conn->lock);
+	if(events & EPOLLOUT)
+		sessionio_flush(conn);
+	if(events & EPOLLERR)
+		conn->dead = 1;
+	if(!conn->busy && !conn->dead && !conn->eof && (events & (EPOLLIN | EPOLLHUP))){
+		while(conn->inLen < sizeof(conn->in)){
+			n = recv(session->cs, conn->in + conn->inLen, sizeof(conn->in) - conn->inLen, MSG_DONTWAIT);
+			if(n > 0)
+				conn->inLen = conn->inLen + n;
+			else if(n == 0){
+				conn->eof = 1;
+				break;
+			}else if(errno == EINTR)
+				continue;
+			else if((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				break;
+			else{
+				conn->dead = 1;
+				break;
+			}
+		}
+	}
+	if(events & EPOLLHUP)
+		// nothing more will come in, nor can go out
+		conn->dead = 1;
+	if(!conn->busy && !conn->dead && conn->inLen && (conn->eof || (conn->inLen == sizeof(conn->in)) || 
+				memchr(conn->in, '\n', conn->inLen) || memchr(conn->in, '\r', conn->inLen))){
+		conn->busy = 1;
+		pthread_mutex_unlock(&conn->lock);
+		sessionio_queueJob(conn);
+		return;
+	}
+	if(!conn->busy && (conn->dead || (conn->eof && (conn->outLen == conn->outStart)))){
+		pthread_mutex_unlock(&conn->lock);
+		sessionio_end(conn);
+		return;
+	}
+	sessionio_arm(conn);
+	pthread_mutex_unlock(&conn->lock);
+}
+
+/* worker: run the commands in the input a session has read, then give the 
+ * session back to the event loop.  Returns non-zero if the worker left the 
+ * pool for a blocking command. */
+static unsigned char sessionio_run(sessionConn *conn, char *block){
+	ctl_session *session = conn->session;
+	unsigned char end, detached;
+	
+	session->sessionThread = pthread_self();
+	pthread_mutex_lock(&conn->lock);
+	end = 0;
+	while(conn->inLen && !conn->dead && !end){
+		memcpy(block, conn->in, conn->inLen);
+		block[conn->inLen] = 0; // null at end of segment to make it a c-string
+		conn->inLen = 0;
+		pthread_mutex_unlock(&conn->lock);
+		end = sessionInput(session, block);
+		pthread_mutex_lock(&conn->lock);
+	}
+	session->sessionThread = 0;
+	if(end)
+		conn->dead = 1;
+	if(!conn->dead)
+		sessionio_flush(conn);
+	if(conn->dead || (conn->eof && (conn->outLen == conn->outStart)))
+		// done with: the hang up has the event loop end it
+		shutdown(session->cs, SHUT_RDWR);
+	detached = conn->detached;
+	conn->detached = 0;
+	conn->busy = 0;
+	sessionio_arm(conn);
+	pthread_mutex_unlock(&conn->lock);
+	return detached;
+}
+
+static void *sessionio_worker(void *refCon){
+	sessionConn *conn;
+	struct timespec until;
+	char block[sessionio_in_size + 1];
+	
+	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+	
+	pthread_mutex_lock(&poolMutex);
+	while(poolRun){
+		if((conn = jobHead) == NULL){
+			if(workers > sessionio_workers){
+				// an extra worker: end once idle a while
+				clock_gettime(CLOCK_REALTIME, &until);
+				until.tv_sec = until.tv_sec + sessionio_idle_secs;
+				if((pthread_cond_timedwait(&poolSemaphore, &poolMutex, &until) == ETIMEDOUT) && !jobHead)
+					break;
+			}else
+				pthread_cond_wait(&poolSemaphore, &poolMutex);
+			continue;
+		}
+		jobHead = conn->next;
+		if(jobHead == NULL)
+			jobTail = NULL;
+		jobCount--;
+		idleWorkers--;
+		pthread_mutex_unlock(&poolMutex);
+		
+		if(sessionio_run(conn, block)){
+			// out of the pool since its blocking command: done
+			pthread_mutex_lock(&poolMutex);
+			blockedWorkers--;
+			pthread_cond_broadcast(&poolDone);
+			pthread_mutex_unlock(&poolMutex);
+			return NULL;
+		}
+		
+		pthread_mutex_lock(&poolMutex);
+		idleWorkers++;
+	}
+	workers--;
+	idleWorkers--;
+	pthread_cond_broadcast(&poolDone);
+	pthread_mutex_unlock(&poolMutex);
+	return NULL;
+}
+
+static void *sessionio_loop(void *refCon){
+	struct epoll_event events[sessionio_events];
+	struct sockaddr_in6 client;
+	socklen_t namelen;
+	uint64_t count;
+	int i, n, ns;
+	
+	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+	
+	while(loopRun){
+		n = epoll_wait(epollFD, events, sessionio_events, -1);
+		for(i=0; i<n; i++){
+			if(events[i].data.ptr == &wakeFD){
+				if(read(wakeFD, &count, sizeof(count)) < 0){
+					/* nothing to do: loopRun is checked below */
+				}
+			}else if(events[i].data.ptr == &listenFD){
+				// take every pending connection
+				while(1){
+					namelen = sizeof(client);
+					ns = accept4(listenFD, (struct sockaddr *)&client, &namelen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+					if(ns < 0)
+						break;
+					sessionio_open(ns, &client);
+				}
+			}else
+				sessionio_event((sessionConn *)events[i].data.ptr, events[i].events);
+		}
+	}
+	return NULL;
+}
+
+char *sessionio_start(int s, unsigned int maxSessions){
+	struct epoll_event ev;
+	unsigned int i;
+	
+	pthread_mutex_init(&sMutex, NULL);
+	pthread_mutex_init(&poolMutex, NULL);
+	pthread_cond_init(&poolSemaphore, NULL);
+	pthread_cond_init(&poolDone, NULL);
+	sessionMax = maxSessions;
+	sessionList = NULL;
+	sessionListSize = 0;
+	jobHead = NULL;
+	jobTail = NULL;
+	jobCount = 0;
+	workers = 0;
+	idleWorkers = 0;
+	blockedWorkers = 0;
+	poolRun = 1;
+	loopRun = 1;
+	listenFD = s;
+	
+	if((epollFD = epoll_create1(EPOLL_CLOEXEC)) < 0)
+		return "epoll_create1() failed";
+	if((wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0){
+		close(epollFD);
+		return "eventfd() failed";
+	}
+	ev.events = EPOLLIN;
+	ev.data.ptr = &wakeFD;
+	epoll_ctl(epollFD, EPOLL_CTL_ADD, wakeFD, &ev);
+	fcntl(listenFD, F_SETFL, fcntl(listenFD, F_GETFL) | O_NONBLOCK);
+	ev.events = EPOLLIN;
+	ev.data.ptr = &listenFD;
+	if(epoll_ctl(epollFD, EPOLL_CTL_ADD, listenFD, &ev) < 0){
+		close(wakeFD);
+		close(epollFD);
+		return "epoll_ctl() failed to add the listen socket";
+	}
+	
+	// the standing workers
+	pthread_mutex_lock(&poolMutex);
+	for(i=0; i<sessionio_workers; i++)
+		sessionio_spawn();
+	pthread_mutex_unlock(&poolMutex);
+	
+	pthread_create(&loopThread, NULL, &sessionio_loop, NULL);
+	return NULL;
+}
+
+void sessionio_stop(void){
+	sessionConn *conn;
+	unsigned int i;
+	
+	loopRun = 0;
+	signalEventFD(wakeFD);
+	pthread_join(loopThread, NULL);
+	
+	/* closing the sockets fails the sends of any command still running */
+	pthread_mutex_lock(&sMutex);
+	for(i=0; i<sessionListSize; i++){
+		if(sessionList[i]){
+			conn = sessionList[i]->conn;
+			pthread_mutex_lock(&conn->lock);
+			conn->dead = 1;
+			shutdown(sessionList[i]->cs, SHUT_RDWR);
+			pthread_mutex_unlock(&conn->lock);
+		}
+	}
+	pthread_mutex_unlock(&sMutex);
+	// waitseg commands see run is clear once woken
+	pthread_mutex_lock(&lastsegMutex);
+	pthread_cond_broadcast(&lastsegSemaphore);
+	pthread_mutex_unlock(&lastsegMutex);
+	
+	// let the workers finish what they are running, and end
+	pthread_mutex_lock(&poolMutex);
+	poolRun = 0;
+	pthread_cond_broadcast(&poolSemaphore);
+	while(workers || blockedWorkers)
+		pthread_cond_wait(&poolDone, &poolMutex);
+	pthread_mutex_unlock(&poolMutex);
+	
+	pthread_mutex_lock(&sMutex);
+	for(i=0; i<sessionListSize; i++){
+		if(sessionList[i]){
+			sessionio_free(sessionList[i]);
+			sessionList[i] = NULL;
+		}
+	}
+	if(sessionList)
+		free(sessionList);
+	sessionList = NULL;
+	sessionListSize = 0;
+	pthread_mutex_unlock(&sMutex);
+	
+	close(wakeFD);
+	close(epollFD);
+	wakeFD = -1;
+	epollFD = -1;
+	pthread_cond_destroy(&poolSemaphore);
+	pthread_cond_destroy(&poolDone);
+	pthread_mutex_destroy(&poolMutex);
+	pthread_mutex_destroy(&sMutex);
+}
@@ -0,0 +1,103 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _SESSIONIO_H
+#define _SESSIONIO_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "session.h"
+
+/* Control session transport: one event loop thread owns the listening 
+ * socket and every client socket, all nonblocking, on epoll.  It reads 
+ * client input into a per session buffer, and once a whole command line 
+ * is in, hands the session to a pool of worker threads, which run its 
+ * commands with processCommand() as sessionThread() used to.  A session's 
+ * input isn't read while a worker has it, so its commands still run one 
+ * at a time, in order.  Output, command results and notices alike, goes 
+ * through a per session buffer, sent as the socket takes it.  Workers 
+ * start as needed, when all are busy, and the extras end once idle.  A 
+ * command that can wait indefinitely (waitseg, attach, external) takes 
+ * its worker out of the pool first, so it can't hold up other sessions: 
+ * the thread runs that session alone until the command returns, then 
+ * ends. */
+
+#define sessionio_in_size		4096			// client input read ahead of the worker
+#define sessionio_out_max		(1024 * 1024)	// most buffered output before a command's sends wait on the client
+#define sessionio_notice_max	(256 * 1024)	// most buffered output a notice is added to, else it's dropped
+#define sessionio_workers		4				// workers kept for running commands
+#define sessionio_workers_max	64				// most workers at once
+#define sessionio_idle_secs		30				// idle time after which an extra worker ends
+
+typedef struct sessionConn{
+	struct sessionConn *next;	// in the worker job queue
+	ctl_session *session;
+	unsigned int slot;			// index in sessionList
+	pthread_mutex_t lock;		// guards what follows, and the socket's epoll interest
+	unsigned char busy;			// a worker is running the session's commands
+	unsigned char eof;			// client has closed its side: close once its commands have run
+	unsigned char dead;			// socket error, or closed by command: close as soon as no worker has it
+	unsigned char detached;		// worker's: it has left the pool for a blocking command
+	char in[sessionio_in_size];	// input read, not yet taken by a worker
+	size_t inLen;
+	char *out;					// output buffer: bytes outStart to outLen are yet to be taken by the socket
+	size_t outStart;
+	size_t outLen;
+	size_t outSize;
+	char command[4096];			// command line assembled across reads, by the worker
+} sessionConn;
+
+extern pthread_mutex_t sMutex;		// guards sessionList
+extern ctl_session **sessionList;	// session in each slot, NULL if free: slot + 1 is the client number
+extern unsigned int sessionListSize;
+
+/* start the event loop on listening socket s, with at most maxSessions 
+ * sessions at once, or no limit with zero.  Returns an error message, or 
+ * NULL on success */
+char *sessionio_start(int s, unsigned int maxSessions);
+void sessionio_stop(void);
+
+/* queue len bytes of command output and send what the socket will take.  
+ * From a command's worker, waits while the client is far behind.  Returns 
+ * len, or -1 if the session is closing. */
+int sessionio_send(ctl_session *session, const char *buf, int len);
+
+/* as sessionio_send(), but never waits: the notice is dropped if the 
+ * client is too far behind */
+int sessionio_notice(ctl_session *session, const char *buf, int len);
+
+/* From a command's worker, before a wait of unbounded length: the worker 
+ * leaves the pool, which starts another if it is short, and ends once the 
+ * session's commands return.  Does nothing for other sessions. */
+void sessionio_blocking(ctl_session *session);
+
+/* close client number slot + 1: returns zero if there is no such client.  
+ * The session ends once any command it is running returns. */
+unsigned char sessionio_close(unsigned int slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
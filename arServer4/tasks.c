@@ -148,6 +148,8 @@ void ExecuteCommand(void *refIn){
 	session.lastUID = parent->UID;
 	session.lastAID = 0;
 	session.cs = 0;
+	session.conn = NULL;
+	session.extFD = 0;
 	session.silent = 1;
 
 	command =(char*)(parent->userData);
@@ -291,6 +293,8 @@ void loadConfigFromTask(void *refIn){
 	taskRecord *parent = (taskRecord *)refIn;
 
 	session.cs = 0;
+	session.conn = NULL;
+	session.extFD = 0;
 	session.silent = 1;
 	session.lastAID = 0;
 	session.lastPlayer = parent->player;
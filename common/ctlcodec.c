@@ -0,0 +1,141 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "ctlcodec.h"
+
+#define lowBits		0x007f7f7f7f7f7f7fULL	// 7 bytes, top bits clear
+#define keepNext	0xff7f7f7f7f7f7f7fULL	// same, byte 8 passed through
+
+/* Groups are moved as whole 8 byte words while a byte beyond the group is 
+ * still data, so the compiler emits plain loads and stores: the odd 7 byte 
+ * copy goes through the stack and stalls on store forwarding.  Each word 
+ * overlaps the next by a byte, so the next one is loaded before the 
+ * store, for the same reason. */
+
+/* A group of up to 7 bytes as a word, byte n in bits 8n to 8n + 7 */
+static inline uint64_t loadGroup(const void *bytes, unsigned int count){
+	uint64_t word;
+	
+	word = 0;
+	memcpy(&word, bytes, count);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+	return word;
+}
+
+static inline void storeGroup(void *bytes, uint64_t word, unsigned int count){
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+	memcpy(bytes, &word, count);
+}
+
+/* The top bits of the bytes of a group, as bit n for byte n: each one 
+ * lands in a different bit of the top byte of the product, with no carries */
+static inline uint8_t packTopBits(uint64_t word){
+	return (((word >> 7) & 0x0001010101010101ULL) * 0x0102040810204080ULL) >> 56;
+}
+
+/* and back: bit n of bits to the top bit of byte n */
+static inline uint64_t spreadTopBits(uint8_t bits){
+	return ((uint64_t)(bits & 0x7f) * 0x0002040810204080ULL) & 0x0080808080808080ULL;
+}
+
+uint16_t encodeControlPacket(controlPacket *packet, uint16_t size){
+	uint8_t *byte, *extra;
+	uint64_t word, next;
+	uint16_t rem;
+	
+	/* data first: the extra bytes follow it */
+	byte = (uint8_t *)packet->data;
+	extra = byte + size;
+	rem = size;
+	if(rem >= 8){
+		next = loadGroup(byte, 8);
+		do{
+			word = next;
+			if(rem >= 15)
+				next = loadGroup(byte + 7, 8);
+			*extra++ = packTopBits(word);
+			storeGroup(byte, word & keepNext, 8);
+			byte = byte + 7;
+			rem = rem - 7;
+		}while(rem >= 8);
+	}
+	if(rem){
+		word = loadGroup(byte, rem);
+		*extra++ = packTopBits(word);
+		storeGroup(byte, word & lowBits, rem);
+	}
+	*extra = 0xF7;	// MIDI SysEx end flag
+	
+	word = loadGroup(&packet->type, 7);
+	packet->topBits = packTopBits(word);
+	storeGroup(&packet->type, word & lowBits, 7);
+	packet->sysExFlag = 0xF0;	// MIDI SysEx start flag
+	return controlPacketSize(size);
+}
+
+uint16_t makeControlPacket(controlPacket *packet, uint8_t type, uint32_t peer, 
+								const void *data, uint16_t size){
+	packet->type = type;
+	packet->peer = htonl(peer);
+	packet->dataSize = htons(size);
+	if(size)
+		memcpy(packet->data, data, size);
+	return encodeControlPacket(packet, size);
+}
+
+unsigned char decodeControlPacket(controlPacket *packet, char headerOnly){
+	uint8_t *byte, *extra;
+	uint64_t word, next;
+	uint16_t rem, size;
+	
+	if(packet->sysExFlag != 0xF0)
+		// must start with MIDI SysEx flag
+		return 0;
+	word = loadGroup(&packet->type, 7) | spreadTopBits(packet->topBits);
+	storeGroup(&packet->type, word, 7);
+	if(headerOnly || !packet->dataSize)
+		return 1;
+	
+	size = ntohs(packet->dataSize);
+	byte = (uint8_t *)packet->data;
+	extra = byte + size;
+	rem = size;
+	if(rem >= 8){
+		next = loadGroup(byte, 8);
+		do{
+			word = next;
+			if(rem >= 15)
+				next = loadGroup(byte + 7, 8);
+			storeGroup(byte, word | spreadTopBits(*extra++), 8);
+			byte = byte + 7;
+			rem = rem - 7;
+		}while(rem >= 8);
+	}
+	if(rem){
+		word = loadGroup(byte, rem) | spreadTopBits(*extra);
+		storeGroup(byte, word, rem);
+	}
+	return 1;
+}
@@ -0,0 +1,115 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _CTLCODEC_H
+#define _CTLCODEC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+/* Control packet codec, shared by arServer4, arPlayer4 and arRecorder4.  
+ * Packets travel as MIDI SysEx events, so no byte after the 0xF0 start 
+ * flag may have its top bit set.  The top bits of the 7 header bytes from 
+ * type on are carried in topBits, and those of each group of 7 data bytes 
+ * in one extra byte, after the data, followed by the 0xF7 end flag.  
+ * Encoding and decoding are done in place, in the caller's buffer, 7 bytes 
+ * at a time. */
+
+#define ctl_max_packet	2048	// largest encoded packet a peer will take
+
+typedef struct __attribute__((packed)){
+						/* Structure of contol packet: used to control/communicate with recorders and players
+						 * NOTE: packets passed as midi data via jackaudio midi API, even though the data format
+						 * is not midi.  Jack is fine with this, but don't try to connect the arserver control midi
+						 * ports to other applications that are expecting actual midi data. */
+	uint8_t			sysExFlag;
+	uint8_t			topBits;
+	uint8_t			type;
+	uint32_t			peer;		// network byte order - player input number [0,N] or recorder UID.
+	uint16_t			dataSize;	// network byte order - size, in bytes, of the raw data prior to 7 bit endoding, if any.
+	int8_t			data[1];	// network byte order or text.  Text need NOT to be null terminated
+									// due to the size (length) specified above.
+} controlPacket;
+
+/* bytes needed to hold byteCount bytes of data once encoded, not counting 
+ * the end flag */
+static inline uint16_t controlDataSizeFromRaw(uint16_t byteCount){
+	if(byteCount)
+		byteCount += ((byteCount - 1) / 7) + 1;
+	return byteCount;
+}
+
+/* bytes in an encoded packet with dataSize bytes of data, end flag included */
+static inline size_t controlPacketSize(uint16_t dataSize){
+	return sizeof(controlPacket) + controlDataSizeFromRaw(dataSize);
+}
+
+/* Packets carried off the MIDI path (see ctlshm.h) are not encoded: they 
+ * have ctl_raw_flag in place of the SysEx start flag, their data as is, 
+ * and no extra bytes or end flag.  decodeControlPacket() leaves them be. */
+#define ctl_raw_flag	0x00
+
+/* bytes in a raw packet with dataSize bytes of data */
+static inline size_t rawPacketSize(uint16_t dataSize){
+	return offsetof(controlPacket, data) + dataSize;
+}
+
+/* fill in the header of a raw packet with size bytes of data.  peer is in 
+ * host byte order. */
+static inline void rawPacketHeader(controlPacket *header, uint8_t type, uint32_t peer, uint16_t size){
+	header->sysExFlag = ctl_raw_flag;
+	header->topBits = 0;
+	header->type = type;
+	header->peer = htonl(peer);
+	header->dataSize = htons(size);
+}
+
+/* bytes in the packet header points to, raw or encoded, with the header 
+ * of an encoded packet already decoded */
+static inline size_t anyPacketSize(const controlPacket *header){
+	if(header->sysExFlag == ctl_raw_flag)
+		return rawPacketSize(ntohs(header->dataSize));
+	return controlPacketSize(ntohs(header->dataSize));
+}
+
+/* Encode a packet in place: type, peer and dataSize are set, and the size 
+ * bytes of raw data are in packet->data.  The packet must have room for 
+ * controlPacketSize(size) bytes.  Returns the encoded packet size. */
+uint16_t encodeControlPacket(controlPacket *packet, uint16_t size);
+
+/* Copy size bytes of data into packet, with the header, and encode it.  
+ * peer is in host byte order.  Returns the encoded packet size. */
+uint16_t makeControlPacket(controlPacket *packet, uint8_t type, uint32_t peer, 
+								const void *data, uint16_t size);
+
+/* Decode a packet in place: just the header with headerOnly set, so 
+ * dataSize can be read to find the size of the rest of the packet.  
+ * Returns zero if the packet has no SysEx start flag. */
+unsigned char decodeControlPacket(controlPacket *packet, char headerOnly);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
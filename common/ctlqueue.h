@@ -0,0 +1,178 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _CTLQUEUE_H
+#define _CTLQUEUE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include <jack/ringbuffer.h>
+
+#include "ctlcodec.h"
+#include "ctlshm.h"
+
+/* Draining an outbound control queue into a JACK midi port buffer from a 
+ * process callback.  App threads write whole encoded packets to the ring 
+ * buffer; the process callback sends as many as fit in a byte and event 
+ * budget each cycle, rather than one a cycle, so a burst of packets (tags 
+ * to many recorders at a track change) goes out in a cycle or two. */
+
+#define ctl_drain_bytes		8192	// default per cycle byte budget
+#define ctl_drain_events	32		// default per cycle packet budget
+
+typedef struct{
+	uint32_t depth;		// atomic: bytes left queued after the last drain
+	uint32_t high;		// atomic: most bytes found queued at the start of a drain
+	uint32_t sent;		// atomic: packets sent
+	uint32_t deferred;	// atomic: drains that left packets queued
+} ctlQueueStats;
+
+/* Process callback: move packets from queue to midi_buffer, all at frame 
+ * time, until the queue is empty, a budget is used up or the port buffer 
+ * is full.  The first packet is always tried, whatever its size, so a 
+ * packet larger than the byte budget can't stall the queue.  A zero budget 
+ * takes the default.  stats may be NULL.  Returns the packets sent. */
+static inline unsigned int ctlqueue_drain(jack_ringbuffer_t *queue, void *midi_buffer, 
+				jack_nframes_t time, uint32_t byteBudget, uint32_t eventBudget, ctlQueueStats *stats){
+	controlPacket header, *packet;
+	size_t avail, size, bytes;
+	unsigned int events;
+	
+	if(!byteBudget)
+		byteBudget = ctl_drain_bytes;
+	if(!eventBudget)
+		eventBudget = ctl_drain_events;
+	avail = jack_ringbuffer_read_space(queue);
+	if(stats && (avail > stats->high))
+		__atomic_store_n(&stats->high, avail, __ATOMIC_RELAXED);
+	bytes = 0;
+	events = 0;
+	while(events < eventBudget){
+		if(jack_ringbuffer_peek(queue, (char*)&header, sizeof(controlPacket)) != sizeof(controlPacket))
+			break;
+		if(!decodeControlPacket(&header, 1))
+			break;
+		size = controlPacketSize(ntohs(header.dataSize));
+		if(size > avail)
+			break;
+		if(events && ((bytes + size) > byteBudget))
+			break;
+		if(!(packet = (controlPacket *)jack_midi_event_reserve(midi_buffer, time, size)))
+			break;
+		jack_ringbuffer_read(queue, (char*)packet, size);
+		avail = avail - size;
+		bytes = bytes + size;
+		events++;
+	}
+	if(stats){
+		__atomic_store_n(&stats->depth, avail, __ATOMIC_RELAXED);
+		if(events)
+			__atomic_store_n(&stats->sent, stats->sent + events, __ATOMIC_RELAXED);
+		if(avail)
+			__atomic_store_n(&stats->deferred, stats->deferred + 1, __ATOMIC_RELAXED);
+	}
+	return events;
+}
+
+/* Process callback: as ctlqueue_drain(), but for a peer whose control 
+ * goes by shared memory, moving raw packets from queue to ring, within 
+ * the same budgets. */
+static inline unsigned int ctlqueue_drainShm(jack_ringbuffer_t *queue, ctlRing *ring, 
+				uint32_t byteBudget, uint32_t eventBudget, ctlQueueStats *stats){
+	controlPacket header;
+	char chunk[256];
+	size_t avail, size, bytes, off, n;
+	unsigned int events;
+	
+	if(!byteBudget)
+		byteBudget = ctl_drain_bytes;
+	if(!eventBudget)
+		eventBudget = ctl_drain_events;
+	avail = jack_ringbuffer_read_space(queue);
+	if(stats && (avail > stats->high))
+		__atomic_store_n(&stats->high, avail, __ATOMIC_RELAXED);
+	bytes = 0;
+	events = 0;
+	while(events < eventBudget){
+		if(jack_ringbuffer_peek(queue, (char*)&header, offsetof(controlPacket, data)) != offsetof(controlPacket, data))
+			break;
+		if(header.sysExFlag != ctl_raw_flag)
+			break;
+		size = rawPacketSize(ntohs(header.dataSize));
+		if(size > avail)
+			break;
+		if(events && ((bytes + size) > byteBudget))
+			break;
+		if(ctlshm_space(ring) < size)
+			break;
+		for(off=0; off<size; off+=n){
+			n = size - off;
+			if(n > sizeof(chunk))
+				n = sizeof(chunk);
+			jack_ringbuffer_read(queue, chunk, n);
+			ctlshm_fill(ring, off, chunk, n);
+		}
+		ctlshm_commit(ring, size);
+		avail = avail - size;
+		bytes = bytes + size;
+		events++;
+	}
+	if(stats){
+		__atomic_store_n(&stats->depth, avail, __ATOMIC_RELAXED);
+		if(events)
+			__atomic_store_n(&stats->sent, stats->sent + events, __ATOMIC_RELAXED);
+		if(avail)
+			__atomic_store_n(&stats->deferred, stats->deferred + 1, __ATOMIC_RELAXED);
+	}
+	return events;
+}
+
+/* Process callback: move the next packet on ring, of size bytes, to queue, 
+ * whole.  Returns zero, leaving it on the ring, if queue hasn't the room 
+ * now.  A packet queue could never hold is dropped. */
+static inline unsigned char ctlqueue_fromShm(jack_ringbuffer_t *queue, ctlRing *ring, size_t size){
+	char chunk[256];
+	size_t off, n;
+	
+	if(size < queue->size){
+		if(jack_ringbuffer_write_space(queue) < size)
+			return 0;
+		for(off=0; off<size; off+=n){
+			n = size - off;
+			if(n > sizeof(chunk))
+				n = sizeof(chunk);
+			ctlshm_copy(ring, off, chunk, n);
+			jack_ringbuffer_write(queue, chunk, n);
+		}
+	}
+	ctlshm_skip(ring, size);
+	return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
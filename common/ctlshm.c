@@ -0,0 +1,171 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+
+#include "ctlshm.h"
+
+#define ringMask	(ctl_shm_ring - 1)
+
+ctlShm *ctlshm_create(int *fd){
+	ctlShm *shm;
+	
+	if((*fd = memfd_create("arctl", MFD_CLOEXEC)) < 0)
+		return NULL;
+	if(ftruncate(*fd, sizeof(ctlShm)) < 0){
+		close(*fd);
+		*fd = -1;
+		return NULL;
+	}
+	shm = (ctlShm *)mmap(NULL, sizeof(ctlShm), PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+	if(shm == MAP_FAILED){
+		close(*fd);
+		*fd = -1;
+		return NULL;
+	}
+	// render polls and writes the rings: keep them resident
+	mlock(shm, sizeof(ctlShm));
+	// a new memfd reads as zeros: empty rings, not attached
+	shm->magic = ctl_shm_magic;
+	return shm;
+}
+
+int ctlshm_pass(int fd){
+	char num[16];
+	
+	if(fd < 0){
+		unsetenv(ctl_shm_env);
+		return -1;
+	}
+	if(fd != ctl_shm_fd){
+		// the duplicate doesn't have close-on-exec set
+		if(dup2(fd, ctl_shm_fd) < 0){
+			unsetenv(ctl_shm_env);
+			return -1;
+		}
+		close(fd);
+	}else
+		fcntl(fd, F_SETFD, 0);
+	snprintf(num, sizeof num, "%d", ctl_shm_fd);
+	setenv(ctl_shm_env, num, 1);
+	return ctl_shm_fd;
+}
+
+ctlShm *ctlshm_attach(void){
+	struct stat st;
+	ctlShm *shm;
+	char *env;
+	int fd;
+	
+	if(!(env = getenv(ctl_shm_env)))
+		return NULL;
+	fd = atoi(env);
+	// it's ours alone: keep it from anything we in turn run
+	unsetenv(ctl_shm_env);
+	if(fd < 0)
+		return NULL;
+	if(fstat(fd, &st) || (st.st_size < sizeof(ctlShm))){
+		close(fd);
+		return NULL;
+	}
+	shm = (ctlShm *)mmap(NULL, sizeof(ctlShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(shm == MAP_FAILED)
+		return NULL;
+	if(shm->magic != ctl_shm_magic){
+		munmap(shm, sizeof(ctlShm));
+		return NULL;
+	}
+	mlock(shm, sizeof(ctlShm));
+	__atomic_store_n(&shm->attached, 1, __ATOMIC_RELEASE);
+	return shm;
+}
+
+void ctlshm_free(ctlShm *shm){
+	if(shm){
+		munlock(shm, sizeof(ctlShm));
+		munmap(shm, sizeof(ctlShm));
+	}
+}
+
+size_t ctlshm_space(ctlRing *ring){
+	return ctl_shm_ring - (ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+}
+
+void ctlshm_fill(ctlRing *ring, size_t offset, const void *src, size_t count){
+	uint32_t at, first;
+	
+	at = (ring->head + offset) & ringMask;
+	first = ctl_shm_ring - at;
+	if(first > count)
+		first = count;
+	memcpy(ring->data + at, src, first);
+	memcpy(ring->data, (const uint8_t *)src + first, count - first);
+}
+
+void ctlshm_commit(ctlRing *ring, size_t size){
+	__atomic_store_n(&ring->head, ring->head + size, __ATOMIC_RELEASE);
+}
+
+unsigned char ctlshm_write(ctlRing *ring, uint8_t type, uint32_t peer, 
+								const void *data, uint16_t size){
+	controlPacket header;
+	size_t hsize;
+	
+	hsize = offsetof(controlPacket, data);
+	if(ctlshm_space(ring) < (hsize + size))
+		return 0;
+	rawPacketHeader(&header, type, peer, size);
+	ctlshm_fill(ring, 0, &header, hsize);
+	if(size)
+		ctlshm_fill(ring, hsize, data, size);
+	ctlshm_commit(ring, hsize + size);
+	return 1;
+}
+
+size_t ctlshm_next(ctlRing *ring){
+	controlPacket header;
+	
+	if((__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail) < offsetof(controlPacket, data))
+		return 0;
+	ctlshm_copy(ring, 0, &header, offsetof(controlPacket, data));
+	return rawPacketSize(ntohs(header.dataSize));
+}
+
+void ctlshm_copy(ctlRing *ring, size_t offset, void *dst, size_t count){
+	uint32_t at, first;
+	
+	at = (ring->tail + offset) & ringMask;
+	first = ctl_shm_ring - at;
+	if(first > count)
+		first = count;
+	memcpy(dst, ring->data + at, first);
+	memcpy((uint8_t *)dst + first, ring->data, count - first);
+}
+
+void ctlshm_skip(ctlRing *ring, size_t size){
+	__atomic_store_n(&ring->tail, ring->tail + size, __ATOMIC_RELEASE);
+}
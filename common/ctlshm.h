@@ -0,0 +1,109 @@
+/*
+ Copyright (c) 2026 Ethan Funk
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all copies or substantial portions
+ of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef _CTLSHM_H
+#define _CTLSHM_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ctlcodec.h"
+
+/* Shared memory control channel between arServer4 and a player it 
+ * launches, in place of the JACK MIDI control ports.  The server makes a 
+ * memfd holding a pair of single producer, single consumer rings, one 
+ * each way, and passes it to the player on ctl_shm_fd, named in the 
+ * ctl_shm_env environment variable.  The player sets attached once it has 
+ * the channel mapped; until then, or with a player that doesn't look for 
+ * one, the server keeps to MIDI.  Packets are raw (see ctl_raw_flag), so 
+ * there is no encoding, and data can run to the full 64K dataSize allows.  
+ * Neither side waits on the other: each polls its incoming ring once a 
+ * JACK cycle. */
+
+#define ctl_shm_env		"AR_CTL_SHM"
+#define ctl_shm_fd		3
+#define ctl_shm_ring	(128 * 1024)	// bytes in each ring: a power of two, over the largest packet
+#define ctl_shm_magic	0x61724331		// "arC1"
+
+typedef struct{
+	uint32_t head;		// atomic: bytes ever put on the ring, written by the producer
+	uint8_t pad0[60];
+	uint32_t tail;		// atomic: bytes ever taken off the ring, written by the consumer
+	uint8_t pad1[60];
+	uint8_t data[ctl_shm_ring];
+} ctlRing;
+
+typedef struct{
+	uint32_t magic;
+	uint32_t attached;	// atomic: set by the peer once it has the channel mapped
+	uint8_t pad[56];
+	ctlRing toPeer;
+	ctlRing toServer;
+} ctlShm;
+
+/* Server: make a channel.  Returns the mapping, with its memfd in *fd, or 
+ * NULL on failure. */
+ctlShm *ctlshm_create(int *fd);
+
+/* Server, in a forked child before exec: pass the channel fd on as 
+ * ctl_shm_fd, kept open over exec, and name it in the environment.  With 
+ * fd < 0, the environment names no channel.  Returns the fd to keep open, 
+ * or -1. */
+int ctlshm_pass(int fd);
+
+/* Peer: map the channel the server passed, if any, and mark it attached.  
+ * Returns NULL if there is none, or it won't map. */
+ctlShm *ctlshm_attach(void);
+
+void ctlshm_free(ctlShm *shm);
+
+static inline unsigned char ctlshm_attached(ctlShm *shm){
+	return shm && __atomic_load_n(&shm->attached, __ATOMIC_ACQUIRE);
+}
+
+/* Producer: bytes free in the ring */
+size_t ctlshm_space(ctlRing *ring);
+
+/* Producer: copy count bytes to offset bytes into the space, then, with 
+ * ctlshm_commit(), make size bytes of it, whole packets, visible */
+void ctlshm_fill(ctlRing *ring, size_t offset, const void *src, size_t count);
+void ctlshm_commit(ctlRing *ring, size_t size);
+
+/* Producer: put a raw packet of size bytes of data on the ring.  peer is 
+ * in host byte order.  Returns zero if there isn't room. */
+unsigned char ctlshm_write(ctlRing *ring, uint8_t type, uint32_t peer, 
+								const void *data, uint16_t size);
+
+/* Consumer: the size of the next packet on the ring, or zero if empty */
+size_t ctlshm_next(ctlRing *ring);
+
+/* Consumer: copy count bytes of the next packet, from offset bytes in, 
+ * leaving it on the ring; then ctlshm_skip() it, by its size */
+void ctlshm_copy(ctlRing *ring, size_t offset, void *dst, size_t count);
+void ctlshm_skip(ctlRing *ring, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif